@@ -0,0 +1 @@
+tcc -DTERM_HEADLESS bench_main.c src/*.c lib/user32.def -run > bench_output.txt
\ No newline at end of file
@@ -0,0 +1,4 @@
+#!/bin/sh
+# 基准测试: ./bench.sh [负载名|all] [帧数] [folded 输出文件], 结果为 CSV, 同时写入 bench_output.txt
+# 保留帧指针, 以便采样分析得到完整调用栈
+cc -std=gnu99 -O2 -fno-omit-frame-pointer -pthread -DTERM_HEADLESS bench_main.c src/*.c -o bench_main && ./bench_main "$@" | tee bench_output.txt
@@ -0,0 +1,355 @@
+#include "src/microui.h"
+#include "src/ui_renderer.h"
+#include "src/timer.h"
+#include "src/prof.h"
+#include "src/table_view.h"
+#include "src/replay.h"
+
+#ifndef TERM_HEADLESS
+#error "bench 需要无头终端后端: 用 -DTERM_HEADLESS 编译"
+#endif
+
+/* 合成负载基准: 分阶段统计每帧耗时和输出字节数, 结果为 CSV, 便于跨版本比较.
+ * 用法: bench_main [负载名|all] [帧数] [folded 输出文件]; 给出第三个参数时同时开启采样分析.
+ * 环境变量 BENCH_REPLAY=录制文件 时, 负载的输入取自录制(见 replay.h), 每帧喂入同一时刻的一批事件, 放完从头再来;
+ * BENCH_CULL=1 时开启遮挡剔除(默认关闭) */
+
+#define BENCH_W       200
+#define BENCH_H       60
+#define BENCH_WARMUP  20
+#define BENCH_FRAMES  200
+
+static char g_logbuf[160000];
+
+/* ---------- 负载 ---------- */
+static void wl_windows(mu_Context *ctx, int frame) {
+    static int checks[30];
+    char name[32];
+    for (int i = 0; i < 30; i++) {
+        sprintf(name, "win %d", i);
+        if (mu_begin_window(ctx, name, mu_rect((i % 6) * 32, (i / 6) * 11, 34, 12))) {
+            mu_layout_row(ctx, 2, (int[]){12, -1}, 0);
+            mu_label(ctx, "frame:");
+            sprintf(name, "%d", frame + i);
+            mu_label(ctx, name);
+            mu_button(ctx, "Apply");
+            mu_button(ctx, "Cancel");
+            mu_layout_row(ctx, 1, (int[]){-1}, 0);
+            mu_checkbox(ctx, "enabled", &checks[i]);
+            mu_label(ctx, "some static descriptive text");
+            mu_end_window(ctx);
+        }
+    }
+}
+
+/* 仪表盘: 同样 30 个窗口, 但每帧只有一个窗口的内容变化 */
+static void wl_dashboard(mu_Context *ctx, int frame) {
+    static int checks[30];
+    char name[32];
+    for (int i = 0; i < 30; i++) {
+        sprintf(name, "dash %d", i);
+        if (mu_begin_window(ctx, name, mu_rect((i % 6) * 32, (i / 6) * 11, 34, 12))) {
+            mu_layout_row(ctx, 2, (int[]){12, -1}, 0);
+            mu_label(ctx, "updated:");
+            sprintf(name, "%d", (frame % 30 == i) ? frame : 0);
+            mu_label(ctx, name);
+            mu_button(ctx, "Apply");
+            mu_button(ctx, "Cancel");
+            mu_layout_row(ctx, 1, (int[]){-1}, 0);
+            mu_checkbox(ctx, "enabled", &checks[i]);
+            mu_label(ctx, "some static descriptive text");
+            mu_end_window(ctx);
+        }
+    }
+}
+
+static void tree(mu_Context *ctx, int depth) {
+    char name[32];
+    for (int i = 0; i < 3; i++) {
+        sprintf(name, "node %d.%d", depth, i);
+        if (depth < 5 && mu_begin_treenode_ex(ctx, name, MU_OPT_EXPANDED)) {
+            mu_label(ctx, "leaf label");
+            tree(ctx, depth + 1);
+            mu_end_treenode(ctx);
+        }
+    }
+}
+
+static void wl_tree(mu_Context *ctx, int frame) {
+    (void)frame;
+    if (mu_begin_window_ex(ctx, "tree", mu_rect(0, 0, BENCH_W, BENCH_H), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        tree(ctx, 0);
+        mu_end_window(ctx);
+    }
+}
+
+static void wl_log(mu_Context *ctx, int frame) {
+    (void)frame;
+    if (!g_logbuf[0]) {
+        char *p = g_logbuf;
+        for (int i = 0; i < 3000; i++) p += sprintf(p, "%s[%05d] worker %d: processed request in %d us", i ? "\n" : "", i, i % 7, i * 37 % 1000);
+    }
+    mu_get_container(ctx, "log")->scroll.y = 2900;
+    if (mu_begin_window_ex(ctx, "log", mu_rect(0, 0, BENCH_W, BENCH_H), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        mu_text(ctx, g_logbuf);
+        mu_end_window(ctx);
+    }
+}
+
+static void wl_color_churn(mu_Context *ctx, int frame) {
+    int opt = MU_OPT_NOFRAME | MU_OPT_NOTITLE | MU_OPT_NOSCROLL | MU_OPT_NORESIZE;
+    if (mu_begin_window_ex(ctx, "churn", mu_rect(0, 0, BENCH_W, BENCH_H), opt)) {
+        for (int y = 0; y < BENCH_H; y++)
+        for (int x = 0; x < BENCH_W; x += 4) {
+            int v = (x + y * 3 + frame * 7) & 0xFF;
+            mu_draw_rect(ctx, mu_rect(x, y, 4, 1), mu_color(v, 255 - v, (v * 3) & 0xFF, 0));
+        }
+        mu_end_window(ctx);
+    }
+}
+
+static void wl_scroll(mu_Context *ctx, int frame) {
+    char buf[64];
+    mu_get_container(ctx, "scroll")->scroll.y = frame % 400;
+    if (mu_begin_window_ex(ctx, "scroll", mu_rect(0, 0, BENCH_W, BENCH_H), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 3, (int[]){10, 60, -1}, 0);
+        for (int i = 0; i < 500; i++) {
+            sprintf(buf, "%d", i);
+            mu_label(ctx, buf);
+            sprintf(buf, "row %d: value=%d", i, i * 31 % 977);
+            mu_label(ctx, buf);
+            mu_label(ctx, "status ok");
+        }
+        mu_end_window(ctx);
+    }
+}
+
+/* 10 万行的列表, 只有可见行执行控件代码 */
+static void wl_biglist(mu_Context *ctx, int frame) {
+    char buf[64];
+    mu_get_container(ctx, "biglist")->scroll.y = frame * 97 % 99000;
+    if (mu_begin_window_ex(ctx, "biglist", mu_rect(0, 0, BENCH_W, BENCH_H), MU_OPT_NOCLOSE)) {
+        mu_ListClipper lc;
+        mu_layout_row(ctx, 3, (int[]){10, 60, -1}, 0);
+        mu_layout_begin_list(ctx, &lc, 100000, 0);
+        for (int i = lc.start; i < lc.end; i++) {
+            sprintf(buf, "%d", i);
+            mu_label(ctx, buf);
+            sprintf(buf, "row %d: value=%d", i, i * 31 % 977);
+            mu_label(ctx, buf);
+            mu_label(ctx, "status ok");
+        }
+        mu_layout_end_list(ctx, &lc);
+        mu_end_window(ctx);
+    }
+}
+
+/* 100 万行 x 50 列的表格, 横纵同时滚动 */
+static const char *table_cell(void *user, int row, int col, char *buf, int cap) {
+    (void)user;
+    snprintf(buf, cap, "%d:%d", row, row * 31 % 977 + col);
+    return buf;
+}
+
+static void wl_table(mu_Context *ctx, int frame) {
+    static table_view_t *tv;
+    if (!tv) tv = tv_new(50, 10);
+    tv_scroll_to(tv, frame * 97 % 999000, frame % 45);
+    if (mu_begin_window_ex(ctx, "table", mu_rect(0, 0, BENCH_W, BENCH_H), MU_OPT_NOCLOSE)) {
+        tv_draw(ctx, "grid", tv, 1000000, table_cell, NULL);
+        mu_end_window(ctx);
+    }
+}
+
+/* 层叠窗口: 下层窗口大部分被上层盖住, 最底下几个完全看不见; 每帧顶层窗口内容变化 */
+static void wl_stacked(mu_Context *ctx, int frame) {
+    char name[32];
+    for (int i = 0; i < 16; i++) {
+        sprintf(name, "stack %d", i);
+        mu_Rect r = i < 4 ? mu_rect(40 + i * 4, 10 + i * 2, 60, 20) : mu_rect((i - 4) * 3, i - 4, 160, 46);
+        if (mu_begin_window_ex(ctx, name, r, MU_OPT_NOCLOSE)) {
+            mu_layout_row(ctx, 4, (int[]){30, 30, 30, -1}, 0);
+            for (int k = 0; k < 160; k++) {
+                sprintf(name, "item %d", k + (i == 15 ? frame : 0));
+                mu_label(ctx, name);
+            }
+            mu_end_window(ctx);
+        }
+    }
+}
+
+/* 300 个小面板各有 12 个按钮, 鼠标每两帧移到别处(悬停窗口要一帧才定下):
+ * 每帧都要判定悬停. 输入在帧内给出, 下一帧生效 */
+static void wl_hover(mu_Context *ctx, int frame) {
+    char name[32];
+    mu_input_mousemove(ctx, frame / 2 * 7 % BENCH_W, frame / 2 * 3 % BENCH_H);
+    for (int i = 0; i < 300; i++) {
+        sprintf(name, "panel %d", i);
+        if (mu_begin_window_ex(ctx, name, mu_rect(i % 20 * 10, i / 20 * 4, 10, 4), MU_OPT_NOTITLE | MU_OPT_NORESIZE)) {
+            mu_layout_row(ctx, 4, (int[]){2, 2, 2, -1}, 0);
+            for (int k = 0; k < 12; k++) {
+                sprintf(name, "%d", k);
+                mu_button(ctx, name);
+            }
+            mu_end_window(ctx);
+        }
+    }
+}
+
+typedef struct { const char *name; void (*frame)(mu_Context *ctx, int frame); } Workload;
+
+static const Workload g_workloads[] = {
+    { "windows",     wl_windows     },
+    { "dashboard",   wl_dashboard   },
+    { "tree",        wl_tree        },
+    { "log",         wl_log         },
+    { "color_churn", wl_color_churn },
+    { "scroll",      wl_scroll      },
+    { "biglist",     wl_biglist     },
+    { "table",       wl_table       },
+    { "stacked",     wl_stacked     },
+    { "hover",       wl_hover       },
+};
+
+/* ---------- 录制的输入 ---------- */
+static const char *g_replay_path;
+static replay_t *g_replay;
+
+static void bench_input(mu_Context *ctx, const TermEvent *e) {
+    static const int keys[][2] = {
+        { TERM_KEY_BACK, MU_KEY_BACKSPACE }, { TERM_KEY_RETURN, MU_KEY_RETURN }, { TERM_KEY_DELETE, MU_KEY_DELETE },
+        { TERM_KEY_LEFT, MU_KEY_LEFT }, { TERM_KEY_RIGHT, MU_KEY_RIGHT }, { TERM_KEY_UP, MU_KEY_UP },
+        { TERM_KEY_DOWN, MU_KEY_DOWN }, { TERM_KEY_HOME, MU_KEY_HOME }, { TERM_KEY_END, MU_KEY_END },
+        { TERM_KEY_PRIOR, MU_KEY_PAGEUP }, { TERM_KEY_NEXT, MU_KEY_PAGEDOWN },
+    };
+    if (e->type == TERM_EV_KEY) {
+        for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+            if (keys[i][0] != e->u.key.key_code) continue;
+            if (e->u.key.pressed) mu_input_keydown(ctx, keys[i][1]);
+            else                  mu_input_keyup(ctx, keys[i][1]);
+            return;
+        }
+        if (e->u.key.pressed && (unsigned char)e->u.key.utf8[0] >= 0x20) mu_input_text(ctx, e->u.key.utf8);
+    } else if (e->type == TERM_EV_MOUSE) {
+        const TermMouseEvent *m = &e->u.mouse;
+        switch (m->type) {
+            case TERM_MOUSE_MOVE: mu_input_mousemove(ctx, m->x, m->y); break;
+            case TERM_MOUSE_LEFT_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_LEFT); break;
+            case TERM_MOUSE_RIGHT_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_RIGHT); break;
+            case TERM_MOUSE_MIDDLE_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_MIDDLE); break;
+            case TERM_MOUSE_LEFT_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_LEFT); break;
+            case TERM_MOUSE_RIGHT_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_RIGHT); break;
+            case TERM_MOUSE_MIDDLE_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_MIDDLE); break;
+            case TERM_MOUSE_WHEEL: mu_input_scroll(ctx, 0, -m->wheel); break;
+            default: break;
+        }
+    }
+}
+
+/* 虚拟时钟拨到下一个事件, 喂入该时刻到期的全部事件 */
+static void bench_replay_feed(mu_Context *ctx) {
+    if (!g_replay) return;
+    if (!replay_wait(g_replay)) {
+        replay_close(g_replay);
+        g_replay = replay_open(g_replay_path, REPLAY_FAST);
+        if (!g_replay || !replay_wait(g_replay)) return;
+    }
+    for (TermEvent e; (e = replay_poll(g_replay)).type != TERM_EV_NONE; ) bench_input(ctx, &e);
+}
+
+/* ---------- 运行 ---------- */
+typedef struct { long long layout, raster, present, to_string, bytes, writes; } Sample;
+
+static Sample run_frame(mu_Context *ctx, ui_renderer_t *ur, const Workload *wl, int frame) {
+    Sample s;
+    bench_replay_feed(ctx);
+    TermIoStats io0 = term_headless_stats();
+    long long t0 = timer_ns();
+    mu_begin(ctx);
+    wl->frame(ctx, frame);
+    mu_end(ctx);
+    long long t1 = timer_ns();
+    /* 命令流与上一帧相同时跳过光栅化和输出, 与真实主循环一致 */
+    int changed = mu_frame_changed(ctx);
+    if (changed) {
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        ur_draw_commands(ur, ctx);
+    }
+    long long t2 = timer_ns();
+    if (changed) ur_present(ur);
+    long long t3 = timer_ns();
+    free(renderer_to_string(ur_get_renderer(ur)));
+    long long t4 = timer_ns();
+    TermIoStats io1 = term_headless_stats();
+
+    s.layout    = t1 - t0;
+    s.raster    = t2 - t1;
+    s.present   = t3 - t2;
+    s.to_string = t4 - t3;
+    s.bytes     = io1.bytes - io0.bytes;
+    s.writes    = io1.writes - io0.writes;
+    return s;
+}
+
+static void run_workload(const Workload *wl, int frames) {
+    mu_Context *ctx = malloc(sizeof(mu_Context));
+    mu_init_ex(ctx, &(mu_Config){ .cull = getenv("BENCH_CULL") != NULL });
+    ctx->text_width = r_text_width;
+    ctx->text_height = r_text_height;
+    if (getenv("BENCH_TEXT")) {
+        /* 对照: 文本以原始字节下发, 光栅化时再解码 */
+    } else {
+        ctx->text_glyphs = r_text_glyphs;
+        ctx->glyph_size = sizeof(utf8_t);
+    }
+    ctx->viewport = mu_rect(0, 0, BENCH_W, BENCH_H);
+    ui_renderer_t *ur = ur_new_term();
+    if (g_replay_path && !(g_replay = replay_open(g_replay_path, REPLAY_FAST)))
+        fprintf(stderr, "%s: not a recording\n", g_replay_path);
+
+    Sample sum = {0};
+    for (int i = 0; i < BENCH_WARMUP + frames; i++) {
+        Sample s = run_frame(ctx, ur, wl, i);
+        if (i < BENCH_WARMUP) continue;
+        sum.layout += s.layout; sum.raster += s.raster; sum.present += s.present;
+        sum.to_string += s.to_string; sum.bytes += s.bytes; sum.writes += s.writes;
+    }
+    printf("%s,%s,%d,%lld,%lld,%lld,%lld,%lld,%.2f\n", MU_VERSION, wl->name, frames,
+        sum.layout / frames, sum.raster / frames, sum.present / frames,
+        sum.to_string / frames, sum.bytes / frames, (double)sum.writes / frames);
+    fflush(stdout);
+    replay_close(g_replay);
+    g_replay = NULL;
+    ur_free(ur);
+    mu_release(ctx);
+    free(ctx);
+}
+
+int main(int argc, char **argv) {
+    int frames = (argc > 2) ? atoi(argv[2]) : BENCH_FRAMES;
+    const char *prof_path = (argc > 3) ? argv[3] : NULL;
+    term_headless_resize(BENCH_W, BENCH_H);
+    term_init();
+    term_headless_discard(1);
+    g_replay_path = getenv("BENCH_REPLAY");
+    if (prof_path && prof_start(0, 0)) {
+        fprintf(stderr, "profiler not available on this platform\n");
+        prof_path = NULL;
+    }
+
+    printf("version,workload,frames,layout_ns,raster_ns,present_ns,to_string_ns,bytes_per_frame,writes_per_frame\n");
+    for (size_t i = 0; i < sizeof(g_workloads) / sizeof(g_workloads[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], "all") && !strstr(g_workloads[i].name, argv[1])) continue;
+        run_workload(&g_workloads[i], frames);
+    }
+    if (prof_path) {
+        prof_stop();
+        FILE *fp = fopen(prof_path, "w");
+        if (fp) { prof_dump(fp); fclose(fp); }
+        fprintf(stderr, "%d samples (%d lost) -> %s\n", prof_samples(), prof_lost(), prof_path);
+    }
+    term_shutdown();
+    return 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+# Linux 无头测试: 终端后端换成内存 VT 模拟器(TERM_HEADLESS), 只编译不依赖 Win32 控制台的测试
+# 参数透传给测试程序: 默认跑全部测试, 不跑基准; 如 ./run_headless.sh bench. 只跑基准
+cc -std=gnu99 -O2 -fno-omit-frame-pointer -pthread -DTERM_HEADLESS test_main.c src/*.c test/test_vt.c test/test_headless.c test/test_stats.c \
+    test/test_utf8.c test/test_renderer.c test/test_log.c test/test_prof.c test/test_file_view.c test/test_log_view.c test/test_table_view.c \
+    test/test_text_edit.c test/test_workers.c test/test_session.c test/test_replay.c -o test_headless || exit 1
+if [ $# -eq 0 ]; then set -- -bench.; fi
+./test_headless "$@"
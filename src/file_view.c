@@ -0,0 +1,262 @@
+#include "file_view.h"
+#include "thread.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define FV_CHUNK       65536            /* 每段索引的条目数 */
+#define FV_MAX_CHUNKS  4096             /* 最多 2^28 个块, 即 2^33 行 */
+#define FV_BATCH       (1 << 20)        /* 每批扫描的字节数, 批间发布进度 */
+
+struct file_view_t {
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    int fd;
+#endif
+    /* map/map_size 只由索引线程替换, 替换时持锁; 索引线程自己读时不必加锁 */
+    const char *map;
+    long long map_size;
+    /* chunks[b / FV_CHUNK][b % FV_CHUNK] 为第 b*FV_BLOCK_LINES 行的起点.
+     * 条目在发布计数之前写好, 读者持锁读计数后即可看到 */
+    long long *chunks[FV_MAX_CHUNKS];
+    /* 以下由 lock 保护 */
+    mutex_t lock;
+    int full;                   /* 索引已达上限, 之后的内容不再扫描 */
+    long long newlines;         /* 已扫描到的换行数 */
+    long long tail;             /* 最后一个换行之后的偏移, 即最后一行的起点 */
+    long long scanned;          /* 已扫描字节数 */
+    long long goto_line;        /* -1 表示没有待处理的跳转 */
+    volatile atom_t stop;
+    thread_t thread;
+};
+
+/* ---------- 平台相关: 文件大小与映射 ---------- */
+#ifdef _WIN32
+static long long fv_file_size(file_view_t *fv) {
+    LARGE_INTEGER li;
+    return GetFileSizeEx(fv->file, &li) ? (long long)li.QuadPart : -1;
+}
+
+/* 按 size 重新映射, 调用者持锁 */
+static void fv_remap(file_view_t *fv, long long size) {
+    if (fv->map) UnmapViewOfFile(fv->map);
+    if (fv->mapping) CloseHandle(fv->mapping);
+    fv->map = NULL;
+    fv->mapping = NULL;
+    fv->map_size = 0;
+    if (size <= 0 || (unsigned long long)size > (size_t)-1) return;
+    fv->mapping = CreateFileMappingA(fv->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!fv->mapping) return;
+    fv->map = (const char *)MapViewOfFile(fv->mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+    if (fv->map) fv->map_size = size;
+}
+
+static int fv_open_file(file_view_t *fv, const char *path) {
+    fv->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    return fv->file == INVALID_HANDLE_VALUE ? -1 : 0;
+}
+
+static void fv_close_file(file_view_t *fv) { CloseHandle(fv->file); }
+#else
+static long long fv_file_size(file_view_t *fv) {
+    struct stat st;
+    return fstat(fv->fd, &st) == 0 ? (long long)st.st_size : -1;
+}
+
+static void fv_remap(file_view_t *fv, long long size) {
+    if (fv->map) munmap((void *)fv->map, (size_t)fv->map_size);
+    fv->map = NULL;
+    fv->map_size = 0;
+    if (size <= 0 || (unsigned long long)size > (size_t)-1) return;
+    void *p = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fv->fd, 0);
+    if (p == MAP_FAILED) return;
+    madvise(p, (size_t)size, MADV_SEQUENTIAL);
+    fv->map = (const char *)p;
+    fv->map_size = size;
+}
+
+static int fv_open_file(file_view_t *fv, const char *path) {
+    fv->fd = open(path, O_RDONLY);
+    return fv->fd < 0 ? -1 : 0;
+}
+
+static void fv_close_file(file_view_t *fv) { close(fv->fd); }
+#endif
+
+/* ---------- 索引 ---------- */
+static int fv_set_block(file_view_t *fv, long long b, long long off) {
+    long long c = b / FV_CHUNK;
+    if (c >= FV_MAX_CHUNKS) return -1;
+    if (!fv->chunks[c] && !(fv->chunks[c] = (long long *)malloc(FV_CHUNK * sizeof(long long)))) return -1;
+    fv->chunks[c][b % FV_CHUNK] = off;
+    return 0;
+}
+
+/* 扫描 [from, to), 返回实际扫描到的位置; 索引存不下时置 *full 并停在那一行之前.
+ * 换行查找交给 memchr, 主流 libc 里它按 SIMD 宽度比较 */
+static long long fv_scan(file_view_t *fv, long long from, long long to, long long *newlines, long long *tail, int *full) {
+    const char *map = fv->map, *p = map + from, *end = map + to;
+    long long n = *newlines;
+    while ((p = (const char *)memchr(p, '\n', end - p)) != NULL) {
+        p++;
+        n++;
+        if (n % FV_BLOCK_LINES == 0 && fv_set_block(fv, n / FV_BLOCK_LINES, p - map)) {
+            *full = 1;
+            n--;
+            to = p - 1 - map;
+            break;
+        }
+        *tail = p - map;
+    }
+    *newlines = n;
+    return to;
+}
+
+static void fv_thread(void *arg) {
+    file_view_t *fv = (file_view_t *)arg;
+    long long newlines = 0, tail = 0, scanned = 0;
+    int full = 0;
+    while (!atom_load(&fv->stop)) {
+        if (scanned < fv->map_size && !full) {
+            long long to = scanned + FV_BATCH < fv->map_size ? scanned + FV_BATCH : fv->map_size;
+            scanned = fv_scan(fv, scanned, to, &newlines, &tail, &full);
+            mutex_lock(&fv->lock);
+            fv->full = full;
+            fv->newlines = newlines;
+            fv->tail = tail;
+            fv->scanned = scanned;
+            mutex_unlock(&fv->lock);
+            continue;
+        }
+        thread_sleep_ms(FV_POLL_MS);
+        long long size = fv_file_size(fv);
+        if (size < 0 || size == fv->map_size) continue;
+        mutex_lock(&fv->lock);
+        if (size < scanned) {   /* 文件被截断: 从头重建 */
+            newlines = tail = scanned = 0;
+            fv->newlines = fv->tail = fv->scanned = 0;
+            fv->full = full = 0;
+        }
+        fv_remap(fv, size);
+        mutex_unlock(&fv->lock);
+    }
+}
+
+/* ---------- 接口 ---------- */
+file_view_t *fv_open(const char *path) {
+    file_view_t *fv = (file_view_t *)calloc(1, sizeof(*fv));
+    if (!fv) return NULL;
+    if (fv_open_file(fv, path)) { free(fv); return NULL; }
+    fv->goto_line = -1;
+    fv_set_block(fv, 0, 0);
+    mutex_init(&fv->lock);
+    long long size = fv_file_size(fv);
+    fv_remap(fv, size);
+    if (!fv->chunks[0] || thread_create(&fv->thread, fv_thread, fv)) {
+        fv_remap(fv, 0);
+        fv_close_file(fv);
+        mutex_destroy(&fv->lock);
+        free(fv->chunks[0]);
+        free(fv);
+        return NULL;
+    }
+    return fv;
+}
+
+void fv_close(file_view_t *fv) {
+    if (!fv) return;
+    atom_store(&fv->stop, 1);
+    thread_join(fv->thread);
+    fv_remap(fv, 0);
+    fv_close_file(fv);
+    mutex_destroy(&fv->lock);
+    for (int i = 0; i < FV_MAX_CHUNKS && fv->chunks[i]; i++) free(fv->chunks[i]);
+    free(fv);
+}
+
+static long long fv_count(file_view_t *fv) {
+    return fv->newlines + (fv->scanned > fv->tail ? 1 : 0);
+}
+
+long long fv_lines(file_view_t *fv) {
+    mutex_lock(&fv->lock);
+    long long n = fv_count(fv);
+    mutex_unlock(&fv->lock);
+    return n;
+}
+
+long long fv_size(file_view_t *fv) {
+    mutex_lock(&fv->lock);
+    long long n = fv->map_size;
+    mutex_unlock(&fv->lock);
+    return n;
+}
+
+int fv_indexing(file_view_t *fv) {
+    mutex_lock(&fv->lock);
+    int r = fv->scanned < fv->map_size && !fv->full;
+    mutex_unlock(&fv->lock);
+    return r;
+}
+
+int fv_line(file_view_t *fv, long long i, char *buf, int cap) {
+    int len = -1;
+    mutex_lock(&fv->lock);
+    if (i >= 0 && i < fv_count(fv) && cap > 0) {
+        const char *end = fv->map + fv->scanned;
+        const char *p = fv->map + fv->chunks[i / FV_BLOCK_LINES / FV_CHUNK][i / FV_BLOCK_LINES % FV_CHUNK];
+        for (int k = i % FV_BLOCK_LINES; k > 0; k--) p = (const char *)memchr(p, '\n', end - p) + 1;
+        const char *q = (const char *)memchr(p, '\n', end - p);
+        if (!q) q = end;
+        if (q > p && q[-1] == '\r') q--;
+        len = q - p < cap - 1 ? (int)(q - p) : cap - 1;
+        /* 截断时不留半个 UTF-8 字符 */
+        if (len < q - p) while (len > 0 && ((unsigned char)p[len] & 0xC0) == 0x80) len--;
+        memcpy(buf, p, len);
+        buf[len] = '\0';
+    }
+    mutex_unlock(&fv->lock);
+    return len;
+}
+
+void fv_goto(file_view_t *fv, long long line) {
+    mutex_lock(&fv->lock);
+    fv->goto_line = line;
+    mutex_unlock(&fv->lock);
+}
+
+void fv_draw(mu_Context *ctx, file_view_t *fv) {
+    char buf[FV_LINE_MAX + 1];
+    mu_ListClipper lc;
+    long long n = fv_lines(fv);
+    mu_layout_row(ctx, 1, (int[]){-1}, 0);
+    mu_layout_begin_list(ctx, &lc, n > INT_MAX ? INT_MAX : (int)n, 0);
+    for (int i = lc.start; i < lc.end; i++) {
+        int len = fv_line(fv, i, buf, sizeof(buf));
+        if (len < 0) break;     /* 文件刚被截断 */
+        for (int j = 0; j < len; j++) if ((unsigned char)buf[j] < 0x20) buf[j] = ' ';
+        mu_label(ctx, buf);
+    }
+    mu_layout_end_list(ctx, &lc);
+    if (fv_indexing(fv)) mu_request_frame(ctx);     /* 行数还在涨, 滚动条要跟着更新 */
+
+    mutex_lock(&fv->lock);
+    long long line = fv->goto_line;
+    fv->goto_line = -1;
+    mutex_unlock(&fv->lock);
+    if (line >= 0) {
+        /* 布局体相对容器 body 缩进了 padding, 下一帧 scrollbar 会把它夹到合法范围 */
+        mu_get_current_container(ctx)->scroll.y = ctx->style->padding + lc.base + (int)line * lc.stride;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef __FILE_VIEW_H__
+#define __FILE_VIEW_H__
+
+#include "microui.h"
+
+/* 大文件查看器: 文件以只读方式映射进内存, 后台线程分批扫描换行建立稀疏行索引
+ * (每 FV_BLOCK_LINES 行记一个偏移, 内存约为每 32 行 8 字节).
+ * 取第 i 行 = 查块起点 + 最多 FV_BLOCK_LINES-1 次 memchr, 与文件大小无关.
+ * 索引未完成时已扫描部分即可显示; 文件变长会被后台线程发现并继续索引,
+ * 变短(被截断或轮转)则从头重建. 映射是共享的: 后台线程发现截断之前, 读已被截掉的
+ * 部分会触发 SIGBUS, 因此适合只追加的日志. */
+
+#define FV_BLOCK_LINES  32
+#define FV_LINE_MAX     1024        /* 单行最多显示的字节数 */
+#define FV_POLL_MS      100         /* 扫描完后检查文件大小的间隔 */
+
+typedef struct file_view_t file_view_t;
+
+file_view_t *fv_open(const char *path);     /* 失败返回 NULL */
+void fv_close(file_view_t *fv);
+long long fv_lines(file_view_t *fv);        /* 目前已知的行数, 含末尾没有换行的半行 */
+long long fv_size(file_view_t *fv);         /* 当前映射的字节数 */
+int  fv_indexing(file_view_t *fv);          /* 仍有未扫描的数据时为 1 */
+int  fv_line(file_view_t *fv, long long i, char *buf, int cap);  /* 复制第 i 行(去掉 \r\n), 返回长度, 越界返回 -1 */
+void fv_goto(file_view_t *fv, long long line);  /* 下一次 fv_draw 时把该行滚到顶部 */
+void fv_draw(mu_Context *ctx, file_view_t *fv); /* 在当前容器里按可见范围画行 */
+
+#endif /* __FILE_VIEW_H__ */
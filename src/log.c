@@ -0,0 +1,126 @@
+#include "log.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* 有界 MPMC 环形队列(thread.h 的 mpmc_*), 全零的静态初值就是合法的初始状态,
+ * 生产者无需等待初始化. */
+
+#define LOG_MASK   (LOG_SLOTS - 1)
+#define LOG_BATCH  (64 * 1024)
+
+typedef struct {
+    volatile atom_t seq;
+    int  len;
+    char text[LOG_MSG_MAX];
+} LogSlot;
+
+enum { LOG_STATE_IDLE, LOG_STATE_RUNNING, LOG_STATE_STOPPED };
+
+static LogSlot          g_ring[LOG_SLOTS];
+static volatile atom_t  g_head;             /* 生产者写入位置 */
+static atom_t           g_tail;             /* 消费位置, 只在持有 g_flushing 时访问 */
+static volatile atom_t  g_dropped;
+static volatile atom_t  g_state, g_stop, g_flushing;
+
+static thread_t     g_thread;
+static FILE        *g_fp;
+static const char  *g_path = "debug.log";
+static int          g_truncated;            /* 当前路径是否已截断过 */
+static atom_t       g_dropped_reported;
+static char         g_batch[LOG_BATCH];
+
+static const char *g_level_names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+static void log_thread(void *arg) {
+    (void)arg;
+    while (!atom_load(&g_stop)) {
+        thread_sleep_ms(LOG_FLUSH_MS);
+        log_flush();
+    }
+}
+
+static void log_start(void) {
+    atom_t idle = LOG_STATE_IDLE;
+    if (!atom_cas(&g_state, &idle, LOG_STATE_RUNNING)) return;
+    atexit(log_shutdown);
+    if (thread_create(&g_thread, log_thread, NULL)) atom_store(&g_state, LOG_STATE_STOPPED);
+}
+
+void log_write(int level, const char *file, int line, const char *fmt, ...) {
+    if (atom_load(&g_state) == LOG_STATE_IDLE) log_start();
+
+    /* 抢占一个空槽, 满了就丢弃 */
+    atom_t pos;
+    LogSlot *s = (LogSlot *)mpmc_claim(g_ring, sizeof(LogSlot), LOG_MASK, &g_head, &pos);
+    if (!s) { atom_add(&g_dropped, 1); return; }
+
+    int n = snprintf(s->text, LOG_MSG_MAX, "%-5s %s:%d: ", g_level_names[level], file, line);
+    if (n < 0 || n > LOG_MSG_MAX - 1) n = LOG_MSG_MAX - 1;
+    va_list ap;
+    va_start(ap, fmt);
+    int m = vsnprintf(s->text + n, LOG_MSG_MAX - n, fmt, ap);
+    va_end(ap);
+    if (m > 0) n = (n + m < LOG_MSG_MAX - 1) ? n + m : LOG_MSG_MAX - 2;
+    s->text[n++] = '\n';
+    s->len = n;
+    mpmc_publish(s, LOG_MASK, pos);
+
+    /* 后台线程已停止(退出阶段)时同步写出 */
+    if (atom_load(&g_state) == LOG_STATE_STOPPED) log_flush();
+}
+
+static void batch_write(int len) {
+    if (!len) return;
+    if (!g_fp) {
+        g_fp = fopen(g_path, g_truncated ? "a" : "w");
+        g_truncated = 1;
+        if (!g_fp) return;
+    }
+    fwrite(g_batch, 1, len, g_fp);
+}
+
+void log_flush(void) {
+    atom_t zero = 0;
+    while (!atom_cas(&g_flushing, &zero, 1)) { zero = 0; thread_sleep_ms(0); }
+
+    int len = 0;
+    for (LogSlot *s; (s = (LogSlot *)mpmc_peek(g_ring, sizeof(LogSlot), LOG_MASK, g_tail)); g_tail++) {
+        if (len + s->len > LOG_BATCH) { batch_write(len); len = 0; }
+        memcpy(g_batch + len, s->text, s->len);
+        len += s->len;
+        mpmc_release(s, LOG_MASK, g_tail);
+    }
+    atom_t dropped = atom_load(&g_dropped);
+    if (dropped != g_dropped_reported && len + 64 <= LOG_BATCH) {
+        len += sprintf(g_batch + len, "WARN  log: %lu messages dropped\n", dropped - g_dropped_reported);
+        g_dropped_reported = dropped;
+    }
+    batch_write(len);
+    if (g_fp) fflush(g_fp);
+
+    atom_store(&g_flushing, 0);
+}
+
+void log_open(const char *path) {
+    log_flush();
+    atom_t zero = 0;
+    while (!atom_cas(&g_flushing, &zero, 1)) { zero = 0; thread_sleep_ms(0); }
+    if (g_fp) fclose(g_fp);
+    g_fp = NULL;
+    g_path = path;
+    g_truncated = 0;
+    atom_store(&g_flushing, 0);
+}
+
+void log_shutdown(void) {
+    atom_t running = LOG_STATE_RUNNING;
+    if (atom_cas(&g_state, &running, LOG_STATE_STOPPED)) {
+        atom_store(&g_stop, 1);
+        thread_join(g_thread);
+    }
+    log_flush();
+}
+
+unsigned long log_dropped(void) { return atom_load(&g_dropped); }
@@ -1,14 +1,61 @@
-#ifndef __LOG_H__
-#define __LOG_H__
-
-#define LOG(fmt, ...) do { \
-    static int first = 1; \
-    FILE *fp = fopen("debug.log", first ? "w" : "a"); \
-    if (fp) { \
-        fprintf(fp, "%s:%d: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
-        fclose(fp); \
-        first = 0; \
-    } \
-} while(0)
-
-#endif /* __LOG_H__ */
\ No newline at end of file
+#ifndef __LOG_H__
+#define __LOG_H__
+
+/* 日志: 格式化进无锁环形缓冲(多生产者不加锁), 后台线程每 LOG_FLUSH_MS 批量写文件, 退出时再刷一次.
+ * 缓冲满时丢弃新消息并计数, 不阻塞调用方. 低于 LOG_LEVEL 的级别在编译期去掉. */
+
+/* 级别用宏而不是枚举, 以便在 #if 中比较 */
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_NONE  5
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_SLOTS     1024      /* 环形缓冲槽数, 2 的幂 */
+#define LOG_MSG_MAX   240       /* 单条消息最大长度(含换行), 超出截断 */
+#define LOG_FLUSH_MS  50
+
+void log_open(const char *path);            /* 默认 "debug.log", 首次写入时截断 */
+void log_write(int level, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+void log_flush(void);                       /* 立即把缓冲中的消息写入文件 */
+void log_shutdown(void);                    /* 停止后台线程并刷新, 已注册到 atexit */
+unsigned long log_dropped(void);            /* 因缓冲满而丢弃的消息数 */
+
+#define LOG_AT(lv, fmt, ...) log_write(lv, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+#if LOG_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(fmt, ...) LOG_AT(LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#else
+#define LOG_TRACE(fmt, ...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...)  ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...)  ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+/* 兼容旧接口 */
+#define LOG(fmt, ...) LOG_DEBUG(fmt, ##__VA_ARGS__)
+
+#endif /* __LOG_H__ */
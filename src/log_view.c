@@ -0,0 +1,224 @@
+#include "log_view.h"
+#include "thread.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LV_MASK (LV_SLOTS - 1)
+
+/* thread.h 的 mpmc_* 队列, calloc 出来的全零状态即为空队列 */
+typedef struct {
+    volatile atom_t seq;
+    int  len;
+    char text[LV_MSG_MAX];
+} LvSlot;
+
+typedef struct {
+    char *text;
+    int   len;
+    int   rows;         /* 按 wrap_w 折行后的行数 */
+    long long row;      /* 第一行的折行号, 从开始计数不随挤出变化 */
+} LvLine;
+
+struct log_view_t {
+    LvSlot          ring[LV_SLOTS];
+    volatile atom_t head;           /* 生产者写入位置 */
+    atom_t          tail;           /* 以下只由 UI 线程访问 */
+    volatile atom_t dropped;
+    LvLine *lines;                  /* 历史行的环, first 为最旧 */
+    int     cap, first, count;
+    long long row_base, row_end;    /* 最旧一行与下一行的折行号 */
+    long long view_base;            /* 上次 lv_draw 时的 row_base, 据此补偿期间挤出的行 */
+    int     wrap_w;                 /* 当前折行宽度, 0 表示尚未绘制过 */
+};
+
+log_view_t *lv_new(int max_lines) {
+    log_view_t *lv = (log_view_t *)calloc(1, sizeof(*lv));
+    if (!lv) return NULL;
+    lv->cap = max_lines > 0 ? max_lines : 1;
+    lv->lines = (LvLine *)calloc(lv->cap, sizeof(LvLine));
+    if (!lv->lines) { free(lv); return NULL; }
+    return lv;
+}
+
+void lv_free(log_view_t *lv) {
+    if (!lv) return;
+    for (int i = 0; i < lv->count; i++) free(lv->lines[(lv->first + i) % lv->cap].text);
+    free(lv->lines);
+    free(lv);
+}
+
+/* ---------- 生产者 ---------- */
+/* text 有 len 字节; 超过 LV_MSG_MAX - 1 时截断, 不留半个 UTF-8 字符 */
+static int lv_put(log_view_t *lv, const char *text, int len) {
+    atom_t pos;
+    LvSlot *s = (LvSlot *)mpmc_claim(lv->ring, sizeof(LvSlot), LV_MASK, &lv->head, &pos);
+    if (!s) { atom_add(&lv->dropped, 1); return -1; }
+    int n = len < LV_MSG_MAX - 1 ? len : LV_MSG_MAX - 1;
+    if (n < len) while (n > 0 && ((unsigned char)text[n] & 0xC0) == 0x80) n--;
+    memcpy(s->text, text, n);
+    s->len = n;
+    mpmc_publish(s, LV_MASK, pos);
+    return 0;
+}
+
+int lv_append(log_view_t *lv, const char *text) {
+    return lv_put(lv, text, (int)strlen(text));
+}
+
+int lv_printf(log_view_t *lv, const char *fmt, ...) {
+    char buf[LV_MSG_MAX + 1];   /* 多留一个字节, 截断处是不是字符中间才看得出来 */
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) n = 0;
+    return lv_put(lv, buf, n < LV_MSG_MAX ? n : LV_MSG_MAX);
+}
+
+unsigned long lv_dropped(log_view_t *lv) { return atom_load(&lv->dropped); }
+
+/* ---------- UI 线程 ---------- */
+static LvLine *lv_at(log_view_t *lv, int i) { return &lv->lines[(lv->first + i) % lv->cap]; }
+
+int lv_lines(log_view_t *lv) { return lv->count; }
+int lv_pending(log_view_t *lv) {
+    return mpmc_peek(lv->ring, sizeof(LvSlot), LV_MASK, lv->tail) != NULL;
+}
+int lv_rows(log_view_t *lv) { return (int)(lv->row_end - lv->row_base); }
+const char *lv_line(log_view_t *lv, int i) { return (i >= 0 && i < lv->count) ? lv_at(lv, i)->text : NULL; }
+
+/* 按宽度贪心折行: 在空格处断开, 单词比整行还宽时按字符断开.
+ * starts 不为 NULL 时写入每一折行的起始偏移(至少有 len+1 个位置), 返回行数 */
+static int lv_wrap(mu_Context *ctx, const char *s, int len, int width, int *starts) {
+    mu_Font font = ctx->style->font;
+    int rows = 1, x = 0, i = 0;
+    if (starts) starts[0] = 0;
+    if (width <= 0) return 1;
+#define LV_BREAK(at) do { if (starts) starts[rows] = (at); rows++; x = 0; } while (0)
+    while (i < len) {
+        int j = i + 1;
+        if (s[i] != ' ') while (j < len && s[j] != ' ') j++;
+        int w = ctx->text_width(font, s + i, j - i);
+        if (x + w > width && x > 0) {
+            if (s[i] == ' ') {          /* 在空格处断开, 空格本身不显示 */
+                i = j;
+                if (i < len) LV_BREAK(i);
+                continue;
+            }
+            LV_BREAK(i);
+        }
+        if (w > width) {
+            while (i < j) {
+                int k = i + 1;
+                while (k < j && ((unsigned char)s[k] & 0xC0) == 0x80) k++;
+                int cw = ctx->text_width(font, s + i, k - i);
+                if (x + cw > width && x > 0) LV_BREAK(i);
+                x += cw;
+                i = k;
+            }
+            continue;
+        }
+        x += w;
+        i = j;
+    }
+#undef LV_BREAK
+    return rows;
+}
+
+static void lv_push_line(mu_Context *ctx, log_view_t *lv, const char *text, int len) {
+    if (lv->count == lv->cap) {     /* 挤出最旧的一行 */
+        LvLine *old = lv_at(lv, 0);
+        free(old->text);
+        lv->row_base += old->rows;
+        lv->first = (lv->first + 1) % lv->cap;
+        lv->count--;
+    }
+    LvLine *l = lv_at(lv, lv->count);
+    l->text = (char *)malloc(len + 1);
+    if (!l->text) return;
+    memcpy(l->text, text, len);
+    l->text[len] = '\0';
+    l->len = len;
+    l->rows = lv_wrap(ctx, text, len, lv->wrap_w, NULL);
+    l->row = lv->row_end;
+    lv->row_end += l->rows;
+    lv->count++;
+}
+
+static void lv_rewrap(mu_Context *ctx, log_view_t *lv, int width) {
+    lv->wrap_w = width;
+    lv->row_end = lv->row_base;
+    for (int i = 0; i < lv->count; i++) {
+        LvLine *l = lv_at(lv, i);
+        l->rows = lv_wrap(ctx, l->text, l->len, width, NULL);
+        l->row = lv->row_end;
+        lv->row_end += l->rows;
+    }
+}
+
+static void lv_drain(mu_Context *ctx, log_view_t *lv) {
+    for (LvSlot *s; (s = (LvSlot *)mpmc_peek(lv->ring, sizeof(LvSlot), LV_MASK, lv->tail)); lv->tail++) {
+        lv_push_line(ctx, lv, s->text, s->len);
+        mpmc_release(s, LV_MASK, lv->tail);
+    }
+}
+
+void lv_update(mu_Context *ctx, log_view_t *lv) {
+    lv_drain(ctx, lv);
+}
+
+/* 包含折行号 row 的历史行 */
+static int lv_find(log_view_t *lv, long long row) {
+    int lo = 0, hi = lv->count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (lv_at(lv, mid)->row <= row) lo = mid; else hi = mid - 1;
+    }
+    return lo;
+}
+
+void lv_draw(mu_Context *ctx, log_view_t *lv) {
+    int starts[LV_MSG_MAX + 1];
+    mu_Container *cnt = mu_get_current_container(ctx);
+    mu_Font font = ctx->style->font;
+    mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
+    int pad = ctx->style->padding;
+    int width = cnt->body.w - pad * 2;
+    int th = ctx->text_height(font);
+
+    /* 上一帧停在底部(或内容还放得下)就继续跟随 */
+    int follow = cnt->scroll.y >= cnt->content_size.y + pad * 2 - cnt->body.h;
+
+    if (width != lv->wrap_w) lv_rewrap(ctx, lv, width);
+    long long base = lv->view_base;
+    lv_drain(ctx, lv);
+    lv->view_base = lv->row_base;
+
+    mu_ListClipper lc;
+    mu_layout_row(ctx, 1, (int[]){-1}, th);
+    mu_layout_begin_list(ctx, &lc, lv_rows(lv), th);
+    int i = lc.start < lc.end ? lv_find(lv, lv->row_base + lc.start) : lv->count;
+    for (int r = lc.start; r < lc.end && i < lv->count; i++) {
+        LvLine *l = lv_at(lv, i);
+        int n = lv_wrap(ctx, l->text, l->len, lv->wrap_w, starts);
+        starts[n] = l->len;
+        for (int k = (int)(lv->row_base + r - l->row); k < n && r < lc.end; k++, r++) {
+            mu_Rect rect = mu_layout_next(ctx);
+            int a = starts[k], b = starts[k + 1];
+            while (b > a && l->text[b - 1] == ' ') b--;
+            if (b > a) mu_draw_text(ctx, font, l->text + a, b - a, mu_vec2(rect.x, rect.y), color);
+        }
+    }
+    mu_layout_end_list(ctx, &lc);
+
+    if (follow) {
+        /* 日志是容器里最后的内容时正好滚到底; 下一帧 scrollbar 会再夹一次 */
+        int bottom = lc.base + lc.count * lc.stride - ctx->style->spacing;
+        cnt->scroll.y = mu_max(0, bottom + pad * 2 - cnt->body.h);
+    } else if (lv->row_base != base) {
+        /* 旧行被挤出: 往回滚同样的高度, 看着的内容保持不动 */
+        cnt->scroll.y = mu_max(0, cnt->scroll.y - (int)(lv->row_base - base) * lc.stride);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef __LOG_VIEW_H__
+#define __LOG_VIEW_H__
+
+#include "microui.h"
+
+/* 日志控件: 任意线程用 lv_append 无锁地把行放进有界环形队列(与 log.c 共用
+ * thread.h 的 Vyukov 队列, 满了就丢弃并计数); UI 线程每帧在 lv_draw 里取出新行, 只为新行
+ * 计算折行, 按可见范围绘制. 视图停在底部时自动跟随新内容.
+ * 宽度变化时才会重新折所有行. */
+
+#define LV_SLOTS    4096            /* 队列容量, 必须是 2 的幂 */
+#define LV_MSG_MAX  240             /* 单行最多 LV_MSG_MAX - 1 字节, 超出在字符边界截断 */
+
+typedef struct log_view_t log_view_t;
+
+log_view_t *lv_new(int max_lines);          /* 最多保留 max_lines 行历史, 旧行被挤出 */
+void lv_free(log_view_t *lv);
+int  lv_append(log_view_t *lv, const char *text);   /* 任意线程; 队列满返回 -1 */
+int  lv_printf(log_view_t *lv, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+unsigned long lv_dropped(log_view_t *lv);   /* 因队列满被丢弃的行数 */
+int  lv_lines(log_view_t *lv);              /* 以下仅 UI 线程: 历史行数 */
+int  lv_pending(log_view_t *lv);            /* 队列里有尚未画出的新行, 空闲时据此决定要不要跑一帧 */
+const char *lv_line(log_view_t *lv, int i); /* 第 i 行(0 为最旧) */
+int  lv_rows(log_view_t *lv);               /* 折行后的总行数 */
+void lv_update(mu_Context *ctx, log_view_t *lv);    /* 只取出新行; 控件这一帧没画(如所在标题折叠)时调用, 免得 lv_pending 一直为真 */
+void lv_draw(mu_Context *ctx, log_view_t *lv);  /* 取出新行并在当前容器里绘制 */
+
+#endif /* __LOG_VIEW_H__ */
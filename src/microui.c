@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "microui.h"
+#include "stats.h"
 
 #define unused(x) ((void) (x))
 
@@ -36,7 +37,9 @@
   } while (0)
 
 #define push(stk, val) do {                                                 \
-    expect((stk).idx < (int) (sizeof((stk).items) / sizeof(*(stk).items))); \
+    if ((stk).idx == (stk).cap) {                                           \
+      grow_stack((void**) &(stk).items, &(stk).cap, sizeof(*(stk).items));  \
+    }                                                                       \
     (stk).items[(stk).idx] = (val);                                         \
     (stk).idx++; /* incremented after incase `val` uses this value */       \
   } while (0)
@@ -47,6 +50,22 @@
   } while (0)
 
 
+#define stack_init(stk, n) do {                                  \
+    (stk).items = malloc((n) * sizeof(*(stk).items));            \
+    expect((stk).items);                                         \
+    (stk).cap = (n);                                             \
+  } while (0)
+
+
+static void grow_stack(void **items, int *cap, int size) {
+  int n = *cap ? *cap * 2 : 8;
+  void *p = realloc(*items, n * size);
+  expect(p);
+  *items = p;
+  *cap = n;
+}
+
+
 static mu_Rect unclipped_rect = { 0, 0, 0x1000000, 0x1000000 };
 
 static mu_Style default_style = {
@@ -127,34 +146,434 @@ static void draw_frame(mu_Context *ctx, mu_Rect rect, int colorid) {
 }
 
 
-void mu_init(mu_Context *ctx) {
+/* 32bit fnv-1a hash */
+#define HASH_INITIAL 2166136261
+
+static void hash(mu_Id *hash, const void *data, int size) {
+  const unsigned char *p = data;
+  while (size--) {
+    *hash = (*hash ^ *p++) * 16777619;
+  }
+}
+
+
+static void pool_grow(mu_Pool *pool, int cap);
+static void grow_containers(mu_Context *ctx);
+static void z_unlink(mu_Context *ctx, mu_Container *cnt);
+
+
+static mu_CommandChunk* new_command_chunk(int size) {
+  mu_CommandChunk *chunk = malloc(sizeof(mu_CommandChunk) + size);
+  expect(chunk);
+  chunk->next = NULL;
+  chunk->size = size;
+  return chunk;
+}
+
+
+static void reset_command_list(mu_Context *ctx) {
+  ctx->command_list.chunk = ctx->command_list.first;
+  ctx->command_list.items = (char*) (ctx->command_list.first + 1);
+  ctx->command_list.cap = ctx->command_list.first->size;
+  ctx->command_list.idx = 0;
+  ctx->command_list.total = 0;
+}
+
+
+/*============================================================================
+** occlusion
+**============================================================================*/
+
+static int rect_contains(mu_Rect outer, mu_Rect r) {
+  return r.x >= outer.x && r.y >= outer.y &&
+    r.x + r.w <= outer.x + outer.w && r.y + r.h <= outer.y + outer.h;
+}
+
+
+static int rects_overlap(mu_Rect a, mu_Rect b) {
+  return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+
+static void add_piece(mu_Rect *list, int *n, int x, int y, int w, int h) {
+  if (w > 0 && h > 0) { list[(*n)++] = mu_rect(x, y, w, h); }
+}
+
+
+/* nonzero if nothing of `r` is left inside the viewport once the `n` opaque
+** rects in `occ` are removed from it. the visible part is kept as disjoint
+** rects; when it splits into too many we assume visible */
+static int rect_hidden(mu_Context *ctx, mu_Rect r, const mu_Rect *occ, int n) {
+  mu_Rect buf[2][MU_CULL_RECTS];
+  mu_Rect *vis = buf[0], *next = buf[1], *tmp, v, o;
+  int i, k, m, nv = 0, y0, y1;
+  r = intersect_rects(r, ctx->viewport);
+  add_piece(vis, &nv, r.x, r.y, r.w, r.h);
+  for (k = 0; k < n && nv > 0; k++) {
+    o = occ[k];
+    for (i = m = 0; i < nv; i++) {
+      v = vis[i];
+      if (m + 4 > MU_CULL_RECTS) { return 0; }
+      if (!rects_overlap(v, o)) { next[m++] = v; continue; }
+      /* the parts of `v` above, below, left and right of `o` */
+      y0 = mu_max(v.y, o.y);
+      y1 = mu_min(v.y + v.h, o.y + o.h);
+      add_piece(next, &m, v.x, v.y, v.w, y0 - v.y);
+      add_piece(next, &m, v.x, y1, v.w, v.y + v.h - y1);
+      add_piece(next, &m, v.x, y0, o.x - v.x, y1 - y0);
+      add_piece(next, &m, o.x + o.w, y0, v.x + v.w - o.x - o.w, y1 - y0);
+    }
+    tmp = vis; vis = next; next = tmp;
+    nv = m;
+  }
+  return nv == 0;
+}
+
+
+/* the border drawn by draw_frame() sits just outside the rect */
+static mu_Rect root_area(mu_Context *ctx, mu_Container *cnt) {
+  return expand_rect(cnt->rect, ctx->style->colors[MU_COLOR_BORDER].a ? 1 : 0);
+}
+
+
+/* nonzero if `r` can't show: outside the viewport or inside one of `occ` */
+static int rect_covered(mu_Context *ctx, mu_Rect r, const mu_Rect *occ, int n) {
+  int i;
+  if (!rects_overlap(r, ctx->viewport)) { return 1; }
+  for (i = 0; i < n; i++) {
+    if (rect_contains(occ[i], r)) { return 1; }
+  }
+  return 0;
+}
+
+
+static int command_hidden(mu_Context *ctx, mu_Command *cmd, const mu_Rect *occ, int n) {
+  mu_Rect r;
+  switch (cmd->type) {
+    case MU_COMMAND_RECT: r = cmd->rect.rect; break;
+    case MU_COMMAND_ICON: r = cmd->icon.rect; break;
+    case MU_COMMAND_GLYPHS:
+      r = mu_rect(cmd->glyphs.pos.x, cmd->glyphs.pos.y,
+        cmd->glyphs.width, ctx->text_height(cmd->glyphs.font));
+      break;
+    case MU_COMMAND_TEXT:
+      /* only measured when its first cell is hidden */
+      r = mu_rect(cmd->text.pos.x, cmd->text.pos.y, 1, ctx->text_height(cmd->text.font));
+      if (!rect_covered(ctx, r, occ, n)) { return 0; }
+      r.w = ctx->text_width(cmd->text.font, cmd->text.str, -1);
+      break;
+    default: return 0;
+  }
+  return rect_covered(ctx, r, occ, n);
+}
+
+
+/* collects the opaque roots drawn above root `idx` this frame into `occ`.
+** returns nonzero if they and the viewport leave none of the root showing */
+static int root_hidden(mu_Context *ctx, int idx, mu_Rect *occ, int *n) {
+  mu_Container *cnt = ctx->root_list.items[idx], *p;
+  int i;
+  *n = 0;
+  for (i = idx + 1; i < ctx->root_list.idx && *n < MU_CULL_RECTS; i++) {
+    p = ctx->root_list.items[i];
+    if (p->opaque && rects_overlap(p->rect, cnt->rect)) { occ[(*n)++] = p->rect; }
+  }
+  /* nothing above it and well inside the viewport: everything shows */
+  if (*n == 0 && rect_contains(ctx->viewport, root_area(ctx, cnt))) { return 0; }
+  return rect_hidden(ctx, root_area(ctx, cnt), occ, *n);
+}
+
+
+/* turns the commands of root `idx` that can't show behind the `n` rects in
+** `occ` into jumps to the next command. the ordinals of the dropped commands
+** are hashed into the container, so its hash still identifies what actually
+** gets drawn */
+static void cull_commands(mu_Context *ctx, int idx, const mu_Rect *occ, int n) {
+  mu_Container *cnt = ctx->root_list.items[idx];
+  mu_Command *cmd, *next;
+  int k;
+  if (n == 0 && rect_contains(ctx->viewport, root_area(ctx, cnt))) { return; }
+  cmd = (mu_Command*) ((char*) cnt->head + sizeof(mu_JumpCommand));
+  /* jumps aren't counted: chunk boundaries differ between contexts */
+  for (k = 0; cmd != cnt->tail; ) {
+    if (cmd->type == MU_COMMAND_JUMP) { cmd = cmd->jump.dst; continue; }
+    next = (mu_Command*) ((char*) cmd + cmd->base.size);
+    if (command_hidden(ctx, cmd, occ, n)) {
+      cmd->type = MU_COMMAND_JUMP;
+      cmd->jump.dst = next;
+      hash(&cnt->hash, &k, sizeof(k));
+    }
+    cmd = next;
+    k++;
+  }
+}
+
+
+/*============================================================================
+** hit-test grid
+**============================================================================*/
+
+/* the grids index last frame's root rects, back to front, and the rects that
+** controls in its hover root tested against the mouse. both are recorded in
+** place as the frame runs; a grid is rebuilt on the first lookup after a
+** rect changed. the root under the mouse is looked up in the root grid. a
+** mouse move needs no frame when the frontmost root under the mouse is the
+** same and the mouse is inside exactly the same control rects as where the
+** frame was run: then no hover test of that frame could come out differently */
+
+static void hit_grid_reserve(mu_HitGrid *g, int n) {
+  mu_Rect *p;
+  if (n <= g->cap) { return; }
+  p = realloc(g->rects, mu_max(n, g->cap * 2) * sizeof(mu_Rect));
+  expect(p);
+  g->rects = p;
+  g->cap = mu_max(n, g->cap * 2);
+}
+
+
+/* stores rect `i` of the grid being recorded; unchanged rects keep the
+** buckets */
+static void hit_grid_put(mu_HitGrid *g, int i, mu_Rect r) {
+  if (i < g->count && !memcmp(&g->rects[i], &r, sizeof(r))) { return; }
+  hit_grid_reserve(g, i + 1);
+  g->rects[i] = r;
+  g->built = 0;
+}
+
+
+/* ends recording with `n` rects */
+static void hit_grid_trim(mu_HitGrid *g, int n) {
+  if (n != g->count) { g->built = 0; }
+  g->count = n;
+}
+
+
+static void hit_grid_build(mu_HitGrid *g) {
+  int fill[MU_HITGRID_SIZE * MU_HITGRID_SIZE];
+  int i, x, y, total, any = 0;
+  int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+  mu_Rect r;
+  g->built = 1;
+  g->cell = mu_vec2(0, 0);
+  for (i = 0; i < g->count; i++) {
+    r = g->rects[i];
+    if (r.w <= 0 || r.h <= 0) { continue; }
+    if (!any || r.x < x0) { x0 = r.x; }
+    if (!any || r.y < y0) { y0 = r.y; }
+    if (!any || r.x + r.w > x1) { x1 = r.x + r.w; }
+    if (!any || r.y + r.h > y1) { y1 = r.y + r.h; }
+    any = 1;
+  }
+  if (!any) { return; }
+  g->bounds = mu_rect(x0, y0, x1 - x0, y1 - y0);
+  g->cell.x = mu_max(1, (x1 - x0 + MU_HITGRID_SIZE - 1) / MU_HITGRID_SIZE);
+  g->cell.y = mu_max(1, (y1 - y0 + MU_HITGRID_SIZE - 1) / MU_HITGRID_SIZE);
+
+  /* count, prefix-sum, then fill in index order */
+  memset(g->start, 0, sizeof(g->start));
+  for (i = 0; i < g->count; i++) {
+    r = g->rects[i];
+    if (r.w <= 0 || r.h <= 0) { continue; }
+    for (y = (r.y - y0) / g->cell.y; y <= (r.y + r.h - 1 - y0) / g->cell.y; y++) {
+      for (x = (r.x - x0) / g->cell.x; x <= (r.x + r.w - 1 - x0) / g->cell.x; x++) {
+        g->start[y * MU_HITGRID_SIZE + x + 1]++;
+      }
+    }
+  }
+  for (i = 0; i < MU_HITGRID_SIZE * MU_HITGRID_SIZE; i++) {
+    g->start[i + 1] += g->start[i];
+    fill[i] = g->start[i];
+  }
+  total = g->start[MU_HITGRID_SIZE * MU_HITGRID_SIZE];
+  if (total > g->item_cap) {
+    int *p = realloc(g->items, mu_max(total, g->item_cap * 2) * sizeof(int));
+    expect(p);
+    g->items = p;
+    g->item_cap = mu_max(total, g->item_cap * 2);
+  }
+  for (i = 0; i < g->count; i++) {
+    r = g->rects[i];
+    if (r.w <= 0 || r.h <= 0) { continue; }
+    for (y = (r.y - y0) / g->cell.y; y <= (r.y + r.h - 1 - y0) / g->cell.y; y++) {
+      for (x = (r.x - x0) / g->cell.x; x <= (r.x + r.w - 1 - x0) / g->cell.x; x++) {
+        g->items[fill[y * MU_HITGRID_SIZE + x]++] = i;
+      }
+    }
+  }
+}
+
+
+/* the bucket holding `p`, or -1 if no rect can contain it */
+static int hit_bucket(mu_HitGrid *g, mu_Vec2 p) {
+  if (!g->built) { hit_grid_build(g); }
+  if (g->cell.x == 0 || !rect_overlaps_vec2(g->bounds, p)) { return -1; }
+  return (p.y - g->bounds.y) / g->cell.y * MU_HITGRID_SIZE + (p.x - g->bounds.x) / g->cell.x;
+}
+
+
+/* the next rect of bucket `k` from item `*i` on that contains `p`, or -1 */
+static int hit_next(mu_HitGrid *g, int k, int *i, mu_Vec2 p) {
+  int idx;
+  if (k < 0) { return -1; }
+  while (*i < g->start[k + 1]) {
+    idx = g->items[(*i)++];
+    if (rect_overlaps_vec2(g->rects[idx], p)) { return idx; }
+  }
+  return -1;
+}
+
+
+/* the last rect containing `p`; for roots that is the frontmost */
+static int hit_last(mu_HitGrid *g, mu_Vec2 p) {
+  int k = hit_bucket(g, p), i = k < 0 ? 0 : g->start[k], idx, last = -1;
+  while ((idx = hit_next(g, k, &i, p)) >= 0) { last = idx; }
+  return last;
+}
+
+
+/* nonzero if `p` and `q` are inside exactly the same rects */
+static int hit_same(mu_HitGrid *g, mu_Vec2 p, mu_Vec2 q) {
+  int kp = hit_bucket(g, p), kq = hit_bucket(g, q);
+  int ip = kp < 0 ? 0 : g->start[kp], iq = kq < 0 ? 0 : g->start[kq], a, b;
+  do {
+    a = hit_next(g, kp, &ip, p);
+    b = hit_next(g, kq, &iq, q);
+  } while (a == b && a >= 0);
+  return a == b;
+}
+
+
+/* nonzero if the mouse at `p` could change a hover test of the last frame,
+** which saw it at `last_mouse_pos` */
+static int hover_may_change(mu_Context *ctx, mu_Vec2 p) {
+  mu_Vec2 q = ctx->last_mouse_pos;
+  return hit_last(&ctx->root_grid, p) != hit_last(&ctx->root_grid, q) ||
+    !hit_same(&ctx->control_grid, p, q);
+}
+
+
+/* the frontmost of last frame's roots under `p` */
+static mu_Container *hit_root(mu_Context *ctx, mu_Vec2 p) {
+  int i = hit_last(&ctx->root_grid, p);
+  return i < 0 ? NULL : ctx->grid_roots.items[i];
+}
+
+
+#define config_size(field, def) (config && config->field > 0 ? config->field : (def))
+
+void mu_init_ex(mu_Context *ctx, const mu_Config *config) {
   memset(ctx, 0, sizeof(*ctx));
   ctx->draw_frame = draw_frame;
   ctx->_style = default_style;
   ctx->style = &ctx->_style;
+  ctx->redraw = 1;
+  ctx->cull = config && config->cull;
+  ctx->viewport = unclipped_rect;
+  ctx->container_pool.lru_head = ctx->container_pool.lru_tail = -1;
+  ctx->treenode_pool.lru_head = ctx->treenode_pool.lru_tail = -1;
+  pool_grow(&ctx->container_pool, config_size(container_pool_size, MU_CONTAINERPOOL_SIZE));
+  grow_containers(ctx);
+  pool_grow(&ctx->treenode_pool, config_size(treenode_pool_size, MU_TREENODEPOOL_SIZE));
+  /* every chunk keeps room for the jump that links it to the next */
+  ctx->command_list.first = new_command_chunk(
+    mu_max(config_size(command_list_size, MU_COMMANDLIST_SIZE), (int) sizeof(mu_JumpCommand) * 2));
+  reset_command_list(ctx);
+  stack_init(ctx->root_list, config_size(root_list_size, MU_ROOTLIST_SIZE));
+  stack_init(ctx->container_stack, config_size(container_stack_size, MU_CONTAINERSTACK_SIZE));
+  stack_init(ctx->clip_stack, config_size(clip_stack_size, MU_CLIPSTACK_SIZE));
+  stack_init(ctx->id_stack, config_size(id_stack_size, MU_IDSTACK_SIZE));
+  stack_init(ctx->layout_stack, config_size(layout_stack_size, MU_LAYOUTSTACK_SIZE));
+}
+
+
+void mu_init(mu_Context *ctx) {
+  mu_init_ex(ctx, NULL);
+}
+
+
+void mu_release(mu_Context *ctx) {
+  int i;
+  mu_CommandChunk *chunk = ctx->command_list.first;
+  while (chunk) {
+    mu_CommandChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(ctx->root_list.items);
+  free(ctx->container_stack.items);
+  free(ctx->clip_stack.items);
+  free(ctx->id_stack.items);
+  free(ctx->layout_stack.items);
+  for (i = 0; i < ctx->container_chunk_count; i++) {
+    free(ctx->container_chunks[i]);
+  }
+  free(ctx->container_chunks);
+  free(ctx->containers);
+  free(ctx->container_pool.items);
+  free(ctx->container_pool.table);
+  free(ctx->treenode_pool.items);
+  free(ctx->treenode_pool.table);
+  free(ctx->glyph_buf);
+  free(ctx->grid_roots.items);
+  free(ctx->root_grid.rects);
+  free(ctx->root_grid.items);
+  free(ctx->control_grid.rects);
+  free(ctx->control_grid.items);
+  memset(ctx, 0, sizeof(*ctx));
 }
 
 
 void mu_begin(mu_Context *ctx) {
   expect(ctx->text_width && ctx->text_height);
-  ctx->command_list.idx = 0;
+  STAT_FRAME_BEGIN();
+  STAT_PHASE_BEGIN(STAT_PHASE_LAYOUT);
+  reset_command_list(ctx);
   ctx->root_list.idx = 0;
+  ctx->last_frame_hash = ctx->frame_hash;
+  ctx->loose_hash = HASH_INITIAL;
+  ctx->command_hash = &ctx->loose_hash;
   ctx->scroll_target = NULL;
-  ctx->hover_root = ctx->next_hover_root;
-  ctx->next_hover_root = NULL;
   ctx->mouse_delta.x = ctx->mouse_pos.x - ctx->last_mouse_pos.x;
   ctx->mouse_delta.y = ctx->mouse_pos.y - ctx->last_mouse_pos.y;
+  /* the hover root is the one last mu_end() found under the mouse, or if the
+  ** mouse has moved since, the one under it in last frame's root grid */
+  if (ctx->mouse_delta.x || ctx->mouse_delta.y) {
+    ctx->hover_root = hit_root(ctx, ctx->mouse_pos);
+  } else {
+    ctx->hover_root = ctx->next_hover_root;
+  }
+  ctx->next_hover_root = NULL;
+  ctx->redraw = 0;
+  ctx->control_count = 0;
+  ctx->frame_hover = ctx->hover;
+  ctx->frame_focus = ctx->focus;
   ctx->frame++;
 }
 
 
-static int compare_zindex(const void *a, const void *b) {
-  return (*(mu_Container**) a)->zindex - (*(mu_Container**) b)->zindex;
+/* lists this frame's roots in z-order, recording their rects in the root
+** grid. roots that weren't begun this frame leave the z-list, so the walk
+** only covers this frame's roots and the ones that just disappeared */
+static void collect_roots(mu_Context *ctx) {
+  mu_Container *cnt, *next;
+  int n = 0;
+  ctx->grid_roots.idx = 0;
+  for (cnt = ctx->z_head; cnt; cnt = next) {
+    next = cnt->z_next;
+    if (cnt->root_frame != ctx->frame) { z_unlink(ctx, cnt); continue; }
+    ctx->root_list.items[n] = cnt;
+    push(ctx->grid_roots, cnt);
+    hit_grid_put(&ctx->root_grid, n++, cnt->rect);
+  }
+  ctx->root_list.idx = n;
+  hit_grid_trim(&ctx->root_grid, n);
 }
 
 
-void mu_end(mu_Context *ctx) {
-  int i, n;
+int mu_end(mu_Context *ctx) {
+  mu_Rect occ[MU_CULL_RECTS];
+  int i, k, m, n, res;
+  mu_Container *cnt;
   /* check stacks */
   expect(ctx->container_stack.idx == 0);
   expect(ctx->clip_stack.idx      == 0);
@@ -171,14 +590,32 @@ void mu_end(mu_Context *ctx) {
   if (!ctx->updated_focus) { ctx->focus = 0; }
   ctx->updated_focus = 0;
 
+  /* the next hover root is the frontmost root under the mouse, unless a popup
+  ** opened this frame claimed it */
+  collect_roots(ctx);
+  if (!ctx->next_hover_root) {
+    ctx->next_hover_root = hit_root(ctx, ctx->mouse_pos);
+  }
+
   /* bring hover root to front if mouse was pressed */
   if (ctx->mouse_pressed && ctx->next_hover_root &&
       ctx->next_hover_root->zindex < ctx->last_zindex &&
       ctx->next_hover_root->zindex >= 0
   ) {
     mu_bring_to_front(ctx, ctx->next_hover_root);
+    collect_roots(ctx);
   }
 
+  /* another frame is needed if this one consumed input, changed hover or focus
+  ** (widgets drawn before the change are stale), has a drag in progress or a
+  ** widget asked for one */
+  res = ctx->redraw || ctx->mouse_pressed || ctx->key_pressed ||
+    ctx->input_text[0] || ctx->hover != ctx->frame_hover ||
+    ctx->focus != ctx->frame_focus || ctx->next_hover_root != ctx->hover_root ||
+    (ctx->mouse_down && ctx->focus) ||
+    (ctx->scroll_target && (ctx->scroll_delta.x || ctx->scroll_delta.y));
+  ctx->redraw = res;
+
   /* reset input state */
   ctx->key_pressed = 0;
   ctx->input_text[0] = '\0';
@@ -186,17 +623,36 @@ void mu_end(mu_Context *ctx) {
   ctx->scroll_delta = mu_vec2(0, 0);
   ctx->last_mouse_pos = ctx->mouse_pos;
 
-  /* sort root containers by zindex */
+  hit_grid_trim(&ctx->control_grid, ctx->control_count);
   n = ctx->root_list.idx;
-  qsort(ctx->root_list.items, n, sizeof(mu_Container*), compare_zindex);
+
+  /* a root the viewport and the opaque roots above it hide is marked, and
+  ** next frame builds none of its commands. a root whose state flips needs
+  ** another frame: one that built none this frame but shows now, and without
+  ** culling, one that just got hidden and is still in this frame's chain.
+  ** with culling on, hidden roots leave the draw chain and the covered
+  ** commands of the others are dropped */
+  for (i = m = 0; i < n; i++) {
+    cnt = ctx->root_list.items[i];
+    if (root_hidden(ctx, i, occ, &k)) {
+      if (ctx->cull) { cnt->culled_frame = ctx->frame; continue; }
+      if (cnt->culled_frame != ctx->frame - 1) { res = ctx->redraw = 1; }
+      cnt->culled_frame = ctx->frame;
+    } else {
+      if (cnt->culled_frame == ctx->frame - 1) { res = ctx->redraw = 1; }
+      if (ctx->cull) { cull_commands(ctx, i, occ, k); }
+    }
+    ctx->root_list.items[m++] = cnt;
+  }
+  n = ctx->root_list.idx = m;
 
   /* set root container jump commands */
   for (i = 0; i < n; i++) {
-    mu_Container *cnt = ctx->root_list.items[i];
+    cnt = ctx->root_list.items[i];
     /* if this is the first container then make the first command jump to it.
     ** otherwise set the previous container's tail to jump to this one */
     if (i == 0) {
-      mu_Command *cmd = (mu_Command*) ctx->command_list.items;
+      mu_Command *cmd = (mu_Command*) (ctx->command_list.first + 1);
       cmd->jump.dst = (char*) cnt->head + sizeof(mu_JumpCommand);
     } else {
       mu_Container *prev = ctx->root_list.items[i - 1];
@@ -207,23 +663,40 @@ void mu_end(mu_Context *ctx) {
       cnt->tail->jump.dst = ctx->command_list.items + ctx->command_list.idx;
     }
   }
+
+  /* combine root container hashes in draw order into the frame hash */
+  ctx->frame_hash = ctx->loose_hash;
+  for (i = 0; i < n; i++) {
+    hash(&ctx->frame_hash, &ctx->root_list.items[i]->hash, sizeof(mu_Id));
+  }
+
+  STAT_SET(command_bytes, ctx->command_list.total + ctx->command_list.idx);
+  STAT_PHASE_END(STAT_PHASE_LAYOUT);
+  return res;
 }
 
 
-void mu_set_focus(mu_Context *ctx, mu_Id id) {
-  ctx->focus = id;
-  ctx->updated_focus = 1;
+int mu_frame_changed(mu_Context *ctx) {
+  return ctx->frame_hash != ctx->last_frame_hash;
 }
 
 
-/* 32bit fnv-1a hash */
-#define HASH_INITIAL 2166136261
+/* nonzero if input received since the last mu_end() (or that frame itself)
+** could change the ui; when zero the application can skip the frame */
+int mu_needs_frame(mu_Context *ctx) {
+  return ctx->redraw;
+}
 
-static void hash(mu_Id *hash, const void *data, int size) {
-  const unsigned char *p = data;
-  while (size--) {
-    *hash = (*hash ^ *p++) * 16777619;
-  }
+
+/* called by animating widgets during a frame to get another one */
+void mu_request_frame(mu_Context *ctx) {
+  ctx->redraw = 1;
+}
+
+
+void mu_set_focus(mu_Context *ctx, mu_Id id) {
+  ctx->focus = id;
+  ctx->updated_focus = 1;
 }
 
 
@@ -265,6 +738,7 @@ mu_Rect mu_get_clip_rect(mu_Context *ctx) {
 
 int mu_check_clip(mu_Context *ctx, mu_Rect r) {
   mu_Rect cr = mu_get_clip_rect(ctx);
+  if (cr.w <= 0 || cr.h <= 0) { return MU_CLIP_ALL; }
   if (r.x > cr.x + cr.w || r.x + r.w < cr.x ||
       r.y > cr.y + cr.h || r.y + r.h < cr.y   ) { return MU_CLIP_ALL; }
   if (r.x >= cr.x && r.x + r.w <= cr.x + cr.w &&
@@ -307,22 +781,70 @@ mu_Container* mu_get_current_container(mu_Context *ctx) {
 }
 
 
+/* containers are allocated in chunks as the pool grows so that pointers to
+** them stay valid */
+static void grow_containers(mu_Context *ctx) {
+  int i, n = ctx->container_pool.cap - ctx->container_cap;
+  mu_Container *chunk, **ptrs;
+  if (n <= 0) { return; }
+  if (ctx->container_chunk_count == ctx->container_chunk_cap) {
+    grow_stack((void**) &ctx->container_chunks, &ctx->container_chunk_cap, sizeof(mu_Container*));
+  }
+  chunk = calloc(n, sizeof(mu_Container));
+  ptrs = realloc(ctx->containers, ctx->container_pool.cap * sizeof(mu_Container*));
+  expect(chunk && ptrs);
+  for (i = 0; i < n; i++) { ptrs[ctx->container_cap + i] = &chunk[i]; }
+  ctx->containers = ptrs;
+  ctx->container_chunks[ctx->container_chunk_count++] = chunk;
+  ctx->container_cap = ctx->container_pool.cap;
+}
+
+
+static int z_linked(mu_Context *ctx, mu_Container *cnt) {
+  return cnt->z_prev || ctx->z_head == cnt;
+}
+
+
+static void z_unlink(mu_Context *ctx, mu_Container *cnt) {
+  if (!z_linked(ctx, cnt)) { return; }
+  if (cnt->z_prev) { cnt->z_prev->z_next = cnt->z_next; } else { ctx->z_head = cnt->z_next; }
+  if (cnt->z_next) { cnt->z_next->z_prev = cnt->z_prev; } else { ctx->z_tail = cnt->z_prev; }
+  cnt->z_prev = cnt->z_next = NULL;
+}
+
+
+/* insert by zindex; searching from the top, which is where raised and newly
+** created containers go, so this is O(1) in the common case */
+static void z_link(mu_Context *ctx, mu_Container *cnt) {
+  mu_Container *p = ctx->z_tail;
+  while (p && p->zindex > cnt->zindex) { p = p->z_prev; }
+  cnt->z_prev = p;
+  cnt->z_next = p ? p->z_next : ctx->z_head;
+  if (cnt->z_next) { cnt->z_next->z_prev = cnt; } else { ctx->z_tail = cnt; }
+  if (p) { p->z_next = cnt; } else { ctx->z_head = cnt; }
+}
+
+
 static mu_Container* get_container(mu_Context *ctx, mu_Id id, int opt) {
   mu_Container *cnt;
   /* try to get existing container from pool */
-  int idx = mu_pool_get(ctx, ctx->container_pool, MU_CONTAINERPOOL_SIZE, id);
+  int idx = mu_pool_get(ctx, &ctx->container_pool, id);
   if (idx >= 0) {
-    if (ctx->containers[idx].open || ~opt & MU_OPT_CLOSED) {
-      mu_pool_update(ctx, ctx->container_pool, idx);
+    if (ctx->containers[idx]->open || ~opt & MU_OPT_CLOSED) {
+      mu_pool_update(ctx, &ctx->container_pool, idx);
     }
-    return &ctx->containers[idx];
+    return ctx->containers[idx];
   }
   if (opt & MU_OPT_CLOSED) { return NULL; }
   /* container not found in pool: init new container */
-  idx = mu_pool_init(ctx, ctx->container_pool, MU_CONTAINERPOOL_SIZE, id);
-  cnt = &ctx->containers[idx];
+  idx = mu_pool_init(ctx, &ctx->container_pool, id);
+  grow_containers(ctx);
+  cnt = ctx->containers[idx];
+  /* the slot may be reused from an evicted container */
+  z_unlink(ctx, cnt);
   memset(cnt, 0, sizeof(*cnt));
   cnt->open = 1;
+  cnt->culled_frame = -1; /* not hidden before its first frame */
   mu_bring_to_front(ctx, cnt);
   return cnt;
 }
@@ -336,6 +858,10 @@ mu_Container* mu_get_container(mu_Context *ctx, const char *name) {
 
 void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt) {
   cnt->zindex = ++ctx->last_zindex;
+  if (z_linked(ctx, cnt)) {
+    z_unlink(ctx, cnt);
+    z_link(ctx, cnt);
+  }
 }
 
 
@@ -343,33 +869,134 @@ void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt) {
 ** pool
 **============================================================================*/
 
-int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
-  int i, n = -1, f = ctx->frame;
-  for (i = 0; i < len; i++) {
-    if (items[i].last_update < f) {
-      f = items[i].last_update;
-      n = i;
-    }
+/* items form an intrusive LRU list (head = most recently updated) and are
+** indexed by an open-addressing hash table with linear probing, so lookup,
+** update and reuse of the least recently used item are all O(1). a pool only
+** grows when every item was used in the current frame */
+
+static void lru_unlink(mu_Pool *pool, int i) {
+  mu_PoolItem *it = &pool->items[i];
+  if (it->prev >= 0) { pool->items[it->prev].next = it->next; } else { pool->lru_head = it->next; }
+  if (it->next >= 0) { pool->items[it->next].prev = it->prev; } else { pool->lru_tail = it->prev; }
+}
+
+
+static void lru_push_head(mu_Pool *pool, int i) {
+  mu_PoolItem *it = &pool->items[i];
+  it->prev = -1;
+  it->next = pool->lru_head;
+  if (pool->lru_head >= 0) { pool->items[pool->lru_head].prev = i; } else { pool->lru_tail = i; }
+  pool->lru_head = i;
+}
+
+
+static void lru_push_tail(mu_Pool *pool, int i) {
+  mu_PoolItem *it = &pool->items[i];
+  it->next = -1;
+  it->prev = pool->lru_tail;
+  if (pool->lru_tail >= 0) { pool->items[pool->lru_tail].next = i; } else { pool->lru_head = i; }
+  pool->lru_tail = i;
+}
+
+
+static unsigned pool_slot(mu_Pool *pool, mu_Id id) {
+  return (id * 2654435761u) & pool->table_mask;
+}
+
+
+static void table_insert(mu_Pool *pool, int idx) {
+  unsigned i = pool_slot(pool, pool->items[idx].id);
+  while (pool->table[i]) { i = (i + 1) & pool->table_mask; }
+  pool->table[i] = idx + 1;
+}
+
+
+static int table_find(mu_Pool *pool, mu_Id id) {
+  unsigned i = pool_slot(pool, id);
+  while (pool->table[i] && pool->items[pool->table[i] - 1].id != id) {
+    i = (i + 1) & pool->table_mask;
+  }
+  return i;
+}
+
+
+static void table_remove(mu_Pool *pool, mu_Id id) {
+  unsigned i = table_find(pool, id), j = i, k;
+  if (!pool->table[i]) { return; }
+  /* backward-shift deletion: move later entries of the probe run into the
+  ** hole unless their home slot lies cyclically in (i, j] */
+  for (;;) {
+    j = (j + 1) & pool->table_mask;
+    if (!pool->table[j]) { break; }
+    k = pool_slot(pool, pool->items[pool->table[j] - 1].id);
+    if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) { continue; }
+    pool->table[i] = pool->table[j];
+    i = j;
   }
-  expect(n > -1);
-  items[n].id = id;
-  mu_pool_update(ctx, items, n);
+  pool->table[i] = 0;
+}
+
+
+static void pool_grow(mu_Pool *pool, int cap) {
+  int i, size = 16;
+  mu_PoolItem *items = realloc(pool->items, cap * sizeof(mu_PoolItem));
+  expect(items);
+  pool->items = items;
+  for (i = pool->cap; i < cap; i++) {
+    items[i].id = 0;
+    items[i].last_update = 0;
+    lru_push_tail(pool, i);
+  }
+  pool->cap = cap;
+  /* keep the table at most half full */
+  while (size < cap * 2) { size *= 2; }
+  free(pool->table);
+  pool->table = calloc(size, sizeof(int));
+  expect(pool->table);
+  pool->table_mask = size - 1;
+  for (i = 0; i < cap; i++) {
+    if (items[i].id) { table_insert(pool, i); }
+  }
+}
+
+
+int mu_pool_init(mu_Context *ctx, mu_Pool *pool, mu_Id id) {
+  int n = pool->lru_tail;
+  if (pool->items[n].last_update >= ctx->frame) {
+    pool_grow(pool, pool->cap * 2);
+    n = pool->lru_tail;
+  }
+  if (pool->items[n].id) { table_remove(pool, pool->items[n].id); }
+  pool->items[n].id = id;
+  table_insert(pool, n);
+  mu_pool_update(ctx, pool, n);
   return n;
 }
 
 
-int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id) {
-  int i;
+int mu_pool_get(mu_Context *ctx, mu_Pool *pool, mu_Id id) {
+  int slot = table_find(pool, id);
   unused(ctx);
-  for (i = 0; i < len; i++) {
-    if (items[i].id == id) { return i; }
+  return pool->table[slot] - 1;
+}
+
+
+void mu_pool_update(mu_Context *ctx, mu_Pool *pool, int idx) {
+  pool->items[idx].last_update = ctx->frame;
+  if (pool->lru_head != idx) {
+    lru_unlink(pool, idx);
+    lru_push_head(pool, idx);
   }
-  return -1;
 }
 
 
-void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx) {
-  items[idx].last_update = ctx->frame;
+void mu_pool_remove(mu_Context *ctx, mu_Pool *pool, int idx) {
+  unused(ctx);
+  table_remove(pool, pool->items[idx].id);
+  pool->items[idx].id = 0;
+  pool->items[idx].last_update = 0;
+  lru_unlink(pool, idx);
+  lru_push_tail(pool, idx);
 }
 
 
@@ -377,46 +1004,65 @@ void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx) {
 ** input handlers
 **============================================================================*/
 
-void mu_input_mousemove(mu_Context *ctx, int x, int y) {
-  ctx->mouse_pos = mu_vec2(x, y);
+/* input functions return nonzero if the input could change the ui, that is if
+** a frame should be run for it; input that could not is still recorded. key
+** presses and text always ask for one: without focus they may still be global
+** shortcuts, and left pending they would reach whatever gets focus next */
+
+int mu_input_mousemove(mu_Context *ctx, int x, int y) {
+  mu_Vec2 p = mu_vec2(x, y);
+  if (p.x == ctx->mouse_pos.x && p.y == ctx->mouse_pos.y) { return ctx->redraw; }
+  ctx->mouse_pos = p;
+  if (!ctx->redraw && ((ctx->mouse_down && ctx->focus) || hover_may_change(ctx, p))) {
+    ctx->redraw = 1;
+  }
+  return ctx->redraw;
 }
 
 
-void mu_input_mousedown(mu_Context *ctx, int x, int y, int btn) {
+int mu_input_mousedown(mu_Context *ctx, int x, int y, int btn) {
   mu_input_mousemove(ctx, x, y);
   ctx->mouse_down |= btn;
   ctx->mouse_pressed |= btn;
+  return (ctx->redraw = 1);
 }
 
 
-void mu_input_mouseup(mu_Context *ctx, int x, int y, int btn) {
+int mu_input_mouseup(mu_Context *ctx, int x, int y, int btn) {
   mu_input_mousemove(ctx, x, y);
+  if (ctx->mouse_down & btn) { ctx->redraw = 1; }
   ctx->mouse_down &= ~btn;
+  return ctx->redraw;
 }
 
 
-void mu_input_scroll(mu_Context *ctx, int x, int y) {
+int mu_input_scroll(mu_Context *ctx, int x, int y) {
   ctx->scroll_delta.x += x;
   ctx->scroll_delta.y += y;
+  if (x || y) { ctx->redraw = 1; }
+  return ctx->redraw;
 }
 
 
-void mu_input_keydown(mu_Context *ctx, int key) {
-  ctx->key_pressed |= key;
+int mu_input_keydown(mu_Context *ctx, int key) {
   ctx->key_down |= key;
+  ctx->key_pressed |= key;
+  return (ctx->redraw = 1);
 }
 
 
-void mu_input_keyup(mu_Context *ctx, int key) {
+int mu_input_keyup(mu_Context *ctx, int key) {
   ctx->key_down &= ~key;
+  return ctx->redraw;
 }
 
 
-void mu_input_text(mu_Context *ctx, const char *text) {
+int mu_input_text(mu_Context *ctx, const char *text) {
   int len = strlen(ctx->input_text);
   int size = strlen(text) + 1;
   expect(len + size <= (int) sizeof(ctx->input_text));
   memcpy(ctx->input_text + len, text, size);
+  return (ctx->redraw = 1);
 }
 
 
@@ -424,12 +1070,40 @@ void mu_input_text(mu_Context *ctx, const char *text) {
 ** commandlist
 **============================================================================*/
 
+/* the current chunk is full: link it to the next one (reusing chunks from
+** earlier frames) with a jump command. a command bigger than the chunk size
+** gets a chunk of its own */
+static void next_command_chunk(mu_Context *ctx, int size) {
+  mu_CommandChunk *chunk = ctx->command_list.chunk;
+  mu_CommandChunk *next = chunk->next;
+  mu_JumpCommand *jump = (mu_JumpCommand*) (ctx->command_list.items + ctx->command_list.idx);
+  int need = size + sizeof(mu_JumpCommand);
+  if (!next || next->size < need) {
+    next = new_command_chunk(mu_max(need, ctx->command_list.first->size));
+    next->next = chunk->next;
+    chunk->next = next;
+  }
+  jump->base.type = MU_COMMAND_JUMP;
+  jump->base.size = sizeof(mu_JumpCommand);
+  jump->dst = next + 1;
+  ctx->command_list.total += ctx->command_list.idx + sizeof(mu_JumpCommand);
+  ctx->command_list.chunk = next;
+  ctx->command_list.items = (char*) (next + 1);
+  ctx->command_list.cap = next->size;
+  ctx->command_list.idx = 0;
+}
+
+
 mu_Command* mu_push_command(mu_Context *ctx, int type, int size) {
-  mu_Command *cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
-  expect(ctx->command_list.idx + size < MU_COMMANDLIST_SIZE);
+  mu_Command *cmd;
+  if (ctx->command_list.idx + size + (int) sizeof(mu_JumpCommand) > ctx->command_list.cap) {
+    next_command_chunk(ctx, size);
+  }
+  cmd = (mu_Command*) (ctx->command_list.items + ctx->command_list.idx);
   cmd->base.type = type;
   cmd->base.size = size;
   ctx->command_list.idx += size;
+  STAT_ADD(commands[type], 1);
   return cmd;
 }
 
@@ -438,7 +1112,7 @@ int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
   if (*cmd) {
     *cmd = (mu_Command*) (((char*) *cmd) + (*cmd)->base.size);
   } else {
-    *cmd = (mu_Command*) ctx->command_list.items;
+    *cmd = (mu_Command*) (ctx->command_list.first + 1);
   }
   while ((char*) *cmd != ctx->command_list.items + ctx->command_list.idx) {
     if ((*cmd)->type != MU_COMMAND_JUMP) { return 1; }
@@ -448,6 +1122,41 @@ int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
 }
 
 
+/* hash a filled command's contents (not its jump pointers or padding) into
+** the current root container's hash */
+static void hash_command(mu_Context *ctx, mu_Command *cmd) {
+  mu_Id *h = ctx->command_hash;
+  hash(h, &cmd->type, sizeof(cmd->type));
+  switch (cmd->type) {
+    case MU_COMMAND_CLIP:
+      hash(h, &cmd->clip.rect, sizeof(mu_Rect));
+      break;
+    case MU_COMMAND_RECT:
+      hash(h, &cmd->rect.rect, sizeof(mu_Rect));
+      hash(h, &cmd->rect.color, sizeof(mu_Color));
+      break;
+    case MU_COMMAND_TEXT:
+      hash(h, &cmd->text.font, sizeof(mu_Font));
+      hash(h, &cmd->text.pos, sizeof(mu_Vec2));
+      hash(h, &cmd->text.color, sizeof(mu_Color));
+      hash(h, cmd->text.str, cmd->base.size - sizeof(mu_TextCommand));
+      break;
+    case MU_COMMAND_ICON:
+      hash(h, &cmd->icon.id, sizeof(int));
+      hash(h, &cmd->icon.rect, sizeof(mu_Rect));
+      hash(h, &cmd->icon.color, sizeof(mu_Color));
+      break;
+    case MU_COMMAND_GLYPHS:
+      hash(h, &cmd->glyphs.font, sizeof(mu_Font));
+      hash(h, &cmd->glyphs.pos, sizeof(mu_Vec2));
+      hash(h, &cmd->glyphs.color, sizeof(mu_Color));
+      /* the glyphs are a function of the source text, which mu_draw_text()
+      ** hashes instead as it is several times smaller */
+      break;
+  }
+}
+
+
 static mu_Command* push_jump(mu_Context *ctx, mu_Command *dst) {
   mu_Command *cmd;
   cmd = mu_push_command(ctx, MU_COMMAND_JUMP, sizeof(mu_JumpCommand));
@@ -460,6 +1169,7 @@ void mu_set_clip(mu_Context *ctx, mu_Rect rect) {
   mu_Command *cmd;
   cmd = mu_push_command(ctx, MU_COMMAND_CLIP, sizeof(mu_ClipCommand));
   cmd->clip.rect = rect;
+  hash_command(ctx, cmd);
 }
 
 
@@ -470,6 +1180,7 @@ void mu_draw_rect(mu_Context *ctx, mu_Rect rect, mu_Color color) {
     cmd = mu_push_command(ctx, MU_COMMAND_RECT, sizeof(mu_RectCommand));
     cmd->rect.rect = rect;
     cmd->rect.color = color;
+    hash_command(ctx, cmd);
   }
 }
 
@@ -486,19 +1197,49 @@ void mu_draw_text(mu_Context *ctx, mu_Font font, const char *str, int len,
   mu_Vec2 pos, mu_Color color)
 {
   mu_Command *cmd;
-  mu_Rect rect = mu_rect(
-    pos.x, pos.y, ctx->text_width(font, str, len), ctx->text_height(font));
-  int clipped = mu_check_clip(ctx, rect);
+  mu_Rect rect;
+  int clipped, width, count = 0;
+  /* nothing can show: skip measuring */
+  rect = mu_get_clip_rect(ctx);
+  if (rect.w <= 0 || rect.h <= 0) { return; }
+  if (len < 0) { len = strlen(str); }
+  if (ctx->text_glyphs) {
+    /* decode once here; measuring and rasterizing both use the result */
+    int size = mu_max(len, 1) * ctx->glyph_size;
+    if (size > ctx->glyph_cap) {
+      char *p = realloc(ctx->glyph_buf, size);
+      expect(p);
+      ctx->glyph_buf = p;
+      ctx->glyph_cap = size;
+    }
+    count = ctx->text_glyphs(font, str, len, ctx->glyph_buf, &width);
+  } else {
+    width = ctx->text_width(font, str, len);
+  }
+  rect = mu_rect(pos.x, pos.y, width, ctx->text_height(font));
+  clipped = mu_check_clip(ctx, rect);
   if (clipped == MU_CLIP_ALL ) { return; }
   if (clipped == MU_CLIP_PART) { mu_set_clip(ctx, mu_get_clip_rect(ctx)); }
   /* add command */
-  if (len < 0) { len = strlen(str); }
-  cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand) + len);
-  memcpy(cmd->text.str, str, len);
-  cmd->text.str[len] = '\0';
-  cmd->text.pos = pos;
-  cmd->text.color = color;
-  cmd->text.font = font;
+  if (ctx->text_glyphs) {
+    cmd = mu_push_command(ctx, MU_COMMAND_GLYPHS,
+      sizeof(mu_GlyphCommand) + count * ctx->glyph_size);
+    memcpy(cmd->glyphs.glyphs, ctx->glyph_buf, count * ctx->glyph_size);
+    cmd->glyphs.width = width;
+    cmd->glyphs.count = count;
+    cmd->glyphs.pos = pos;
+    cmd->glyphs.color = color;
+    cmd->glyphs.font = font;
+    hash(ctx->command_hash, str, len);
+  } else {
+    cmd = mu_push_command(ctx, MU_COMMAND_TEXT, sizeof(mu_TextCommand) + len);
+    memcpy(cmd->text.str, str, len);
+    cmd->text.str[len] = '\0';
+    cmd->text.pos = pos;
+    cmd->text.color = color;
+    cmd->text.font = font;
+  }
+  hash_command(ctx, cmd);
   /* reset clipping if it was set */
   if (clipped) { mu_set_clip(ctx, unclipped_rect); }
 }
@@ -515,6 +1256,7 @@ void mu_draw_icon(mu_Context *ctx, int id, mu_Rect rect, mu_Color color) {
   cmd->icon.id = id;
   cmd->icon.rect = rect;
   cmd->icon.color = color;
+  hash_command(ctx, cmd);
   /* reset clipping if it was set */
   if (clipped) { mu_set_clip(ctx, unclipped_rect); }
 }
@@ -624,6 +1366,47 @@ mu_Rect mu_layout_next(mu_Context *ctx) {
 }
 
 
+/* virtualized list: each of `count` items is one layout row of `height`.
+** only rows touching the clip rect, [lc->start, lc->end), need to be laid
+** out by the caller; the rest are skipped by moving the row cursor, and the
+** layout extent (and thus the container's content_size) covers all of them */
+void mu_layout_begin_list(mu_Context *ctx, mu_ListClipper *lc, int count, int height) {
+  mu_Layout *layout = get_layout(ctx);
+  mu_Rect clip = mu_get_clip_rect(ctx);
+  int top, bottom;
+  if (height <= 0) { height = ctx->style->size.y + ctx->style->padding * 2; }
+  lc->count = mu_max(count, 0);
+  lc->height = height;
+  lc->stride = height + ctx->style->spacing;
+  lc->base = layout->next_row;
+  /* same test as mu_check_clip(): a row is visible unless it lies entirely
+  ** above or below the clip rect */
+  top = clip.y - (layout->body.y + lc->base) - height;
+  bottom = clip.y + clip.h - (layout->body.y + lc->base);
+  lc->start = top <= 0 ? 0 : (top + lc->stride - 1) / lc->stride;
+  lc->end = bottom < 0 ? 0 : bottom / lc->stride + 1;
+  lc->start = mu_min(lc->start, lc->count);
+  lc->end = mu_clamp(lc->end, lc->start, lc->count);
+  layout->next_row = lc->base + lc->start * lc->stride;
+  mu_layout_row(ctx, layout->items, NULL, height);
+}
+
+
+void mu_layout_end_list(mu_Context *ctx, mu_ListClipper *lc) {
+  mu_Layout *layout = get_layout(ctx);
+  int i, bottom = lc->base + lc->count * lc->stride;
+  if (lc->count == 0) { return; }
+  /* nothing visible: lay out one row anyway so the width is accounted for */
+  if (lc->start == lc->end) {
+    layout->next_row = lc->base + mu_min(lc->start, lc->count - 1) * lc->stride;
+    mu_layout_row(ctx, layout->items, NULL, lc->height);
+    for (i = 0; i < mu_max(layout->items, 1); i++) { mu_layout_next(ctx); }
+  }
+  layout->max.y = mu_max(layout->max.y, layout->body.y + bottom - ctx->style->spacing);
+  layout->next_row = mu_max(layout->next_row, bottom);
+}
+
+
 /*============================================================================
 ** controls
 **============================================================================*/
@@ -670,9 +1453,11 @@ void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect,
 
 
 int mu_mouse_over(mu_Context *ctx, mu_Rect rect) {
-  return rect_overlaps_vec2(rect, ctx->mouse_pos) &&
-    rect_overlaps_vec2(mu_get_clip_rect(ctx), ctx->mouse_pos) &&
-    in_hover_root(ctx);
+  /* outside the hover root the answer is 0 until the hover root changes */
+  if (!in_hover_root(ctx)) { return 0; }
+  rect = intersect_rects(rect, mu_get_clip_rect(ctx));
+  hit_grid_put(&ctx->control_grid, ctx->control_count++, rect);
+  return rect_overlaps_vec2(rect, ctx->mouse_pos);
 }
 
 
@@ -927,7 +1712,7 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
   mu_Rect r;
   int active, expanded;
   mu_Id id = mu_get_id(ctx, label, strlen(label));
-  int idx = mu_pool_get(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
+  int idx = mu_pool_get(ctx, &ctx->treenode_pool, id);
   int width = -1;
   mu_layout_row(ctx, 1, &width, 0);
 
@@ -941,10 +1726,10 @@ static int header(mu_Context *ctx, const char *label, int istreenode, int opt) {
 
   /* update pool ref */
   if (idx >= 0) {
-    if (active) { mu_pool_update(ctx, ctx->treenode_pool, idx); }
-           else { memset(&ctx->treenode_pool[idx], 0, sizeof(mu_PoolItem)); }
+    if (active) { mu_pool_update(ctx, &ctx->treenode_pool, idx); }
+           else { mu_pool_remove(ctx, &ctx->treenode_pool, idx); }
   } else if (active) {
-    mu_pool_init(ctx, ctx->treenode_pool, MU_TREENODEPOOL_SIZE, id);
+    mu_pool_init(ctx, &ctx->treenode_pool, id);
   }
 
   /* draw */
@@ -1053,18 +1838,23 @@ static void begin_root_container(mu_Context *ctx, mu_Container *cnt) {
   push(ctx->container_stack, cnt);
   /* push container to roots list and push head command */
   push(ctx->root_list, cnt);
+  cnt->root_frame = ctx->frame;
+  if (!z_linked(ctx, cnt)) { z_link(ctx, cnt); }
   cnt->head = push_jump(ctx, NULL);
-  /* set as hover root if the mouse is overlapping this container and it has a
-  ** higher zindex than the current hover root */
-  if (rect_overlaps_vec2(cnt->rect, ctx->mouse_pos) &&
-      (!ctx->next_hover_root || cnt->zindex > ctx->next_hover_root->zindex)
-  ) {
-    ctx->next_hover_root = cnt;
-  }
+  /* commands pushed from here until the matching end are hashed into this
+  ** container */
+  cnt->hash = HASH_INITIAL;
+  ctx->command_hash = &cnt->hash;
   /* clipping is reset here in case a root-container is made within
   ** another root-containers's begin/end block; this prevents the inner
-  ** root-container being clipped to the outer */
-  push(ctx->clip_stack, unclipped_rect);
+  ** root-container being clipped to the outer. a root that was hidden at the
+  ** end of last frame gets an empty clip rect instead: its code still runs,
+  ** but draws nothing */
+  if (cnt->culled_frame == ctx->frame - 1) {
+    push(ctx->clip_stack, mu_rect(0, 0, 0, 0));
+  } else {
+    push(ctx->clip_stack, unclipped_rect);
+  }
 }
 
 
@@ -1072,11 +1862,20 @@ static void end_root_container(mu_Context *ctx) {
   /* push tail 'goto' jump command and set head 'skip' command. the final steps
   ** on initing these are done in mu_end() */
   mu_Container *cnt = mu_get_current_container(ctx);
+  int i;
   cnt->tail = push_jump(ctx, NULL);
   cnt->head->jump.dst = ctx->command_list.items + ctx->command_list.idx;
   /* pop base clip rect and container */
   mu_pop_clip_rect(ctx);
   pop_container(ctx);
+  /* resume hashing into the enclosing root container, if any */
+  ctx->command_hash = &ctx->loose_hash;
+  for (i = ctx->container_stack.idx - 1; i >= 0; i--) {
+    if (ctx->container_stack.items[i]->head) {
+      ctx->command_hash = &ctx->container_stack.items[i]->hash;
+      break;
+    }
+  }
 }
 
 
@@ -1085,9 +1884,9 @@ int mu_begin_window_ex(mu_Context *ctx, const char *title, mu_Rect rect, int opt
   mu_Id id = mu_get_id(ctx, title, strlen(title));
   mu_Container *cnt = get_container(ctx, id, opt);
   if (!cnt || !cnt->open) { return 0; }
-  push(ctx->id_stack, id);
-
   if (cnt->rect.w == 0) { cnt->rect = rect; }
+  push(ctx->id_stack, id);
+  cnt->opaque = !(opt & MU_OPT_NOFRAME);
   begin_root_container(ctx, cnt);
   rect = body = cnt->rect;
 
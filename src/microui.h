@@ -10,6 +10,8 @@
 
 #define MU_VERSION "2.02"
 
+/* default initial sizes (see mu_Config); the command list, stacks and pools
+** all grow as needed */
 #define MU_COMMANDLIST_SIZE     (256 * 1024)
 #define MU_ROOTLIST_SIZE        32
 #define MU_CONTAINERSTACK_SIZE  32
@@ -19,12 +21,14 @@
 #define MU_CONTAINERPOOL_SIZE   48
 #define MU_TREENODEPOOL_SIZE    48
 #define MU_MAX_WIDTHS           16
+#define MU_CULL_RECTS           32
+#define MU_HITGRID_SIZE         16
 #define MU_REAL                 float
 #define MU_REAL_FMT             "%.3g"
 #define MU_SLIDER_FMT           "%.2f"
 #define MU_MAX_FMT              127
 
-#define mu_stack(T, n)          struct { int idx; T items[n]; }
+#define mu_stack(T)             struct { int idx, cap; T *items; }
 #define mu_min(a, b)            ((a) < (b) ? (a) : (b))
 #define mu_max(a, b)            ((a) > (b) ? (a) : (b))
 #define mu_clamp(x, a, b)       mu_min(b, mu_max(a, x))
@@ -40,6 +44,7 @@ enum {
   MU_COMMAND_RECT,
   MU_COMMAND_TEXT,
   MU_COMMAND_ICON,
+  MU_COMMAND_GLYPHS,
   MU_COMMAND_MAX
 };
 
@@ -102,7 +107,16 @@ enum {
   MU_KEY_CTRL         = (1 << 1),
   MU_KEY_ALT          = (1 << 2),
   MU_KEY_BACKSPACE    = (1 << 3),
-  MU_KEY_RETURN       = (1 << 4)
+  MU_KEY_RETURN       = (1 << 4),
+  MU_KEY_DELETE       = (1 << 5),
+  MU_KEY_LEFT         = (1 << 6),
+  MU_KEY_RIGHT        = (1 << 7),
+  MU_KEY_UP           = (1 << 8),
+  MU_KEY_DOWN         = (1 << 9),
+  MU_KEY_HOME         = (1 << 10),
+  MU_KEY_END          = (1 << 11),
+  MU_KEY_PAGEUP       = (1 << 12),
+  MU_KEY_PAGEDOWN     = (1 << 13)
 };
 
 
@@ -114,7 +128,35 @@ typedef void* mu_Font;
 typedef struct { int x, y; } mu_Vec2;
 typedef struct { int x, y, w, h; } mu_Rect;
 typedef struct { unsigned char r, g, b, a; } mu_Color;
-typedef struct { mu_Id id; int last_update; } mu_PoolItem;
+typedef struct { mu_Id id; int last_update; int prev, next; } mu_PoolItem;
+
+typedef struct {
+  mu_PoolItem *items;
+  int *table;           /* open-addressing id -> item index + 1, 0 is empty */
+  int cap, table_mask;
+  int lru_head;         /* most recently updated item */
+  int lru_tail;         /* least recently updated item, reused first */
+} mu_Pool;
+
+/* initial capacities for mu_init_ex(); fields left at zero take the MU_*
+** defaults above. command_list_size is also the size of each chunk added when
+** a frame needs more. `cull` turns on occlusion culling (see mu_Context) */
+typedef struct {
+  int container_pool_size;
+  int treenode_pool_size;
+  int command_list_size;
+  int root_list_size;
+  int container_stack_size;
+  int clip_stack_size;
+  int id_stack_size;
+  int layout_stack_size;
+  int cull;
+} mu_Config;
+
+typedef struct mu_CommandChunk {
+  struct mu_CommandChunk *next;
+  int size;             /* followed by `size` bytes of commands */
+} mu_CommandChunk;
 
 typedef struct { int type, size; } mu_BaseCommand;
 typedef struct { mu_BaseCommand base; void *dst; } mu_JumpCommand;
@@ -122,6 +164,8 @@ typedef struct { mu_BaseCommand base; mu_Rect rect; } mu_ClipCommand;
 typedef struct { mu_BaseCommand base; mu_Rect rect; mu_Color color; } mu_RectCommand;
 typedef struct { mu_BaseCommand base; mu_Font font; mu_Vec2 pos; mu_Color color; char str[1]; } mu_TextCommand;
 typedef struct { mu_BaseCommand base; mu_Rect rect; int id; mu_Color color; } mu_IconCommand;
+/* text already decoded by `text_glyphs`: `count` glyphs of `glyph_size` bytes */
+typedef struct { mu_BaseCommand base; mu_Font font; mu_Vec2 pos; mu_Color color; int width, count; char glyphs[1]; } mu_GlyphCommand;
 
 typedef union {
   int type;
@@ -131,6 +175,7 @@ typedef union {
   mu_RectCommand rect;
   mu_TextCommand text;
   mu_IconCommand icon;
+  mu_GlyphCommand glyphs;
 } mu_Command;
 
 typedef struct {
@@ -148,6 +193,12 @@ typedef struct {
 } mu_Layout;
 
 typedef struct {
+  int count, height, stride;
+  int base;             /* layout row of the first item */
+  int start, end;       /* visible items are [start, end) */
+} mu_ListClipper;
+
+typedef struct mu_Container {
   mu_Command *head, *tail;
   mu_Rect rect;
   mu_Rect body;
@@ -155,8 +206,27 @@ typedef struct {
   mu_Vec2 scroll;
   int zindex;
   int open;
+  mu_Id hash;
+  int root_frame;
+  int opaque;           /* window background covers `rect` */
+  int culled_frame;     /* last frame it was hidden; the next builds no commands */
+  struct mu_Container *z_prev, *z_next;
 } mu_Container;
 
+/* rects bucketed over their bounding box: MU_HITGRID_SIZE^2 buckets of
+** `cell` cells over `bounds`, bucket `i` lists the indices of the rects
+** touching it in ascending order as items[start[i] .. start[i + 1]) */
+typedef struct {
+  mu_Rect *rects;
+  int count, cap;
+  int built;            /* buckets are up to date with `rects` */
+  mu_Rect bounds;
+  mu_Vec2 cell;
+  int start[MU_HITGRID_SIZE * MU_HITGRID_SIZE + 1];
+  int *items;
+  int item_cap;
+} mu_HitGrid;
+
 typedef struct {
   mu_Font font;
   mu_Vec2 size;
@@ -170,37 +240,18 @@ typedef struct {
 } mu_Style;
 
 struct mu_Context {
-  /* callbacks */
-  int (*text_width)(mu_Font font, const char *str, int len);
-  int (*text_height)(mu_Font font);
-  void (*draw_frame)(mu_Context *ctx, mu_Rect rect, int colorid);
-  /* core state */
-  mu_Style _style;
-  mu_Style *style;
+  /* hot: core and input state touched by every widget */
+  int frame;
   mu_Id hover;
   mu_Id focus;
   mu_Id last_id;
   mu_Rect last_rect;
-  int last_zindex;
   int updated_focus;
-  int frame;
+  mu_Style *style;
+  mu_Id *command_hash;
   mu_Container *hover_root;
   mu_Container *next_hover_root;
   mu_Container *scroll_target;
-  char number_edit_buf[MU_MAX_FMT];
-  mu_Id number_edit;
-  /* stacks */
-  mu_stack(char, MU_COMMANDLIST_SIZE) command_list;
-  mu_stack(mu_Container*, MU_ROOTLIST_SIZE) root_list;
-  mu_stack(mu_Container*, MU_CONTAINERSTACK_SIZE) container_stack;
-  mu_stack(mu_Rect, MU_CLIPSTACK_SIZE) clip_stack;
-  mu_stack(mu_Id, MU_IDSTACK_SIZE) id_stack;
-  mu_stack(mu_Layout, MU_LAYOUTSTACK_SIZE) layout_stack;
-  /* retained state pools */
-  mu_PoolItem container_pool[MU_CONTAINERPOOL_SIZE];
-  mu_Container containers[MU_CONTAINERPOOL_SIZE];
-  mu_PoolItem treenode_pool[MU_TREENODEPOOL_SIZE];
-  /* input state */
   mu_Vec2 mouse_pos;
   mu_Vec2 last_mouse_pos;
   mu_Vec2 mouse_delta;
@@ -209,17 +260,79 @@ struct mu_Context {
   int mouse_pressed;
   int key_down;
   int key_pressed;
+  /* redraw tracking */
+  int redraw;
+  mu_Id frame_hover, frame_focus;
+  /* callbacks */
+  int (*text_width)(mu_Font font, const char *str, int len);
+  int (*text_height)(mu_Font font);
+  void (*draw_frame)(mu_Context *ctx, mu_Rect rect, int colorid);
+  /* optional: decode `len` bytes into at most `len` glyphs of `glyph_size`
+  ** bytes and return the glyph count, storing the total width; when set,
+  ** text is pushed as MU_COMMAND_GLYPHS instead of MU_COMMAND_TEXT */
+  int (*text_glyphs)(mu_Font font, const char *str, int len, void *glyphs, int *width);
+  int glyph_size;
+  /* a root outside `viewport` or hidden behind opaque roots above it builds
+  ** no commands the next frame. occlusion culling, off unless asked for in
+  ** mu_Config, also has mu_end() drop such roots from the draw chain and the
+  ** covered commands of the others */
+  int cull;
+  mu_Rect viewport;
+  /* stacks; the command list is a chain of chunks so command pointers stay
+  ** valid when it grows, `items`/`idx`/`cap` describe the current chunk */
+  struct {
+    char *items;
+    int idx, cap;
+    int total;          /* bytes in the chunks before the current one */
+    mu_CommandChunk *first, *chunk;
+  } command_list;
+  mu_stack(mu_Container*) root_list;
+  mu_stack(mu_Container*) container_stack;
+  mu_stack(mu_Rect) clip_stack;
+  mu_stack(mu_Id) id_stack;
+  mu_stack(mu_Layout) layout_stack;
+  /* retained state pools */
+  mu_Pool container_pool;
+  mu_Container **containers;
+  mu_Container **container_chunks;
+  int container_chunk_count, container_chunk_cap, container_cap;
+  mu_Pool treenode_pool;
+  /* the roots of this frame and the last in z-order, back to front; kept
+  ** sorted as containers are raised, created and begun */
+  mu_Container *z_head, *z_tail;
+  /* cold */
+  int last_zindex;
+  mu_Id frame_hash;
+  mu_Id last_frame_hash;
+  mu_Id loose_hash;
+  mu_Style _style;
+  char *glyph_buf;
+  int glyph_cap;
+  /* hit-test grids over last frame's root rects (back to front, the roots
+  ** in `grid_roots`) and the rects tested by controls in its hover root;
+  ** `control_count` counts the current frame's */
+  mu_HitGrid root_grid, control_grid;
+  mu_stack(mu_Container*) grid_roots;
+  int control_count;
+  char number_edit_buf[MU_MAX_FMT];
+  mu_Id number_edit;
   char input_text[32];
 };
 
 
+
 mu_Vec2 mu_vec2(int x, int y);
 mu_Rect mu_rect(int x, int y, int w, int h);
 mu_Color mu_color(int r, int g, int b, int a);
 
 void mu_init(mu_Context *ctx);
+void mu_init_ex(mu_Context *ctx, const mu_Config *config);
+void mu_release(mu_Context *ctx);
 void mu_begin(mu_Context *ctx);
-void mu_end(mu_Context *ctx);
+int mu_end(mu_Context *ctx);
+int mu_frame_changed(mu_Context *ctx);
+int mu_needs_frame(mu_Context *ctx);
+void mu_request_frame(mu_Context *ctx);
 void mu_set_focus(mu_Context *ctx, mu_Id id);
 mu_Id mu_get_id(mu_Context *ctx, const void *data, int size);
 void mu_push_id(mu_Context *ctx, const void *data, int size);
@@ -232,17 +345,18 @@ mu_Container* mu_get_current_container(mu_Context *ctx);
 mu_Container* mu_get_container(mu_Context *ctx, const char *name);
 void mu_bring_to_front(mu_Context *ctx, mu_Container *cnt);
 
-int mu_pool_init(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
-int mu_pool_get(mu_Context *ctx, mu_PoolItem *items, int len, mu_Id id);
-void mu_pool_update(mu_Context *ctx, mu_PoolItem *items, int idx);
+int mu_pool_init(mu_Context *ctx, mu_Pool *pool, mu_Id id);
+int mu_pool_get(mu_Context *ctx, mu_Pool *pool, mu_Id id);
+void mu_pool_update(mu_Context *ctx, mu_Pool *pool, int idx);
+void mu_pool_remove(mu_Context *ctx, mu_Pool *pool, int idx);
 
-void mu_input_mousemove(mu_Context *ctx, int x, int y);
-void mu_input_mousedown(mu_Context *ctx, int x, int y, int btn);
-void mu_input_mouseup(mu_Context *ctx, int x, int y, int btn);
-void mu_input_scroll(mu_Context *ctx, int x, int y);
-void mu_input_keydown(mu_Context *ctx, int key);
-void mu_input_keyup(mu_Context *ctx, int key);
-void mu_input_text(mu_Context *ctx, const char *text);
+int mu_input_mousemove(mu_Context *ctx, int x, int y);
+int mu_input_mousedown(mu_Context *ctx, int x, int y, int btn);
+int mu_input_mouseup(mu_Context *ctx, int x, int y, int btn);
+int mu_input_scroll(mu_Context *ctx, int x, int y);
+int mu_input_keydown(mu_Context *ctx, int key);
+int mu_input_keyup(mu_Context *ctx, int key);
+int mu_input_text(mu_Context *ctx, const char *text);
 
 mu_Command* mu_push_command(mu_Context *ctx, int type, int size);
 int mu_next_command(mu_Context *ctx, mu_Command **cmd);
@@ -259,6 +373,8 @@ void mu_layout_begin_column(mu_Context *ctx);
 void mu_layout_end_column(mu_Context *ctx);
 void mu_layout_set_next(mu_Context *ctx, mu_Rect r, int relative);
 mu_Rect mu_layout_next(mu_Context *ctx);
+void mu_layout_begin_list(mu_Context *ctx, mu_ListClipper *lc, int count, int height);
+void mu_layout_end_list(mu_Context *ctx, mu_ListClipper *lc);
 
 void mu_draw_control_frame(mu_Context *ctx, mu_Id id, mu_Rect rect, int colorid, int opt);
 void mu_draw_control_text(mu_Context *ctx, const char *str, mu_Rect rect, int colorid, int opt);
@@ -1,43 +1,130 @@
-#ifndef MINITEST_H
-#define MINITEST_H
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-
-extern void *__start_testsec;
-extern void *__stop_testsec;
-typedef void (*TestFn)(void);
-typedef struct { const char *name; TestFn fn; } Test;
-#define TEST(suite, name)                       \
-    static void suite##_##name(void);           \
-    static const Test __t_##suite##name         \
-        __attribute__((section("testsec"))) = { \
-            #suite "." #name, suite##_##name }; \
-    static void suite##_##name(void)
-
-#define ASSERT(cond)      do { if (!(cond)) { printf("FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond); exit(1); } } while (0)
-#define ASSERT_TRUE(x)    ASSERT(x)
-#define ASSERT_EQ(a, b)   ASSERT((a) == (b))
-#define ASSERT_STREQ(a,b) ASSERT(strcmp((a),(b)) == 0)
-
-#define RUN_ALL_TESTS()                                                     \
-    do {                                                                    \
-        Test *b = (Test*)&__start_testsec, *e = (Test*)&__stop_testsec;     \
-        size_t n = e - b;                                                   \
-        if (!n) { puts("No tests"); break; }                                \
-        printf("\n\033[36m===== Tests =====\033[0m\n");                     \
-        for (size_t i = 0; i < n; ++i) printf("\033[33m%2zu\033[0m : %s\n", i + 1, b[i].name); \
-        printf("\033[35m# (0=all, ENTER=quit): \033[0m"); fflush(stdout);   \
-        int c = getchar();                                                  \
-        if (c == '\n' || c == EOF) break;                                   \
-        ungetc(c, stdin);                                                   \
-        int k;  if (scanf("%d", &k) != 1) break;                            \
-        while (getchar() != '\n');  /* 吃掉行尾 */                           \
-        if (k < 0 || (size_t)k > n) { puts("\033[31mBad#\033[0m"); break; } \
-        for (size_t i = (k ? k - 1 : 0), lim = (k ? i + 1 : n); i < lim; ++i) { \
-            printf("\033[32m[ RUN ]\033[0m %s\n", b[i].name); b[i].fn();    \
-            printf("\033[32m[  OK ]\033[0m %s\n", b[i].name);               \
-        }                                                                   \
-    } while (0)
-
-#endif /* MINITEST_H */
\ No newline at end of file
+#ifndef MINITEST_H
+#define MINITEST_H
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "timer.h"
+
+typedef void (*TestFn)(void);
+typedef struct { const char *name; TestFn fn; int bench; } Test;
+/* 链接器给 testsec 段生成的首尾符号; 声明成未知长度的数组, 编译器不会按单个对象的大小去限定遍历 */
+extern const Test __start_testsec[];
+extern const Test __stop_testsec[];
+/* 显式对齐: 否则编译器可能把较大的静态对象按 32 字节对齐, 段内出现空洞 */
+#define TEST_ENTRY(suite, name, bench)                \
+    static void suite##_##name(void);                 \
+    static const Test __t_##suite##name               \
+        __attribute__((used, section("testsec"), aligned(sizeof(void*)))) = { \
+            #suite "." #name, suite##_##name, bench };\
+    static void suite##_##name(void)
+
+#define TEST(suite, name)  TEST_ENTRY(suite, name, 0)
+/* 基准: 函数体是一次操作, 由运行器反复调用; 结果用 BENCH_KEEP 留住, 免得被优化掉 */
+#define BENCH(suite, name) TEST_ENTRY(suite, name, 1)
+
+#define ASSERT(cond)      do { if (!(cond)) { printf("FAIL %s:%d  %s\n", __FILE__, __LINE__, #cond); exit(1); } } while (0)
+#define ASSERT_TRUE(x)    ASSERT(x)
+#define ASSERT_EQ(a, b)   ASSERT((a) == (b))
+#define ASSERT_STREQ(a,b) ASSERT(strcmp((a),(b)) == 0)
+
+static volatile long long mt_sink __attribute__((unused));
+#define BENCH_KEEP(x)     (mt_sink += (long long)(x))
+
+#define MT_BENCH_BATCH_NS 2000000LL     /* 每批至少 2ms */
+#define MT_BENCH_WARMUP   3
+#define MT_BENCH_SAMPLES  31
+
+static inline int mt_cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* 先倍增批大小到 MT_BENCH_BATCH_NS, 预热几批, 再按批采样单次耗时 */
+static inline void mt_bench(const Test *t) {
+    double s[MT_BENCH_SAMPLES];
+    long long n = 1, dt;
+    for (;;) {
+        long long t0 = timer_ns();
+        for (long long i = 0; i < n; ++i) t->fn();
+        dt = timer_ns() - t0;
+        if (dt >= MT_BENCH_BATCH_NS || n >= (1LL << 40)) break;
+        n *= 2;
+    }
+    for (int k = 0; k < MT_BENCH_WARMUP; ++k)
+        for (long long i = 0; i < n; ++i) t->fn();
+    for (int k = 0; k < MT_BENCH_SAMPLES; ++k) {
+        long long t0 = timer_ns();
+        for (long long i = 0; i < n; ++i) t->fn();
+        s[k] = (double)(timer_ns() - t0) / n;
+    }
+    qsort(s, MT_BENCH_SAMPLES, sizeof(s[0]), mt_cmp_double);
+    double med = s[MT_BENCH_SAMPLES / 2], p95 = s[(MT_BENCH_SAMPLES * 95 + 99) / 100 - 1];
+    printf("        median %10.1f ns   p95 %10.1f ns   %12.0f ops/s   (batch %lld)\n",
+           med, p95, med > 0 ? 1e9 / med : 0.0, n);
+}
+
+static inline void mt_run(const Test *t) {
+    printf("\033[32m[%s]\033[0m %s\n", t->bench ? "BENCH" : " RUN ", t->name);
+    fflush(stdout);
+    long long t0 = timer_ns();
+    if (t->bench) mt_bench(t);
+    else          t->fn();
+    printf("\033[32m[  OK ]\033[0m %s (%.1f ms)\n", t->name, (timer_ns() - t0) / 1e6);
+}
+
+/* 名字过滤: 普通参数为包含的子串(任一命中即可), "-子串" 为排除; 没有包含项时默认全选 */
+static inline int mt_match(const char *name, int argc, char **argv) {
+    int has_inc = 0, inc = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if (a[0] == '-' && a[1] == '-') continue;
+        if (a[0] == '-') { if (a[1] && strstr(name, a + 1)) return 0; continue; }
+        has_inc = 1;
+        if (strstr(name, a)) inc = 1;
+    }
+    return !has_inc || inc;
+}
+
+/* 非交互模式: test_main [--list] [子串 | -子串]... */
+static inline int mt_run_cli(int argc, char **argv) {
+    const Test *b = __start_testsec, *e = __stop_testsec;
+    int list = 0, ran = 0;
+    for (int i = 1; i < argc; ++i) if (!strcmp(argv[i], "--list")) list = 1;
+    long long t0 = timer_ns();
+    for (const Test *t = b; t < e; ++t) {
+        if (!mt_match(t->name, argc, argv)) continue;
+        if (list) printf("%s%s\n", t->name, t->bench ? " (bench)" : "");
+        else      mt_run(t);
+        ran++;
+    }
+    if (!list) printf("\033[36m===== %d ran, %.1f ms =====\033[0m\n", ran, (timer_ns() - t0) / 1e6);
+    return ran;
+}
+
+#define RUN_ALL_TESTS()                                                     \
+    do {                                                                    \
+        const Test *b = __start_testsec, *e = __stop_testsec;               \
+        size_t n = e - b;                                                   \
+        if (!n) { puts("No tests"); break; }                                \
+        printf("\n\033[36m===== Tests =====\033[0m\n");                     \
+        for (size_t i = 0; i < n; ++i) printf("\033[33m%2zu\033[0m : %s%s\n", i + 1, b[i].name, b[i].bench ? " (bench)" : ""); \
+        printf("\033[35m# (0=all tests, ENTER=quit): \033[0m"); fflush(stdout); \
+        int c = getchar();                                                  \
+        if (c == '\n' || c == EOF) break;                                   \
+        ungetc(c, stdin);                                                   \
+        int k;  if (scanf("%d", &k) != 1) break;                            \
+        while (getchar() != '\n');  /* 吃掉行尾 */                           \
+        if (k < 0 || (size_t)k > n) { puts("\033[31mBad#\033[0m"); break; } \
+        /* 0 只跑测试; 基准很慢, 按编号单独选 */                             \
+        for (size_t i = (k ? k - 1 : 0), lim = (k ? i + 1 : n); i < lim; ++i) \
+            if (k || !b[i].bench) mt_run(&b[i]);                            \
+    } while (0)
+
+/* 带参数时走非交互模式, 否则保持交互选择 */
+#define RUN_TESTS(argc, argv)                                               \
+    do {                                                                    \
+        if ((argc) > 1) mt_run_cli((argc), (argv));                         \
+        else            RUN_ALL_TESTS();                                    \
+    } while (0)
+
+#endif /* MINITEST_H */
@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+#include "prof.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__) || defined(__i386__))
+#define BT_WALK_ONLY
+#include "backtrace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+typedef struct {
+    int   depth;
+    void *pc[PROF_MAX_DEPTH];       /* pc[0] 为被打断处, 之后是各级返回地址 */
+} ProfSample;
+
+static ProfSample  *g_samples;
+static int          g_cap;
+static volatile sig_atomic_t g_count, g_lost;
+static const char  *g_stack_lo, *g_stack_hi;
+static timer_t      g_timer;
+static int          g_running;
+static struct sigaction g_old_action;
+
+/* ---------- 采样 ---------- */
+static void prof_handler(int sig, siginfo_t *si, void *uctx) {
+    ucontext_t *uc = (ucontext_t *)uctx;
+    void *pc, **fp;
+    (void)sig; (void)si;
+    if (g_count >= g_cap) { g_lost++; return; }
+#if defined(__x86_64__)
+    pc = (void *)uc->uc_mcontext.gregs[REG_RIP];
+    fp = (void **)uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__aarch64__)
+    pc = (void *)uc->uc_mcontext.pc;
+    fp = (void **)uc->uc_mcontext.regs[29];
+#else
+    pc = (void *)uc->uc_mcontext.gregs[REG_EIP];
+    fp = (void **)uc->uc_mcontext.gregs[REG_EBP];
+#endif
+    ProfSample *s = &g_samples[g_count];
+    s->pc[0] = pc;
+    /* 被打断的代码可能没用帧指针, 所以把帧限制在本线程栈内 */
+    s->depth = 1 + bt_walk(fp, s->pc + 1, PROF_MAX_DEPTH - 1, g_stack_lo, g_stack_hi);
+    g_count++;
+}
+
+int prof_start(int hz, int max_samples) {
+    if (g_running) return -1;
+    if (hz <= 0) hz = PROF_DEFAULT_HZ;
+    if (hz > PROF_MAX_HZ) hz = PROF_MAX_HZ;
+    if (max_samples <= 0) max_samples = PROF_DEFAULT_MAX;
+    if (!g_samples || g_cap != max_samples) {
+        free(g_samples);
+        g_samples = (ProfSample *)malloc(sizeof(ProfSample) * max_samples);
+        if (!g_samples) return -1;
+        g_cap = max_samples;
+        g_count = g_lost = 0;
+    }
+
+    pthread_attr_t attr;
+    void *lo; size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr)) return -1;
+    pthread_attr_getstack(&attr, &lo, &size);
+    pthread_attr_destroy(&attr);
+    g_stack_lo = (const char *)lo;
+    g_stack_hi = (const char *)lo + size;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = prof_handler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, &g_old_action)) return -1;
+
+    clockid_t clock;
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (pthread_getcpuclockid(pthread_self(), &clock) || timer_create(clock, &sev, &g_timer)) {
+        sigaction(SIGPROF, &g_old_action, NULL);
+        return -1;
+    }
+    /* hz = 1 时周期正好 1 秒, tv_nsec 必须小于 1e9 */
+    long period = 1000000000L / hz;
+    struct itimerspec its;
+    its.it_interval.tv_sec = period / 1000000000L;
+    its.it_interval.tv_nsec = period % 1000000000L;
+    its.it_value = its.it_interval;
+    if (timer_settime(g_timer, 0, &its, NULL)) {
+        timer_delete(g_timer);
+        sigaction(SIGPROF, &g_old_action, NULL);
+        return -1;
+    }
+    g_running = 1;
+    return 0;
+}
+
+void prof_stop(void) {
+    if (!g_running) return;
+    timer_delete(g_timer);
+    sigaction(SIGPROF, &g_old_action, NULL);
+    g_running = 0;
+}
+
+int prof_samples(void) { return g_count; }
+int prof_lost(void)    { return g_lost; }
+
+void prof_reset(void) {
+    prof_stop();
+    free(g_samples);
+    g_samples = NULL;
+    g_cap = g_count = g_lost = 0;
+}
+
+/* ---------- 符号化 ----------
+ * dladdr 只认动态符号表, 可执行文件里的 static 函数会被算到前面最近的导出符号上,
+ * 所以先查 /proc/self/exe 的 .symtab, 查不到(共享库里的地址)再退回 dladdr. */
+typedef struct { unsigned long lo, hi; const char *name; } ProfSym;
+
+static ProfSym *g_syms;
+static int      g_nsyms;
+static char    *g_strtab;
+
+static int sym_cmp(const void *a, const void *b) {
+    unsigned long x = ((const ProfSym *)a)->lo, y = ((const ProfSym *)b)->lo;
+    return (x > y) - (x < y);
+}
+
+static void load_exe_symbols(void) {
+    Dl_info info;
+    FILE *fp = fopen("/proc/self/exe", "rb");
+    if (!fp || !dladdr((void *)prof_start, &info)) { if (fp) fclose(fp); return; }
+
+    ElfW(Ehdr) eh;
+    ElfW(Shdr) *sh = NULL;
+    if (fread(&eh, sizeof(eh), 1, fp) != 1 || memcmp(eh.e_ident, ELFMAG, SELFMAG)) goto done;
+    sh = (ElfW(Shdr) *)malloc(sizeof(ElfW(Shdr)) * eh.e_shnum);
+    if (!sh || fseek(fp, (long)eh.e_shoff, SEEK_SET) || fread(sh, sizeof(*sh), eh.e_shnum, fp) != eh.e_shnum) goto done;
+
+    unsigned long bias = (eh.e_type == ET_DYN) ? (unsigned long)info.dli_fbase : 0;
+    for (int i = 0; i < eh.e_shnum; i++) {
+        if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh.e_shnum) continue;
+        ElfW(Shdr) *st = &sh[sh[i].sh_link];
+        int n = (int)(sh[i].sh_size / sizeof(ElfW(Sym)));
+        ElfW(Sym) *syms = (ElfW(Sym) *)malloc(sh[i].sh_size);
+        g_strtab = (char *)malloc(st->sh_size);
+        g_syms = (ProfSym *)malloc(sizeof(ProfSym) * n);
+        if (!syms || !g_strtab || !g_syms ||
+            fseek(fp, (long)sh[i].sh_offset, SEEK_SET) || fread(syms, sizeof(ElfW(Sym)), n, fp) != (size_t)n ||
+            fseek(fp, (long)st->sh_offset, SEEK_SET) || fread(g_strtab, 1, st->sh_size, fp) != st->sh_size) {
+            free(syms);
+            break;
+        }
+        for (int k = 0; k < n; k++) {
+            if ((syms[k].st_info & 0xf) != STT_FUNC || !syms[k].st_value) continue;
+            ProfSym *ps = &g_syms[g_nsyms++];
+            ps->lo = bias + syms[k].st_value;
+            ps->hi = ps->lo + (syms[k].st_size ? syms[k].st_size : 1);
+            ps->name = g_strtab + syms[k].st_name;
+        }
+        free(syms);
+        qsort(g_syms, g_nsyms, sizeof(ProfSym), sym_cmp);
+        break;
+    }
+done:
+    free(sh);
+    fclose(fp);
+}
+
+static const char *symbolize(void *addr, char *buf, int size) {
+    unsigned long a = (unsigned long)addr;
+    int lo = 0, hi = g_nsyms - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (g_syms[mid].lo <= a) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    if (hi >= 0 && a < g_syms[hi].hi) {
+        /* 去掉 GCC 克隆后缀 (.constprop.0 / .isra.0 / .part.0 / .cold) */
+        const char *name = g_syms[hi].name, *dot = strchr(name, '.');
+        if (!dot || dot == name) return name;
+        snprintf(buf, size, "%.*s", (int)(dot - name), name);
+        return buf;
+    }
+
+    Dl_info info;
+    memset(&info, 0, sizeof(info));     /* dladdr 失败时不保证填写 info */
+    if (dladdr(addr, &info) && info.dli_sname) return info.dli_sname;
+    if (info.dli_fname) {
+        const char *base = strrchr(info.dli_fname, '/');
+        snprintf(buf, size, "[%s]", base ? base + 1 : info.dli_fname);
+    } else {
+        snprintf(buf, size, "0x%lx", a);
+    }
+    return buf;
+}
+
+typedef struct { char *stack; int count; } ProfLine;
+
+static int line_cmp_stack(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int line_cmp_count(const void *a, const void *b) {
+    const ProfLine *x = (const ProfLine *)a, *y = (const ProfLine *)b;
+    return (y->count > x->count) - (y->count < x->count);
+}
+
+void prof_dump(FILE *fp) {
+    int n = g_count;
+    if (!n) return;
+    if (!g_syms) load_exe_symbols();
+
+    char **stacks = (char **)malloc(sizeof(char *) * n);
+    ProfLine *lines = (ProfLine *)malloc(sizeof(ProfLine) * n);
+    if (!stacks || !lines) { free(stacks); free(lines); return; }
+
+    for (int i = 0; i < n; i++) {
+        const ProfSample *s = &g_samples[i];
+        char buf[PROF_MAX_DEPTH * 64], tmp[64];
+        int len = 0;
+        /* 根在前; 返回地址减一, 落在调用指令内 */
+        for (int d = s->depth - 1; d >= 0; d--) {
+            void *pc = d ? (char *)s->pc[d] - 1 : s->pc[d];
+            const char *name = symbolize(pc, tmp, sizeof(tmp));
+            int m = snprintf(buf + len, sizeof(buf) - len, "%s%s", len ? ";" : "", name);
+            if (m < 0 || m >= (int)sizeof(buf) - len) break;
+            len += m;
+        }
+        stacks[i] = strdup(buf);
+    }
+
+    qsort(stacks, n, sizeof(char *), line_cmp_stack);
+    int nl = 0;
+    for (int i = 0; i < n; i++) {
+        if (nl && !strcmp(lines[nl - 1].stack, stacks[i])) { lines[nl - 1].count++; continue; }
+        lines[nl].stack = stacks[i];
+        lines[nl].count = 1;
+        nl++;
+    }
+    qsort(lines, nl, sizeof(ProfLine), line_cmp_count);
+    for (int i = 0; i < nl; i++) fprintf(fp, "%s %d\n", lines[i].stack, lines[i].count);
+
+    for (int i = 0; i < n; i++) free(stacks[i]);
+    free(stacks);
+    free(lines);
+}
+
+#else
+
+int  prof_start(int hz, int max_samples) { (void)hz; (void)max_samples; return -1; }
+void prof_stop(void) {}
+int  prof_samples(void) { return 0; }
+int  prof_lost(void) { return 0; }
+void prof_dump(FILE *fp) { (void)fp; }
+void prof_reset(void) {}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include <stdio.h>
+
+/* 采样分析器(仅 Linux): 以调用线程的 CPU 时间为时钟, SIGPROF 定时打断该线程,
+ * 在信号处理器里沿帧指针链把调用栈写进预分配缓冲; 停止后再符号化,
+ * 输出 flamegraph.pl / speedscope 可读的 folded 格式 ("a;b;c 次数").
+ * CPU 时间定时器受内核 tick 限制, 实际采样率可能低于请求值.
+ * 调用栈需要帧指针: 用 -fno-omit-frame-pointer 编译, 否则只能得到被打断的那一层.
+ * 其他平台上 prof_start 返回 -1. */
+
+#define PROF_MAX_DEPTH     32
+#define PROF_DEFAULT_HZ    997      /* 避开与 1ms 周期性工作同步 */
+#define PROF_DEFAULT_MAX   16384
+#define PROF_MAX_HZ        1000000  /* 更高的请求按此取值; 实际仍受内核 tick 限制 */
+
+int  prof_start(int hz, int max_samples);   /* 0 取默认值; 只采样调用线程. 失败返回 -1 */
+void prof_stop(void);
+int  prof_samples(void);                    /* 已采集的样本数 */
+int  prof_lost(void);                       /* 缓冲满后丢弃的样本数 */
+void prof_dump(FILE *fp);                   /* 输出 folded 格式, 按次数降序 */
+void prof_reset(void);                      /* 清空样本, 释放缓冲 */
+
+#endif /* __PROF_H__ */
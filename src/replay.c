@@ -0,0 +1,386 @@
+#include "replay.h"
+#include "timer.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { REC_EVENT = 'E', REC_FRAME = 'F' };
+
+/* ---------- 编码 ---------- */
+typedef struct {
+    unsigned char *p;
+    int            len, cap;
+    int            err;
+} RecBuf;
+
+static void buf_bytes(RecBuf *b, const void *src, int n) {
+    if (b->len + n > b->cap) {
+        int cap = b->cap ? b->cap : 256;
+        while (cap < b->len + n) cap *= 2;
+        unsigned char *p = (unsigned char *)realloc(b->p, cap);
+        if (!p) { b->err = 1; return; }
+        b->p = p;
+        b->cap = cap;
+    }
+    memcpy(b->p + b->len, src, n);
+    b->len += n;
+}
+
+static void buf_byte(RecBuf *b, int c) {
+    unsigned char u = (unsigned char)c;
+    buf_bytes(b, &u, 1);
+}
+
+/* 无符号 LEB128 */
+static void buf_uvar(RecBuf *b, unsigned long long v) {
+    unsigned char tmp[10];
+    int n = 0;
+    do {
+        tmp[n] = v & 0x7F;
+        v >>= 7;
+        if (v) tmp[n] |= 0x80;
+        n++;
+    } while (v);
+    buf_bytes(b, tmp, n);
+}
+
+/* 有符号数先 zigzag, 小的负数也只占一个字节 */
+static void buf_var(RecBuf *b, long long v) {
+    buf_uvar(b, ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63));
+}
+
+static void enc_rect(RecBuf *b, mu_Rect r) {
+    buf_var(b, r.x); buf_var(b, r.y); buf_var(b, r.w); buf_var(b, r.h);
+}
+
+static void enc_color(RecBuf *b, mu_Color c) {
+    unsigned char rgba[4] = { c.r, c.g, c.b, c.a };
+    buf_bytes(b, rgba, 4);
+}
+
+static void enc_event(RecBuf *b, const TermEvent *e) {
+    buf_byte(b, e->type);
+    switch (e->type) {
+    case TERM_EV_KEY: {
+        const TermKeyEvent *k = &e->u.key;
+        const char *z = (const char *)memchr(k->utf8, 0, sizeof(k->utf8) - 1);
+        int n = z ? (int)(z - k->utf8) : (int)sizeof(k->utf8) - 1;
+        buf_var(b, k->key_code);
+        buf_uvar(b, (unsigned)k->ctrl_code);
+        buf_var(b, k->pressed);
+        buf_uvar(b, k->repeat);
+        buf_uvar(b, k->scan);
+        buf_byte(b, n);
+        buf_bytes(b, k->utf8, n);
+        break;
+    }
+    case TERM_EV_MOUSE: {
+        const TermMouseEvent *m = &e->u.mouse;
+        buf_byte(b, m->type);
+        buf_var(b, m->x); buf_var(b, m->y);
+        buf_uvar(b, m->btn);
+        buf_var(b, m->ctrl);
+        buf_var(b, m->wheel);
+        break;
+    }
+    case TERM_EV_RESIZE:
+        buf_uvar(b, e->u.size.cols);
+        buf_uvar(b, e->u.size.rows);
+        break;
+    default:
+        break;
+    }
+}
+
+static void enc_commands(RecBuf *b, mu_Context *ctx) {
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        buf_byte(b, cmd->type);
+        switch (cmd->type) {
+        case MU_COMMAND_CLIP: enc_rect(b, cmd->clip.rect); break;
+        case MU_COMMAND_RECT: enc_rect(b, cmd->rect.rect); enc_color(b, cmd->rect.color); break;
+        case MU_COMMAND_ICON: buf_uvar(b, cmd->icon.id); enc_rect(b, cmd->icon.rect); enc_color(b, cmd->icon.color); break;
+        case MU_COMMAND_TEXT: {
+            int n = (int)strlen(cmd->text.str);
+            buf_var(b, cmd->text.pos.x); buf_var(b, cmd->text.pos.y);
+            enc_color(b, cmd->text.color);
+            buf_uvar(b, n);
+            buf_bytes(b, cmd->text.str, n);
+            break;
+        }
+        case MU_COMMAND_GLYPHS:
+            /* 字形由 text_glyphs 填满(含未用字节), 可以按原样比较 */
+            buf_var(b, cmd->glyphs.pos.x); buf_var(b, cmd->glyphs.pos.y);
+            enc_color(b, cmd->glyphs.color);
+            buf_uvar(b, cmd->glyphs.width);
+            buf_uvar(b, cmd->glyphs.count);
+            buf_bytes(b, cmd->glyphs.glyphs, cmd->glyphs.count * ctx->glyph_size);
+            break;
+        }
+    }
+}
+
+/* ---------- 录制 ---------- */
+struct recorder_t {
+    FILE      *fp;
+    long long  start;       /* timer_ns() 的起点 */
+    long long  last_us;     /* 上一条记录的时刻 */
+    RecBuf     head, body;
+    int        err;
+};
+
+recorder_t *rec_open(const char *path) {
+    recorder_t *r = (recorder_t *)calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->fp = fopen(path, "wb");
+    if (!r->fp) { free(r); return NULL; }
+    fwrite(REPLAY_MAGIC, 1, sizeof(REPLAY_MAGIC) - 1, r->fp);
+    r->start = timer_ns();
+    return r;
+}
+
+/* 标签, 时间增量, 负载长度, 负载 */
+static void rec_write(recorder_t *r, int tag, long long t_ns) {
+    long long t = (t_ns - r->start) / 1000;
+    if (t < r->last_us) t = r->last_us;     /* 时间戳来自不同线程时可能略有倒退 */
+    r->head.len = 0;
+    buf_byte(&r->head, tag);
+    buf_uvar(&r->head, t - r->last_us);
+    buf_uvar(&r->head, r->body.len);
+    r->last_us = t;
+    if (r->head.err || r->body.err) { r->err = 1; return; }
+    if (fwrite(r->head.p, 1, r->head.len, r->fp) != (size_t)r->head.len ||
+        fwrite(r->body.p, 1, r->body.len, r->fp) != (size_t)r->body.len) r->err = 1;
+}
+
+void rec_event_at(recorder_t *r, const TermEvent *e, long long t_ns) {
+    if (e->type == TERM_EV_NONE) return;
+    r->body.len = 0;
+    enc_event(&r->body, e);
+    rec_write(r, REC_EVENT, t_ns);
+}
+
+void rec_event(recorder_t *r, const TermEvent *e) {
+    rec_event_at(r, e, timer_ns());
+}
+
+void rec_frame(recorder_t *r, mu_Context *ctx) {
+    r->body.len = 0;
+    enc_commands(&r->body, ctx);
+    rec_write(r, REC_FRAME, timer_ns());
+}
+
+int rec_close(recorder_t *r) {
+    if (!r) return 0;
+    int err = r->err | (fclose(r->fp) != 0);
+    free(r->head.p);
+    free(r->body.p);
+    free(r);
+    return err ? -1 : 0;
+}
+
+/* ---------- 回放 ---------- */
+typedef struct { long off; int len; } RecFrame;
+
+struct replay_t {
+    FILE      *fp;
+    int        mode;
+    long long  clock_us;    /* 已读到的记录时刻 */
+    long long  now_us;      /* FAST: 虚拟时钟 */
+    long long  start;       /* REALTIME: 开始回放的 timer_ns() */
+    int        has_next, eof;
+    TermEvent  next;        /* 预读的下一个事件 */
+    long long  next_us;
+    RecFrame  *frames;      /* 读过但还没比较的帧记录, 只记位置 */
+    int        frame_head, frame_len, frame_cap;
+    int        events;
+    RecBuf     buf;
+};
+
+static int get_uvar(FILE *fp, unsigned long long *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(fp);
+        if (c == EOF) return -1;
+        *v |= (unsigned long long)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return 0;
+    }
+    return -1;
+}
+
+typedef struct { const unsigned char *p, *end; int err; } RecIn;
+
+static int in_byte(RecIn *in) {
+    if (in->p >= in->end) { in->err = 1; return 0; }
+    return *in->p++;
+}
+
+static unsigned long long in_uvar(RecIn *in) {
+    unsigned long long v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = in_byte(in);
+        v |= (unsigned long long)(c & 0x7F) << shift;
+        if (!(c & 0x80)) break;
+    }
+    return v;
+}
+
+static long long in_var(RecIn *in) {
+    unsigned long long v = in_uvar(in);
+    return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+static int dec_event(RecIn *in, TermEvent *e) {
+    memset(e, 0, sizeof(*e));
+    e->type = (TermEventType)in_byte(in);
+    switch (e->type) {
+    case TERM_EV_KEY: {
+        TermKeyEvent *k = &e->u.key;
+        k->key_code = (int)in_var(in);
+        k->ctrl_code = (int)in_uvar(in);
+        k->pressed = (int)in_var(in);
+        k->repeat = (int)in_uvar(in);
+        k->scan = (unsigned)in_uvar(in);
+        int n = in_byte(in);
+        for (int i = 0; i < n && i < (int)sizeof(k->utf8) - 1; i++) k->utf8[i] = (char)in_byte(in);
+        break;
+    }
+    case TERM_EV_MOUSE: {
+        TermMouseEvent *m = &e->u.mouse;
+        m->type = (TermMouseEventType)in_byte(in);
+        m->x = (int)in_var(in);
+        m->y = (int)in_var(in);
+        m->btn = (int)in_uvar(in);
+        m->ctrl = (int)in_var(in);
+        m->wheel = (int)in_var(in);
+        break;
+    }
+    case TERM_EV_RESIZE:
+        e->u.size.cols = (int)in_uvar(in);
+        e->u.size.rows = (int)in_uvar(in);
+        break;
+    default:
+        break;
+    }
+    return in->err ? -1 : 0;
+}
+
+static int read_payload(replay_t *rp, int len) {
+    rp->buf.len = 0;
+    if (len > rp->buf.cap) {
+        unsigned char *p = (unsigned char *)realloc(rp->buf.p, len);
+        if (!p) return -1;
+        rp->buf.p = p;
+        rp->buf.cap = len;
+    }
+    if (fread(rp->buf.p, 1, len, rp->fp) != (size_t)len) return -1;
+    rp->buf.len = len;
+    return 0;
+}
+
+/* 读到下一个事件为止, 途中的帧记录进队列. 文件结束或损坏返回 0 */
+static int read_next(replay_t *rp) {
+    while (!rp->eof) {
+        int tag = getc(rp->fp);
+        unsigned long long dt, len;
+        if (tag == EOF || get_uvar(rp->fp, &dt) || get_uvar(rp->fp, &len) || len > (1u << 30)) break;
+        rp->clock_us += (long long)dt;
+        if (tag == REC_EVENT) {
+            if (read_payload(rp, (int)len)) break;
+            RecIn in = { rp->buf.p, rp->buf.p + rp->buf.len, 0 };
+            if (dec_event(&in, &rp->next)) break;
+            rp->next_us = rp->clock_us;
+            rp->has_next = 1;
+            return 1;
+        }
+        if (tag == REC_FRAME) {
+            if (rp->frame_head + rp->frame_len == rp->frame_cap) {
+                if (rp->frame_head) {
+                    memmove(rp->frames, rp->frames + rp->frame_head, rp->frame_len * sizeof(RecFrame));
+                    rp->frame_head = 0;
+                } else {
+                    int cap = rp->frame_cap ? rp->frame_cap * 2 : 16;
+                    RecFrame *f = (RecFrame *)realloc(rp->frames, cap * sizeof(RecFrame));
+                    if (!f) break;
+                    rp->frames = f;
+                    rp->frame_cap = cap;
+                }
+            }
+            rp->frames[rp->frame_head + rp->frame_len++] = (RecFrame){ ftell(rp->fp), (int)len };
+        }
+        if (fseek(rp->fp, (long)len, SEEK_CUR)) break;
+    }
+    rp->eof = 1;
+    return 0;
+}
+
+replay_t *replay_open(const char *path, int mode) {
+    char magic[sizeof(REPLAY_MAGIC) - 1];
+    replay_t *rp = (replay_t *)calloc(1, sizeof(*rp));
+    if (!rp) return NULL;
+    rp->fp = fopen(path, "rb");
+    if (!rp->fp || fread(magic, 1, sizeof(magic), rp->fp) != sizeof(magic) ||
+        memcmp(magic, REPLAY_MAGIC, sizeof(magic))) {
+        replay_close(rp);
+        return NULL;
+    }
+    rp->mode = mode;
+    rp->start = timer_ns();
+    return rp;
+}
+
+void replay_close(replay_t *rp) {
+    if (!rp) return;
+    if (rp->fp) fclose(rp->fp);
+    free(rp->frames);
+    free(rp->buf.p);
+    free(rp);
+}
+
+long long replay_now(replay_t *rp) {
+    if (rp->mode == REPLAY_REALTIME) return timer_ns() - rp->start;
+    return rp->now_us * 1000;
+}
+
+TermEvent replay_poll(replay_t *rp) {
+    TermEvent none = { .type = TERM_EV_NONE };
+    if (!rp->has_next && !read_next(rp)) return none;
+    if (rp->next_us * 1000 > replay_now(rp)) return none;
+    rp->has_next = 0;
+    rp->events++;
+    return rp->next;
+}
+
+int replay_wait(replay_t *rp) {
+    if (!rp->has_next && !read_next(rp)) return 0;
+    if (rp->mode == REPLAY_FAST) {
+        if (rp->now_us < rp->next_us) rp->now_us = rp->next_us;
+    } else {
+        long long wait = rp->next_us * 1000 - replay_now(rp);
+        if (wait > 0) thread_sleep_ms((int)((wait + 999999) / 1000000));
+    }
+    return 1;
+}
+
+int replay_check_frame(replay_t *rp, mu_Context *ctx) {
+    if (!rp->frame_len && !rp->has_next) read_next(rp);
+    if (!rp->frame_len) return -1;
+    RecFrame f = rp->frames[rp->frame_head];
+    rp->frame_head++;
+    rp->frame_len--;
+
+    RecBuf now = {0};
+    enc_commands(&now, ctx);
+    long pos = ftell(rp->fp);
+    int same = 0;
+    if (!now.err && now.len == f.len && !fseek(rp->fp, f.off, SEEK_SET) && !read_payload(rp, f.len))
+        same = !memcmp(now.p, rp->buf.p, f.len);
+    fseek(rp->fp, pos, SEEK_SET);
+    free(now.p);
+    return same;
+}
+
+int replay_events(replay_t *rp) {
+    return rp->events;
+}
@@ -0,0 +1,38 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "microui.h"
+#include "term.h"
+
+/* 输入录制与回放. 录制文件是紧凑的二进制记录流: 每条记录一个标签字节, 距上一条的
+ * 微秒数(varint), 再是负载. 输入事件记录 TermEvent 的各字段; 帧记录可选, 存该帧
+ * 序列化后的命令列表(mu_next_command 的顺序, 整数用 varint).
+ * 回放用虚拟时钟: REPLAY_FAST 时钟直接跳到下一个事件, 尽快跑完; REPLAY_REALTIME
+ * 时钟跟着真实时间走, 事件按录制时的间隔到达. 回放时每跑一帧可以与录下的帧比较,
+ * 找出命令流第一次分叉的帧. */
+
+#define REPLAY_MAGIC    "MUREC1\n"
+
+typedef struct recorder_t recorder_t;
+typedef struct replay_t replay_t;
+
+enum { REPLAY_FAST, REPLAY_REALTIME };
+
+recorder_t *rec_open(const char *path);         /* 打不开返回 NULL; 时间从此刻算起 */
+void rec_event(recorder_t *r, const TermEvent *e);
+void rec_event_at(recorder_t *r, const TermEvent *e, long long t_ns);  /* 时间戳取 timer_ns() 的值, 如读入输入时记下的 */
+void rec_frame(recorder_t *r, mu_Context *ctx); /* 在 mu_end 之后调用 */
+int  rec_close(recorder_t *r);                  /* 写入失败过返回 -1 */
+
+replay_t *replay_open(const char *path, int mode);  /* 不是录制文件返回 NULL */
+void replay_close(replay_t *rp);
+/* 取出一个已到时的事件, 没有则返回 TERM_EV_NONE(非阻塞, 用法同 term_poll_event) */
+TermEvent replay_poll(replay_t *rp);
+/* 没有到时的事件时调用: FAST 把时钟拨到下一个事件, REALTIME 睡到下一个事件. 录制已放完返回 0 */
+int  replay_wait(replay_t *rp);
+long long replay_now(replay_t *rp);             /* 虚拟时钟, 纳秒, 从录制开始算起 */
+/* 与录下的下一帧比较: 1 一致, 0 不一致, -1 录制里没有对应的帧. 在 mu_end 之后调用 */
+int  replay_check_frame(replay_t *rp, mu_Context *ctx);
+int  replay_events(replay_t *rp);               /* 已取出的事件数 */
+
+#endif /* __REPLAY_H__ */
@@ -0,0 +1,309 @@
+#include "session.h"
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "ui_renderer.h"
+#include "vt_input.h"
+#include "workers.h"
+
+struct session_t {
+    int              fd;
+    int              cols, rows;
+    mu_Context      *ctx;
+    ui_renderer_t   *ur;
+    vti_t            in;
+    int              resized;       /* 尺寸变了: 下次推进跑一帧并整屏输出 */
+    int              changed;       /* 跑过的帧改变了画面, 还没输出 */
+    int              closed;
+    void            *user;
+    session_frame_fn frame;
+};
+
+struct server_t {
+    session_frame_fn frame;
+    workers_t       *workers;
+    session_t      **sessions;
+    int              count, cap;
+    struct pollfd   *fds;
+    session_t      **ready;         /* 本轮要推进的会话, revents 记在 fds 里 */
+    int             *ready_fd;      /* ready[i] 在 fds 中的下标 */
+};
+
+static int key_map(int key) {
+    switch (key) {
+        case TERM_KEY_BACK:   return MU_KEY_BACKSPACE;
+        case TERM_KEY_RETURN: return MU_KEY_RETURN;
+        case TERM_KEY_DELETE: return MU_KEY_DELETE;
+        case TERM_KEY_LEFT:   return MU_KEY_LEFT;
+        case TERM_KEY_RIGHT:  return MU_KEY_RIGHT;
+        case TERM_KEY_UP:     return MU_KEY_UP;
+        case TERM_KEY_DOWN:   return MU_KEY_DOWN;
+        case TERM_KEY_HOME:   return MU_KEY_HOME;
+        case TERM_KEY_END:    return MU_KEY_END;
+        case TERM_KEY_PRIOR:  return MU_KEY_PAGEUP;
+        case TERM_KEY_NEXT:   return MU_KEY_PAGEDOWN;
+    }
+    return 0;
+}
+
+/* ---------- 推进 ---------- */
+static void session_frame(session_t *s) {
+    mu_begin(s->ctx);
+    if (!s->frame(s, s->ctx)) s->closed = 1;
+    mu_end(s->ctx);
+    s->changed |= mu_frame_changed(s->ctx);
+}
+
+/* 合进本批的帧会丢掉输入时返回 1, 要先把之前的跑掉: 同一键再按一次, 文本放不下,
+ * 再按一次鼠标, 或在上一帧没见过的位置按下(悬停要先在那里跑一帧才生效) */
+static int session_would_merge(mu_Context *ctx, const TermEvent *e) {
+    if (e->type == TERM_EV_KEY && e->u.key.pressed) {
+        int k = key_map(e->u.key.key_code);
+        if (k) return (ctx->key_pressed & k) != 0;
+        return strlen(ctx->input_text) + strlen(e->u.key.utf8) >= sizeof(ctx->input_text);
+    }
+    if (e->type == TERM_EV_MOUSE) {
+        const TermMouseEvent *m = &e->u.mouse;
+        if (m->type != TERM_MOUSE_LEFT_DOWN && m->type != TERM_MOUSE_RIGHT_DOWN && m->type != TERM_MOUSE_MIDDLE_DOWN) return 0;
+        return ctx->mouse_pressed || m->x != ctx->last_mouse_pos.x || m->y != ctx->last_mouse_pos.y;
+    }
+    return 0;
+}
+
+static void session_event(void *user, const TermEvent *e) {
+    session_t *s = (session_t *)user;
+    mu_Context *ctx = s->ctx;
+    if (!s->closed && session_would_merge(ctx, e)) {
+        if (e->type == TERM_EV_MOUSE) mu_input_mousemove(ctx, e->u.mouse.x, e->u.mouse.y);
+        session_frame(s);
+    }
+    switch (e->type) {
+    case TERM_EV_KEY:
+        if (key_map(e->u.key.key_code)) {
+            if (e->u.key.pressed) mu_input_keydown(ctx, key_map(e->u.key.key_code));
+            else                  mu_input_keyup(ctx, key_map(e->u.key.key_code));
+        } else if (e->u.key.pressed && (unsigned char)e->u.key.utf8[0] >= 0x20 && !e->u.key.left_alt_pressed) {
+            mu_input_text(ctx, e->u.key.utf8);
+        }
+        break;
+    case TERM_EV_MOUSE: {
+        const TermMouseEvent *m = &e->u.mouse;
+        switch (m->type) {
+            case TERM_MOUSE_MOVE: mu_input_mousemove(ctx, m->x, m->y); break;
+            case TERM_MOUSE_LEFT_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_LEFT); break;
+            case TERM_MOUSE_RIGHT_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_RIGHT); break;
+            case TERM_MOUSE_MIDDLE_DOWN: mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_MIDDLE); break;
+            case TERM_MOUSE_LEFT_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_LEFT); break;
+            case TERM_MOUSE_RIGHT_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_RIGHT); break;
+            case TERM_MOUSE_MIDDLE_UP: mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_MIDDLE); break;
+            case TERM_MOUSE_WHEEL: mu_input_scroll(ctx, 0, -m->wheel); break;
+            default: break;
+        }
+        break;
+    }
+    case TERM_EV_RESIZE:
+        session_resize(s, e->u.size.cols, e->u.size.rows);
+        break;
+    default:
+        break;
+    }
+}
+
+static void session_step(session_t *s, int revents) {
+    if (revents & POLLIN) {
+        char buf[SESSION_READ_MAX];
+        ssize_t n = read(s->fd, buf, sizeof(buf));
+        /* 一次读到的事件合成一帧; 按下后松开仍记在 *_pressed 里, 不会抵消 */
+        if (n > 0) vti_feed(&s->in, buf, (int)n, session_event, s);
+        else if (n == 0 || (errno != EAGAIN && errno != EINTR)) s->closed = 1;
+    } else if (revents & (POLLHUP | POLLERR | POLLNVAL)) {
+        s->closed = 1;
+    }
+    if (s->closed) return;
+    if (s->resized || mu_needs_frame(s->ctx)) session_frame(s);
+    /* 终端还没收完上一帧时先不画, 之后直接输出最新的画面 */
+    int redraw = s->changed || s->resized;
+    if ((redraw || ur_deferred_ms(s->ur) == 0) && !ur_flush(s->ur) && !s->closed) {
+        if (redraw) {
+            ur_clear(s->ur, s->ctx->style->colors[MU_COLOR_WINDOWBG]);
+            ur_draw_commands(s->ur, s->ctx);
+        }
+        /* 超预算时先更新鼠标所在的窗口, 没有则是最上层窗口 */
+        mu_Context *ctx = s->ctx;
+        mu_Container *focus = ctx->hover_root;
+        if (!focus && ctx->root_list.idx) focus = ctx->root_list.items[ctx->root_list.idx - 1];
+        ur_set_focus(s->ur, focus ? focus->rect : mu_rect(0, 0, 0, 0));
+        ur_present(s->ur);
+        s->changed = s->resized = 0;
+    }
+}
+
+static int session_pending(session_t *s) {
+    return !s->closed && !ur_backlog(s->ur) && (s->resized || mu_needs_frame(s->ctx) || ur_deferred_ms(s->ur) == 0);
+}
+
+mu_Context *session_context(session_t *s)           { return s->ctx; }
+void       *session_user(session_t *s)              { return s->user; }
+void        session_set_user(session_t *s, void *u) { s->user = u; }
+void        session_size(session_t *s, int *cols, int *rows) { *cols = s->cols; *rows = s->rows; }
+
+void session_set_budget(session_t *s, int bytes_per_sec) {
+    ur_set_budget(s->ur, bytes_per_sec);
+}
+
+void session_resize(session_t *s, int cols, int rows) {
+    if (cols <= 0 || rows <= 0) return;
+    if (ur_resize(s->ur, cols, rows)) { s->closed = 1; return; }
+    s->cols = cols;
+    s->rows = rows;
+    s->ctx->viewport = mu_rect(0, 0, cols, rows);
+    s->resized = 1;
+}
+
+static void session_free(session_t *s) {
+    if (!s) return;
+    if (s->fd >= 0) {
+        /* 关掉鼠标上报, 恢复光标 */
+        static const char bye[] = "\x1b[?1006l\x1b[?1003l\x1b[0m\x1b[2J\x1b[H\x1b[?25h";
+        if (!s->closed && !ur_flush(s->ur)) {
+            ssize_t n = write(s->fd, bye, sizeof(bye) - 1);
+            (void)n;
+        }
+        close(s->fd);
+    }
+    ur_free(s->ur);
+    if (s->ctx) mu_release(s->ctx);
+    free(s->ctx);
+    free(s);
+}
+
+/* ---------- 服务 ---------- */
+server_t *server_new(int threads, session_frame_fn frame) {
+    server_t *sv = (server_t *)calloc(1, sizeof(*sv));
+    if (!sv) return NULL;
+    sv->frame = frame;
+    sv->workers = threads > 1 ? workers_new(threads) : NULL;
+    return sv;
+}
+
+void server_free(server_t *sv) {
+    if (!sv) return;
+    for (int i = 0; i < sv->count; i++) session_free(sv->sessions[i]);
+    workers_free(sv->workers);
+    free(sv->sessions);
+    free(sv->fds);
+    free(sv->ready);
+    free(sv->ready_fd);
+    free(sv);
+}
+
+static int server_grow(server_t *sv) {
+    int cap = sv->cap ? sv->cap * 2 : 16;
+    session_t **ss = (session_t **)realloc(sv->sessions, cap * sizeof(*ss));
+    if (ss) sv->sessions = ss;
+    struct pollfd *fds = (struct pollfd *)realloc(sv->fds, cap * sizeof(*fds));
+    if (fds) sv->fds = fds;
+    session_t **ready = (session_t **)realloc(sv->ready, cap * sizeof(*ready));
+    if (ready) sv->ready = ready;
+    int *ready_fd = (int *)realloc(sv->ready_fd, cap * sizeof(*ready_fd));
+    if (ready_fd) sv->ready_fd = ready_fd;
+    if (!ss || !fds || !ready || !ready_fd) return -1;
+    sv->cap = cap;
+    return 0;
+}
+
+session_t *server_open(server_t *sv, int fd, int cols, int rows) {
+    if (sv->count == sv->cap && server_grow(sv)) return NULL;
+    session_t *s = (session_t *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->fd = -1;
+    s->frame = sv->frame;
+    s->ctx = (mu_Context *)malloc(sizeof(mu_Context));
+    s->ur = ur_new_fd(cols, rows, fd);
+    if (!s->ctx || !s->ur) { free(s->ctx); s->ctx = NULL; session_free(s); return NULL; }
+    mu_Config config = { .command_list_size = SESSION_COMMANDS };
+    mu_init_ex(s->ctx, &config);
+    s->ctx->text_width = r_text_width;
+    s->ctx->text_height = r_text_height;
+    s->ctx->text_glyphs = r_text_glyphs;
+    s->ctx->glyph_size = sizeof(utf8_t);
+    /* 命令流没变时整帧跳过已经够用, 会话不建缓存面, 省内存 */
+    ur_set_cache(s->ur, 0);
+    s->cols = cols;
+    s->rows = rows;
+    s->ctx->viewport = mu_rect(0, 0, cols, rows);
+    s->resized = 1;
+
+    s->fd = fd;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    /* 鼠标: 任意移动都上报(1003), SGR 编码(1006); 隐藏光标. 新连接的缓冲是空的, 直接写 */
+    static const char hello[] = "\x1b[?1003h\x1b[?1006h\x1b[?25l";
+    if (write(fd, hello, sizeof(hello) - 1) < 0) s->closed = 1;
+    sv->sessions[sv->count++] = s;
+    return s;
+}
+
+void server_close(server_t *sv, session_t *s) {
+    for (int i = 0; i < sv->count; i++) {
+        if (sv->sessions[i] != s) continue;
+        sv->sessions[i] = sv->sessions[--sv->count];
+        session_free(s);
+        return;
+    }
+}
+
+int server_count(server_t *sv)                  { return sv->count; }
+session_t *server_session(server_t *sv, int i)  { return sv->sessions[i]; }
+
+static void server_run(void *user, int i) {
+    server_t *sv = (server_t *)user;
+    session_step(sv->ready[i], sv->fds[sv->ready_fd[i]].revents);
+}
+
+int server_step(server_t *sv, int timeout_ms) {
+    for (int i = 0; i < sv->count; i++) {
+        session_t *s = sv->sessions[i];
+        int backlog = ur_backlog(s->ur);
+        sv->fds[i] = (struct pollfd){ .fd = s->fd, .events = POLLIN | (backlog ? POLLOUT : 0) };
+        int wait = session_pending(s) ? 0 : backlog ? -1 : ur_deferred_ms(s->ur);
+        if (wait >= 0 && (timeout_ms < 0 || wait < timeout_ms)) timeout_ms = wait;
+    }
+    if (poll(sv->fds, sv->count, timeout_ms) < 0 && errno != EINTR) return 0;
+
+    int n = 0;
+    for (int i = 0; i < sv->count; i++) {
+        session_t *s = sv->sessions[i];
+        if (!sv->fds[i].revents && !session_pending(s)) continue;
+        sv->ready[n] = s;
+        sv->ready_fd[n++] = i;
+    }
+    workers_run(sv->workers, n, server_run, sv);
+
+    for (int i = sv->count - 1; i >= 0; i--) {
+        if (sv->sessions[i]->closed) server_close(sv, sv->sessions[i]);
+    }
+    return n;
+}
+
+#else
+
+server_t *server_new(int threads, session_frame_fn frame) { (void)threads; (void)frame; return NULL; }
+void server_free(server_t *sv) { (void)sv; }
+session_t *server_open(server_t *sv, int fd, int cols, int rows) { (void)sv; (void)fd; (void)cols; (void)rows; return NULL; }
+void server_close(server_t *sv, session_t *s) { (void)sv; (void)s; }
+int server_count(server_t *sv) { (void)sv; return 0; }
+session_t *server_session(server_t *sv, int i) { (void)sv; (void)i; return NULL; }
+int server_step(server_t *sv, int timeout_ms) { (void)sv; (void)timeout_ms; return 0; }
+mu_Context *session_context(session_t *s) { (void)s; return NULL; }
+void *session_user(session_t *s) { (void)s; return NULL; }
+void session_set_user(session_t *s, void *user) { (void)s; (void)user; }
+void session_set_budget(session_t *s, int bytes_per_sec) { (void)s; (void)bytes_per_sec; }
+void session_resize(session_t *s, int cols, int rows) { (void)s; (void)cols; (void)rows; }
+void session_size(session_t *s, int *cols, int *rows) { (void)s; *cols = *rows = 0; }
+
+#endif
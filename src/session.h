@@ -0,0 +1,42 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include "microui.h"
+
+/* 多会话服务(仅 POSIX): 一个进程同时驱动多个互不相干的界面, 每个会话一个 fd
+ * (pty 或 Unix socket, 读到的是键盘鼠标输入, 写出去的是屏幕). 每个会话有自己的
+ * mu_Context, 渲染实例和输入解码器, 没有全局状态; server_step 用 poll 等输入,
+ * 再由线程池并行推进有输入或有待定动画的会话, 空闲会话不花 CPU.
+ * 一个会话同一时刻只在一个线程里推进, 所以 frame 回调只能碰本会话的数据(session_user).
+ * 统计计数(stats.h)是全进程的, 多线程推进时不要打开. 其他平台上 server_new 返回 NULL. */
+
+#define SESSION_COMMANDS    (16 * 1024)     /* 每个会话命令列表的初始大小, 不够时按块增长 */
+#define SESSION_READ_MAX    4096            /* 每次推进最多读入的输入字节 */
+
+typedef struct session_t session_t;
+typedef struct server_t server_t;
+
+/* 在 mu_begin/mu_end 之间构建会话的界面; 返回 0 则关闭该会话 */
+typedef int (*session_frame_fn)(session_t *s, mu_Context *ctx);
+
+server_t   *server_new(int threads, session_frame_fn frame);   /* threads 含调用者 */
+void        server_free(server_t *sv);                          /* 关闭全部会话 */
+/* 接管 fd(关闭会话时 close), 打开鼠标上报, 下次推进时整屏输出. 失败返回 NULL */
+session_t  *server_open(server_t *sv, int fd, int cols, int rows);
+void        server_close(server_t *sv, session_t *s);
+int         server_count(server_t *sv);
+session_t  *server_session(server_t *sv, int i);
+/* 最多等 timeout_ms 毫秒输入(有会话待定时不等), 并行推进就绪的会话, 关闭断开的会话.
+ * 返回本轮推进的会话数 */
+int         server_step(server_t *sv, int timeout_ms);
+
+mu_Context *session_context(session_t *s);
+void       *session_user(session_t *s);
+void        session_set_user(session_t *s, void *user);
+/* 输出带宽预算, 0 为不限; 超预算时优先更新鼠标所在的窗口, 见 ur_set_budget */
+void        session_set_budget(session_t *s, int bytes_per_sec);
+/* pty 的尺寸由调用方得知(SIGWINCH); socket 客户端发 CSI 8;rows;cols t 报告尺寸 */
+void        session_resize(session_t *s, int cols, int rows);
+void        session_size(session_t *s, int *cols, int *rows);
+
+#endif /* __SESSION_H__ */
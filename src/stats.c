@@ -0,0 +1,113 @@
+#include "stats.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int        g_stats_on;
+FrameStats g_stats_cur;
+
+static FrameStats g_hist[STATS_HISTORY];
+static int        g_hist_head, g_hist_len;
+static int        g_in_frame;
+static long long  g_phase_t0[STAT_PHASE_MAX];
+
+void stats_enable(int on) {
+#ifndef STATS_DISABLE
+    g_stats_on = on;
+    g_in_frame = 0;
+#endif
+}
+
+void stats_frame_begin(void) {
+    if (g_in_frame) {
+        g_hist[g_hist_head] = g_stats_cur;
+        g_hist_head = (g_hist_head + 1) % STATS_HISTORY;
+        if (g_hist_len < STATS_HISTORY) g_hist_len++;
+    }
+    memset(&g_stats_cur, 0, sizeof(g_stats_cur));
+    g_in_frame = 1;
+}
+
+void stats_phase_begin(int phase) {
+    g_phase_t0[phase] = timer_ns();
+}
+
+void stats_phase_end(int phase) {
+    g_stats_cur.phase_ns[phase] += timer_ns() - g_phase_t0[phase];
+}
+
+const FrameStats *stats_last(void) {
+    if (!g_hist_len) return NULL;
+    return &g_hist[(g_hist_head + STATS_HISTORY - 1) % STATS_HISTORY];
+}
+
+int stats_history(FrameStats *out, int max) {
+    int n = g_hist_len < max ? g_hist_len : max;
+    for (int i = 0; i < n; i++)
+        out[i] = g_hist[(g_hist_head + STATS_HISTORY - n + i) % STATS_HISTORY];
+    return n;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+StatSummary stats_summary(size_t field) {
+    StatSummary s = {0, 0, 0};
+    long long v[STATS_HISTORY], sum = 0;
+    int n = g_hist_len;
+    if (!n) return s;
+    for (int i = 0; i < n; i++) {
+        v[i] = *(const long long *)((const char *)&g_hist[i] + field);
+        sum += v[i];
+    }
+    qsort(v, n, sizeof(v[0]), cmp_ll);
+    s.min = (double)v[0];
+    s.avg = (double)sum / n;
+    s.p99 = (double)v[(n * 99 - 1) / 100];
+    return s;
+}
+
+/* ---------- 统计窗口 ---------- */
+static const struct { const char *name; size_t field; double scale; } g_metrics[] = {
+    { "layout us",   STATS_FIELD(phase_ns[STAT_PHASE_LAYOUT]),  1e-3 },
+    { "raster us",   STATS_FIELD(phase_ns[STAT_PHASE_RASTER]),  1e-3 },
+    { "present us",  STATS_FIELD(phase_ns[STAT_PHASE_PRESENT]), 1e-3 },
+    { "cmd bytes",   STATS_FIELD(command_bytes),                1    },
+    { "cmd rect",    STATS_FIELD(commands[MU_COMMAND_RECT]),    1    },
+    { "cmd text",    STATS_FIELD(commands[MU_COMMAND_TEXT]),    1    },
+    { "cmd icon",    STATS_FIELD(commands[MU_COMMAND_ICON]),    1    },
+    { "cmd glyphs",  STATS_FIELD(commands[MU_COMMAND_GLYPHS]),  1    },
+    { "cmd clip",    STATS_FIELD(commands[MU_COMMAND_CLIP]),    1    },
+    { "cells write", STATS_FIELD(cells_written),                1    },
+    { "cells diff",  STATS_FIELD(cells_changed),                1    },
+    { "cache hit",   STATS_FIELD(cache_hits),                   1    },
+    { "cache miss",  STATS_FIELD(cache_misses),                 1    },
+    { "sgr",         STATS_FIELD(sgr),                          1    },
+    { "out bytes",   STATS_FIELD(bytes),                        1    },
+    { "writes",      STATS_FIELD(writes),                       1    },
+};
+
+void stats_window(mu_Context *ctx) {
+    char buf[32];
+    if (!mu_begin_window(ctx, "Stats", mu_rect(0, 0, 46, 19))) return;
+    mu_layout_row(ctx, 4, (int[]){13, 10, 10, -1}, 0);
+    mu_label(ctx, "metric");
+    mu_label(ctx, "min");
+    mu_label(ctx, "avg");
+    mu_label(ctx, "p99");
+    for (size_t i = 0; i < sizeof(g_metrics) / sizeof(g_metrics[0]); i++) {
+        StatSummary s = stats_summary(g_metrics[i].field);
+        mu_label(ctx, g_metrics[i].name);
+        sprintf(buf, "%.0f", s.min * g_metrics[i].scale); mu_label(ctx, buf);
+        sprintf(buf, "%.0f", s.avg * g_metrics[i].scale); mu_label(ctx, buf);
+        sprintf(buf, "%.0f", s.p99 * g_metrics[i].scale); mu_label(ctx, buf);
+    }
+    if (!g_stats_on) {
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        mu_label(ctx, "(stats disabled)");
+    }
+    mu_end_window(ctx);
+}
@@ -0,0 +1,56 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stddef.h>
+#include "microui.h"
+
+/* 每帧性能计数器. 帧以 mu_begin 为边界: 新一帧开始时上一帧进入历史.
+ * 运行时默认关闭, 关闭时每个计数点只有一次读取和分支;
+ * 定义 STATS_DISABLE 则全部编译为空. */
+
+enum { STAT_PHASE_LAYOUT, STAT_PHASE_RASTER, STAT_PHASE_PRESENT, STAT_PHASE_MAX };
+
+typedef struct {
+    long long commands[MU_COMMAND_MAX];     /* 按类型统计的命令数 */
+    long long command_bytes;                /* 命令列表已用字节 (含分块间的跳转) */
+    long long cells_written;                /* 光栅化写入的格子数 */
+    long long cells_changed;                /* 差分后实际输出的格子数 */
+    long long cache_hits;                   /* 直接贴缓存面的根容器数 */
+    long long cache_misses;                 /* 需要重新光栅化的根容器数 */
+    long long sgr;                          /* 输出的 SGR 序列数 */
+    long long bytes;                        /* 输出字节数 */
+    long long writes;                       /* write 系统调用次数 */
+    long long phase_ns[STAT_PHASE_MAX];     /* 各阶段耗时 */
+} FrameStats;
+
+typedef struct { double min, avg, p99; } StatSummary;
+
+#define STATS_HISTORY 128
+#define STATS_FIELD(f) offsetof(FrameStats, f)
+
+void stats_enable(int on);
+void stats_frame_begin(void);
+void stats_phase_begin(int phase);
+void stats_phase_end(int phase);
+const FrameStats *stats_last(void);                 /* 最近一个完整帧, 没有则为 NULL */
+int  stats_history(FrameStats *out, int max);       /* 由旧到新, 返回帧数 */
+StatSummary stats_summary(size_t field);            /* field 用 STATS_FIELD() 取得 */
+void stats_window(mu_Context *ctx);                 /* 内置的 microui 统计窗口 */
+
+#ifdef STATS_DISABLE
+#define STAT_ADD(field, n)      ((void)0)
+#define STAT_SET(field, n)      ((void)0)
+#define STAT_FRAME_BEGIN()      ((void)0)
+#define STAT_PHASE_BEGIN(p)     ((void)0)
+#define STAT_PHASE_END(p)       ((void)0)
+#else
+extern int        g_stats_on;
+extern FrameStats g_stats_cur;
+#define STAT_ADD(field, n)      do { if (g_stats_on) g_stats_cur.field += (n); } while (0)
+#define STAT_SET(field, n)      do { if (g_stats_on) g_stats_cur.field  = (n); } while (0)
+#define STAT_FRAME_BEGIN()      do { if (g_stats_on) stats_frame_begin(); } while (0)
+#define STAT_PHASE_BEGIN(p)     do { if (g_stats_on) stats_phase_begin(p); } while (0)
+#define STAT_PHASE_END(p)       do { if (g_stats_on) stats_phase_end(p); } while (0)
+#endif
+
+#endif /* __STATS_H__ */
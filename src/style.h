@@ -1,58 +1,107 @@
-#ifndef __STYLE_H__
-#define __STYLE_H__
-
-#include <stdio.h>
-#include <string.h>
-
-typedef struct {
-    int fg, bg;                 /* 24-bit color: 0xRRGGBB, -1 表示默认 */
-    union {
-        int raw;
-        struct {
-            unsigned bold      : 1;
-            unsigned underline : 1;
-            unsigned blink     : 1;
-            unsigned reverse   : 1;
-            unsigned strike    : 1;
-            unsigned italic    : 1;
-        };
-    };
-} style_t;
-
-static inline int style_color(char *dst, int code, int is_bg) {
-    return (code < 0) ? 0 : sprintf(dst, "%d;2;%d;%d;%d", is_bg ? 48 : 38,
-                            (code>>16)&0xFF, (code>>8)&0xFF, code&0xFF);
-}
-
-static inline style_t style_new(int fg, int bg, int attr) { 
-    return (style_t){fg, bg, attr};
-}
-
-static inline int style_cmp(style_t a, style_t b) {
-    return (a.fg != b.fg) || (a.bg != b.bg) || (a.raw != b.raw); 
-}
-
-static inline char* style_to_string(style_t s) {
-    if (!style_cmp(s, (style_t){-1,-1,0})) return "\x1b[0m\0";
-    static char seq[256];
-    char *p = seq;
-    
-    *p++ = '\x1b';
-    *p++ = '[';
-    p += style_color(p, s.fg, 0);
-    if (s.fg >= 0 && s.bg >= 0) *p++ = ';';
-    p += style_color(p, s.bg, 1);
-    const struct { int bit; int code; } attr[] = {
-        {s.bold,      1}, {s.italic,    3}, {s.underline, 4},
-        {s.blink,     5}, {s.reverse,   7}, {s.strike,    9}, };
-    for (size_t i = 0; i < sizeof(attr)/sizeof(attr[0]); ++i) {
-        if (!attr[i].bit) continue;
-        if (p != seq + 2) *p++ = ';';   
-        p += sprintf(p, "%d", attr[i].code);
-    }
-    *p++ = 'm';
-    *p   = '\0';
-    return seq;
-}
-
+#ifndef __STYLE_H__
+#define __STYLE_H__
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    int fg, bg;                 /* 24-bit color: 0xRRGGBB 或 STYLE_PALETTE|下标, -1 表示默认 */
+    union {
+        int raw;
+        struct {
+            unsigned bold      : 1;
+            unsigned underline : 1;
+            unsigned blink     : 1;
+            unsigned reverse   : 1;
+            unsigned strike    : 1;
+            unsigned italic    : 1;
+        };
+    };
+} style_t;
+
+#define STYLE_STR_MAX 64     /* style_to_buf 结果的最大长度(含结尾 0) */
+
+#define STYLE_PALETTE 0x1000000   /* 颜色带此标志时低 8 位是 256 色调色板下标, 用于降低色深 */
+
+/* xterm 256 色调色板: 16 个基本色, 6x6x6 色立方, 24 级灰 */
+static inline int style_palette_rgb(int i) {
+    static const int tbl[16] = {
+        0x000000, 0x800000, 0x008000, 0x808000, 0x000080, 0x800080, 0x008080, 0xC0C0C0,
+        0x808080, 0xFF0000, 0x00FF00, 0xFFFF00, 0x0000FF, 0xFF00FF, 0x00FFFF, 0xFFFFFF,
+    };
+    static const int lv[6] = {0, 95, 135, 175, 215, 255};
+    i &= 0xFF;
+    if (i < 16) return tbl[i];
+    if (i >= 232) { int v = 8 + (i - 232) * 10; return (v << 16) | (v << 8) | v; }
+    i -= 16;
+    return (lv[i / 36] << 16) | (lv[(i / 6) % 6] << 8) | lv[i % 6];
+}
+
+static inline int style_rgb_dist(int a, int b) {
+    int dr = ((a >> 16) & 0xFF) - ((b >> 16) & 0xFF);
+    int dg = ((a >> 8) & 0xFF) - ((b >> 8) & 0xFF);
+    int db = (a & 0xFF) - (b & 0xFF);
+    return dr * dr + dg * dg + db * db;
+}
+
+/* 把 24 位颜色换成最接近的调色板颜色; colors 为 256 或 16, 默认色(-1)不变 */
+static inline int style_quantize(int color, int colors) {
+    if (color < 0 || (color & STYLE_PALETTE)) return color;
+    int best = 0;
+    if (colors <= 16) {
+        for (int i = 1; i < 16; i++)
+            if (style_rgb_dist(color, style_palette_rgb(i)) < style_rgb_dist(color, style_palette_rgb(best))) best = i;
+    } else {
+        int c[3] = { (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF }, q[3];
+        for (int k = 0; k < 3; k++) q[k] = c[k] < 48 ? 0 : c[k] < 115 ? 1 : (c[k] - 35) / 40;
+        best = 16 + q[0] * 36 + q[1] * 6 + q[2];
+        int g = (c[0] + c[1] + c[2]) / 3;
+        g = g < 8 ? 0 : g > 238 ? 23 : (g - 3) / 10;
+        if (style_rgb_dist(color, style_palette_rgb(232 + g)) < style_rgb_dist(color, style_palette_rgb(best))) best = 232 + g;
+    }
+    return STYLE_PALETTE | best;
+}
+
+static inline int style_color(char *dst, int code, int is_bg) {
+    if (code < 0) return 0;
+    if (code & STYLE_PALETTE) {
+        int i = code & 0xFF;
+        if (i < 8)  return sprintf(dst, "%d", (is_bg ? 40 : 30) + i);
+        if (i < 16) return sprintf(dst, "%d", (is_bg ? 100 : 90) + i - 8);
+        return sprintf(dst, "%d;5;%d", is_bg ? 48 : 38, i);
+    }
+    return sprintf(dst, "%d;2;%d;%d;%d", is_bg ? 48 : 38, (code>>16)&0xFF, (code>>8)&0xFF, code&0xFF);
+}
+
+static inline style_t style_new(int fg, int bg, int attr) { 
+    return (style_t){fg, bg, {attr}};
+}
+
+static inline int style_cmp(style_t a, style_t b) {
+    return (a.fg != b.fg) || (a.bg != b.bg) || (a.raw != b.raw); 
+}
+
+/* 写入 dst(至少 STYLE_STR_MAX 字节), 返回长度; 不用静态缓冲, 可在多个线程里同时调用 */
+static inline int style_to_buf(style_t s, char *dst) {
+    if (!style_cmp(s, (style_t){-1,-1,{0}})) { memcpy(dst, "\x1b[0m", 5); return 4; }
+    char *p = dst;
+
+    *p++ = '\x1b';
+    *p++ = '[';
+    p += style_color(p, s.fg, 0);
+    if (s.fg >= 0 && s.bg >= 0) *p++ = ';';
+    p += style_color(p, s.bg, 1);
+    const struct { int bit; int code; } attr[] = {
+        {s.bold,      1}, {s.italic,    3}, {s.underline, 4},
+        {s.blink,     5}, {s.reverse,   7}, {s.strike,    9}, };
+    for (size_t i = 0; i < sizeof(attr)/sizeof(attr[0]); ++i) {
+        if (!attr[i].bit) continue;
+        if (p != dst + 2) *p++ = ';';
+        p += sprintf(p, "%d", attr[i].code);
+    }
+    *p++ = 'm';
+    *p   = '\0';
+    return (int)(p - dst);
+}
+
 #endif /* __STYLE_H__ */
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "table_view.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char *title;
+    int width;
+} TvColumn;
+
+struct table_view_t {
+    TvColumn *cols;
+    int  ncols;
+    int *xs;                /* xs[c] 为第 c 列相对表格左边的起点, xs[ncols] 为总宽 */
+    int  dirty;             /* 列宽变了, xs 需要重算 */
+    int  goto_row, goto_col;
+};
+
+table_view_t *tv_new(int cols, int width) {
+    table_view_t *tv = (table_view_t *)calloc(1, sizeof(*tv));
+    if (!tv) return NULL;
+    tv->ncols = cols > 0 ? cols : 1;
+    tv->cols = (TvColumn *)calloc(tv->ncols, sizeof(TvColumn));
+    tv->xs = (int *)calloc(tv->ncols + 1, sizeof(int));
+    if (!tv->cols || !tv->xs) { tv_free(tv); return NULL; }
+    for (int c = 0; c < tv->ncols; c++) tv->cols[c].width = mu_max(width, TV_COL_MIN);
+    tv->dirty = 1;
+    tv->goto_row = -1;
+    return tv;
+}
+
+void tv_free(table_view_t *tv) {
+    if (!tv) return;
+    free(tv->cols);
+    free(tv->xs);
+    free(tv);
+}
+
+void tv_set_column(table_view_t *tv, int col, const char *title, int width) {
+    if (col < 0 || col >= tv->ncols) return;
+    tv->cols[col].title = title;
+    tv->cols[col].width = mu_max(width, TV_COL_MIN);
+    tv->dirty = 1;
+}
+
+int tv_width(table_view_t *tv, int col) { return (col >= 0 && col < tv->ncols) ? tv->cols[col].width : 0; }
+
+void tv_scroll_to(table_view_t *tv, int row, int col) {
+    tv->goto_row = mu_max(row, 0);
+    tv->goto_col = mu_clamp(col, 0, tv->ncols - 1);
+}
+
+static void tv_update_xs(table_view_t *tv) {
+    if (!tv->dirty) return;
+    for (int c = 0; c < tv->ncols; c++) tv->xs[c + 1] = tv->xs[c] + tv->cols[c].width;
+    tv->dirty = 0;
+}
+
+/* 覆盖横坐标 x(相对表格左边)的列 */
+static int tv_col_at(table_view_t *tv, int x) {
+    int lo = 0, hi = tv->ncols - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (tv->xs[mid] <= x) lo = mid; else hi = mid - 1;
+    }
+    return lo;
+}
+
+/* 可见列范围 [*c0, *c1), 由 clip 与表格左边 x0 求出 */
+static void tv_visible_cols(table_view_t *tv, mu_Rect clip, int x0, int *c0, int *c1) {
+    *c0 = tv_col_at(tv, clip.x - x0);
+    *c1 = *c0;
+    while (*c1 < tv->ncols && x0 + tv->xs[*c1] < clip.x + clip.w) (*c1)++;
+}
+
+/* 文本宽过单元格时才压裁剪矩形, 避免每格多出两条命令 */
+static void tv_cell_text(mu_Context *ctx, const char *s, mu_Rect r, mu_Color color) {
+    mu_Font font = ctx->style->font;
+    if (!s || !*s || r.w <= 0) return;
+    if (ctx->text_width(font, s, -1) > r.w) {
+        mu_push_clip_rect(ctx, r);
+        mu_draw_text(ctx, font, s, -1, mu_vec2(r.x, r.y), color);
+        mu_pop_clip_rect(ctx);
+    } else {
+        mu_draw_text(ctx, font, s, -1, mu_vec2(r.x, r.y), color);
+    }
+}
+
+static void tv_header(mu_Context *ctx, table_view_t *tv, mu_Rect hr, int x0) {
+    mu_Style *style = ctx->style;
+    int th = hr.h, c0, c1;
+    mu_draw_rect(ctx, hr, style->colors[MU_COLOR_TITLEBG]);
+    mu_push_clip_rect(ctx, hr);
+    tv_visible_cols(tv, hr, x0, &c0, &c1);
+    for (int c = c0; c < c1; c++) {
+        int x = x0 + tv->xs[c], w = tv->cols[c].width;
+        tv_cell_text(ctx, tv->cols[c].title, mu_rect(x, hr.y, w - 1, th), style->colors[MU_COLOR_TITLETEXT]);
+        /* 列右边的间隔格就是拖动柄 */
+        mu_Rect handle = mu_rect(x + w - 1, hr.y, 1, th);
+        mu_Id id = mu_get_id(ctx, &c, sizeof(c));
+        mu_update_control(ctx, id, handle, 0);
+        if (ctx->focus == id && ctx->mouse_down == MU_MOUSE_LEFT && ctx->mouse_delta.x) {
+            tv->cols[c].width = mu_max(TV_COL_MIN, w + ctx->mouse_delta.x);
+            tv->dirty = 1;
+        }
+        if (ctx->hover == id || ctx->focus == id) {
+            mu_draw_rect(ctx, handle, style->colors[ctx->focus == id ? MU_COLOR_BUTTONFOCUS : MU_COLOR_BUTTONHOVER]);
+        }
+    }
+    mu_pop_clip_rect(ctx);
+}
+
+void tv_draw(mu_Context *ctx, const char *name, table_view_t *tv, int rows, tv_cell_fn cell, void *user) {
+    char buf[TV_CELL_MAX];
+    mu_Font font = ctx->style->font;
+    mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
+    int th = ctx->text_height(font);
+    tv_update_xs(tv);
+
+    mu_layout_row(ctx, 1, (int[]){-1}, th);
+    mu_Rect hr = mu_layout_next(ctx);
+    mu_layout_row(ctx, 1, (int[]){-1}, -1);
+    mu_begin_panel_ex(ctx, name, MU_OPT_NOFRAME);
+    mu_Container *cnt = mu_get_current_container(ctx);
+    int pad = ctx->style->padding;
+    int x0 = cnt->body.x + pad - cnt->scroll.x;
+    int y0 = cnt->body.y + pad - cnt->scroll.y;
+
+    /* 只遍历与裁剪矩形相交的行和列, 不走逐格布局 */
+    mu_Rect clip = mu_get_clip_rect(ctx);
+    if (clip.w > 0 && clip.h > 0 && rows > 0) {
+        int r0 = mu_max(0, (clip.y - y0) / th);
+        int r1 = mu_min(rows, (clip.y + clip.h - y0 + th - 1) / th);
+        int c0, c1;
+        tv_visible_cols(tv, clip, x0, &c0, &c1);
+        for (int r = r0; r < r1; r++) {
+            int y = y0 + r * th;
+            for (int c = c0; c < c1; c++) {
+                mu_Rect cr = mu_rect(x0 + tv->xs[c], y, tv->cols[c].width - 1, th);
+                tv_cell_text(ctx, cell(user, r, c, buf, sizeof(buf)), cr, color);
+            }
+        }
+    }
+    /* 用一个覆盖整张表的占位矩形撑出 content_size, 滚动条据此计算 */
+    mu_layout_set_next(ctx, mu_rect(0, 0, tv->xs[tv->ncols], rows * th), 1);
+    mu_layout_next(ctx);
+
+    if (tv->goto_row >= 0) {
+        /* 下一帧 scrollbar 会把它夹到合法范围 */
+        cnt->scroll.x = pad + tv->xs[tv->goto_col];
+        cnt->scroll.y = pad + tv->goto_row * th;
+        tv->goto_row = -1;
+    }
+    mu_Rect body = cnt->body;
+    mu_end_panel(ctx);
+
+    /* 表头在表体之后画, 用本帧最终的横向滚动量对齐; 宽度与表体一致, 不盖住滚动条上方 */
+    hr.x = body.x;
+    hr.w = body.w;
+    mu_push_id(ctx, name, strlen(name));
+    tv_header(ctx, tv, hr, x0);
+    mu_pop_id(ctx);
+}
@@ -0,0 +1,26 @@
+#ifndef __TABLE_VIEW_H__
+#define __TABLE_VIEW_H__
+
+#include "microui.h"
+
+/* 表格控件: 表头固定在顶部, 只随表体横向滚动; 行和列都按可见范围裁剪, 只有可见的
+ * 单元格会调用 cell 回调取文本、测量并绘制, 数据不复制. 列宽可拖动表头分隔线调整,
+ * 各列起点的前缀和缓存在控件里, 列宽变化时才重算. */
+
+#define TV_COL_MIN   2              /* 拖动调整时的最小列宽 */
+#define TV_CELL_MAX  256            /* 传给 cell 回调的缓冲区大小 */
+
+/* 返回第 row 行第 col 列的文本: 可以写进 buf 后返回 buf, 也可以直接返回调用方自己的字符串 */
+typedef const char *(*tv_cell_fn)(void *user, int row, int col, char *buf, int cap);
+
+typedef struct table_view_t table_view_t;
+
+table_view_t *tv_new(int cols, int width);              /* cols 列, 初始列宽 width(含 1 格列间距) */
+void tv_free(table_view_t *tv);
+void tv_set_column(table_view_t *tv, int col, const char *title, int width);  /* title 不复制, 需一直有效 */
+int  tv_width(table_view_t *tv, int col);
+void tv_scroll_to(table_view_t *tv, int row, int col);  /* 下一次 tv_draw 时让该单元格出现在左上角 */
+/* 在当前容器里占满剩余空间绘制表格; name 在容器内唯一 */
+void tv_draw(mu_Context *ctx, const char *name, table_view_t *tv, int rows, tv_cell_fn cell, void *user);
+
+#endif /* __TABLE_VIEW_H__ */
@@ -1,166 +1,303 @@
-#include "term.h"
-#include <stdio.h>
-
-static HANDLE g_con_in, g_con_out;
-static DWORD g_old_in_mode, g_old_out_mode;
-static int g_cols = 0, g_rows = 0;
-int term_init(void) {
-    g_con_in = GetStdHandle(STD_INPUT_HANDLE);
-    g_con_out = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (g_con_in == INVALID_HANDLE_VALUE || g_con_out == INVALID_HANDLE_VALUE)
-        return -1;
-
-    GetConsoleMode(g_con_in, &g_old_in_mode);
-    GetConsoleMode(g_con_out, &g_old_out_mode);
-
-    SetConsoleOutputCP(65001); // CP_UTF8
-    SetConsoleCP(65001);
-
-    DWORD in_mode = ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT | 0x0080; // ENABLE_EXTENDED_FLAGS
-    in_mode &= ~0x0040; // ENABLE_QUICK_EDIT_MODE
-    in_mode &= ~0x0020; // ENABLE_INSERT_MODE
-    
-    if (!SetConsoleMode(g_con_in, in_mode)) {
-        in_mode = ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT;
-        SetConsoleMode(g_con_in, in_mode);
-    }
-
-    SetConsoleMode(g_con_out, g_old_out_mode | 0x0004); // ENABLE_VIRTUAL_TERMINAL_PROCESSING
-
-    return 0;
-}
-
-void term_shutdown(void) {
-    SetConsoleMode(g_con_in, g_old_in_mode);
-    SetConsoleMode(g_con_out, g_old_out_mode);
-    SetConsoleOutputCP(GetConsoleOutputCP());
-}
-
-static void update_size(void) {
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    if (GetConsoleScreenBufferInfo(g_con_out, &csbi)) {
-        g_cols = csbi.srWindow.Right - csbi.srWindow.Left + 1;
-        g_rows = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
-    }
-}
-
-void term_get_size(int* width, int* height) { update_size(); *width = g_cols; *height = g_rows; }
-void term_hide_cursor(void) { printf("\033[?25l"); fflush(stdout); }
-void term_show_cursor(void) { printf("\033[u"); fflush(stdout); }
-void term_move_cursor(int x, int y) { printf("\033[%d;%dH", y, x); fflush(stdout); }
-void term_print_at(int x, int y, const char *text) { printf("\033[%d;%dH%s", y, x, text); fflush(stdout); }
-void term_flush_input(void) { fflush(stdout); }
-void term_clear_screen(void) { printf("\033[2J\033[1;1H"); fflush(stdout); }
-void term_save_cursor(void) { printf("\033[s"); fflush(stdout); }
-static TermMouseEvent make_mouse_event(const MOUSE_EVENT_RECORD *m) {
-    TermMouseEvent e = {0};
-    static DWORD last_left_down = 0;
-    
-    if (m->dwEventFlags == 0) {
-        if (m->dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED) {
-            DWORD now = GetTickCount();
-            e.type = (now - last_left_down < 400) ? TERM_MOUSE_DOUBLE_CLICK : TERM_MOUSE_LEFT_DOWN;
-            last_left_down = now;
-        }
-        else if (m->dwButtonState & RIGHTMOST_BUTTON_PRESSED) e.type = TERM_MOUSE_RIGHT_DOWN;
-        else if (m->dwButtonState & FROM_LEFT_2ND_BUTTON_PRESSED) e.type = TERM_MOUSE_MIDDLE_DOWN;
-        else e.type = TERM_MOUSE_LEFT_UP;
-    }
-    else if (m->dwEventFlags == MOUSE_MOVED) e.type = TERM_MOUSE_MOVE;
-    else if (m->dwEventFlags == MOUSE_WHEELED) {
-        e.type = TERM_MOUSE_WHEEL;
-        e.wheel = ((SHORT)HIWORD(m->dwButtonState)) / WHEEL_DELTA;
-    }
-    else e.type = TERM_MOUSE_NONE;
-
-    e.x = m->dwMousePosition.X + 1;
-    e.y = m->dwMousePosition.Y + 1;
-    if (m->dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED) e.btn |= 1;
-    if (m->dwButtonState & RIGHTMOST_BUTTON_PRESSED) e.btn |= 2;
-    if (m->dwButtonState & FROM_LEFT_2ND_BUTTON_PRESSED) e.btn |= 4;
-    e.ctrl = m->dwControlKeyState;
-    
-    return e;
-}
-
-static TermKeyEvent make_key_event(const KEY_EVENT_RECORD *k) {
-    TermKeyEvent e = {0};
-    e.key_code = k->wVirtualKeyCode;
-    e.ctrl_code = k->dwControlKeyState;
-    e.pressed = k->bKeyDown;
-    e.repeat = k->wRepeatCount;
-    e.scan = k->wVirtualScanCode;
-    
-    WCHAR wch = k->uChar.UnicodeChar;
-    if (wch != 0) {
-        char *out = e.utf8;
-        if (wch < 0x80) *out++ = (char)wch;
-        else if (wch < 0x800) {
-            *out++ = (char)(0xC0 | (wch >> 6));
-            *out++ = (char)(0x80 | (wch & 0x3F));
-        }
-        else if (wch < 0x10000) {
-            *out++ = (char)(0xE0 | (wch >> 12));
-            *out++ = (char)(0x80 | ((wch >> 6) & 0x3F));
-            *out++ = (char)(0x80 | (wch & 0x3F));
-        }
-        *out = '\0';
-        return e;
-    }
-
-    if (k->wVirtualKeyCode != 0) {
-        BYTE kb[256] = {0};
-        GetKeyboardState(kb);
-        WCHAR buf[8];
-        int n = ToUnicodeEx(k->wVirtualKeyCode, k->wVirtualScanCode, kb, buf, 8, 0, GetKeyboardLayout(0));
-        if (n > 0) {
-            char *out = e.utf8;
-            for (int i = 0; i < n; ++i) {
-                unsigned cp = buf[i];
-                if (cp < 0x80) *out++ = (char)cp;
-                else if (cp < 0x800) {
-                    *out++ = (char)(0xC0 | (cp >> 6));
-                    *out++ = (char)(0x80 | (cp & 0x3F));
-                }
-                else if (cp < 0x10000) {
-                    *out++ = (char)(0xE0 | (cp >> 12));
-                    *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
-                    *out++ = (char)(0x80 | (cp & 0x3F));
-                }
-            }
-            *out = '\0';
-        }
-    }
-    
-    return e;
-}
-
-TermEvent term_poll_event(void) {
-    TermEvent ev = { .type = TERM_EV_NONE };
-    DWORD cnt = 0;
-    INPUT_RECORD rec;
-    
-    if (!PeekConsoleInputW(g_con_in, &rec, 1, &cnt) || cnt == 0)
-        return ev;
-    
-    ReadConsoleInputW(g_con_in, &rec, 1, &cnt);
-
-    switch (rec.EventType) {
-    case KEY_EVENT:
-        ev.type = TERM_EV_KEY;
-        ev.u.key = make_key_event(&rec.Event.KeyEvent);
-        break;
-    case MOUSE_EVENT:
-        ev.type = TERM_EV_MOUSE;
-        ev.u.mouse = make_mouse_event(&rec.Event.MouseEvent);
-        break;
-    case WINDOW_BUFFER_SIZE_EVENT:
-        ev.type = TERM_EV_RESIZE;
-        update_size();
-        ev.u.size.cols = g_cols;
-        ev.u.size.rows = g_rows;
-        break;
-    }
-    
-    return ev;
-}
+#include "term.h"
+#include "stats.h"
+#include "thread.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+/* ---------- 与后端无关的输出 ---------- */
+static void term_writef(const char *fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > (int)sizeof(buf) - 1) n = sizeof(buf) - 1;
+    if (n > 0) term_write(buf, n);
+}
+
+void term_hide_cursor(void) { term_writef("\033[?25l"); term_flush(); }
+void term_show_cursor(void) { term_writef("\033[u"); term_flush(); }
+void term_move_cursor(int x, int y) { term_writef("\033[%d;%dH", y, x); term_flush(); }
+void term_print_at(int x, int y, const char *text) { term_writef("\033[%d;%dH", y, x); term_write(text, strlen(text)); term_flush(); }
+void term_flush_input(void) { term_flush(); }
+void term_clear_screen(void) { term_writef("\033[2J\033[1;1H"); term_flush(); }
+void term_save_cursor(void) { term_writef("\033[s"); term_flush(); }
+
+/* ---------- 与后端无关的输入线程 ----------
+ * 单生产者单消费者: head 只由输入线程推进, tail 只由 UI 线程推进, 各自对另一方只读,
+ * 不需要 CAS. 槽的内容在 head 发布(release)之前写好, 消费者 acquire 读到 head 后再读槽.
+ * 状态都在实例里, 每个输入源一个实例. */
+typedef struct {
+    TermEvent e;
+    long long t_ns;
+} TermInputSlot;
+
+#define TERM_INPUT_MASK (TERM_INPUT_SLOTS - 1)
+
+struct term_input_t {
+    TermInputSlot   ring[TERM_INPUT_SLOTS];
+    volatile atom_t head, tail;
+    volatile atom_t stop, stalls;
+    term_read_fn    read;
+    void           *user;
+    thread_t        thread;
+    int             running;
+};
+
+static int term_read_default(void *user, TermEvent *out, int max, int timeout_ms) {
+    (void)user;
+    return term_read_events(out, max, timeout_ms);
+}
+
+static void input_thread(void *arg) {
+    term_input_t *in = (term_input_t *)arg;
+    TermEvent buf[64];
+    while (!atom_load(&in->stop)) {
+        int n = in->read(in->user, buf, 64, TERM_INPUT_WAIT_MS);
+        long long now = timer_ns();     /* 同一次读到的事件共用读入时刻 */
+        atom_t head = in->head;
+        for (int i = 0; i < n; i++) {
+            while (head - atom_load(&in->tail) == TERM_INPUT_SLOTS) {
+                if (atom_load(&in->stop)) return;
+                atom_add(&in->stalls, 1);
+                thread_sleep_ms(1);
+            }
+            in->ring[head & TERM_INPUT_MASK].e = buf[i];
+            in->ring[head & TERM_INPUT_MASK].t_ns = now;
+            atom_store(&in->head, ++head);
+        }
+    }
+}
+
+term_input_t *term_input_start(term_read_fn read, void *user) {
+    term_input_t *in = (term_input_t *)calloc(1, sizeof(*in));
+    if (!in) return NULL;
+    in->read = read ? read : term_read_default;
+    in->user = user;
+    if (thread_create(&in->thread, input_thread, in)) { free(in); return NULL; }
+    in->running = 1;
+    return in;
+}
+
+/* 队列里没取走的事件保留, 之后 term_input_poll 先取完它们再直接读输入源 */
+void term_input_stop(term_input_t *in) {
+    if (!in || !in->running) return;
+    atom_store(&in->stop, 1);
+    thread_join(in->thread);
+    in->running = 0;
+}
+
+void term_input_free(term_input_t *in) {
+    term_input_stop(in);
+    free(in);
+}
+
+TermEvent term_input_poll(term_input_t *in, long long *t_ns) {
+    TermEvent e = { .type = TERM_EV_NONE };
+    if (!in) {
+        e = term_poll_event();
+        if (t_ns) *t_ns = timer_ns();
+        return e;
+    }
+    atom_t tail = in->tail;
+    if (tail != atom_load(&in->head)) {
+        TermInputSlot *s = &in->ring[tail & TERM_INPUT_MASK];
+        e = s->e;
+        if (t_ns) *t_ns = s->t_ns;
+        atom_store(&in->tail, tail + 1);
+        return e;
+    }
+    if (in->running) return e;
+    in->read(in->user, &e, 1, 0);
+    if (t_ns) *t_ns = timer_ns();
+    return e;
+}
+
+unsigned long term_input_stalls(term_input_t *in) { return in ? atom_load(&in->stalls) : 0; }
+
+#ifndef TERM_HEADLESS
+/* ---------- Win32 控制台后端 ---------- */
+static HANDLE g_con_in, g_con_out;
+static DWORD g_old_in_mode, g_old_out_mode;
+static int g_cols = 0, g_rows = 0;
+int term_init(void) {
+    g_con_in = GetStdHandle(STD_INPUT_HANDLE);
+    g_con_out = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (g_con_in == INVALID_HANDLE_VALUE || g_con_out == INVALID_HANDLE_VALUE)
+        return -1;
+
+    GetConsoleMode(g_con_in, &g_old_in_mode);
+    GetConsoleMode(g_con_out, &g_old_out_mode);
+
+    SetConsoleOutputCP(65001); // CP_UTF8
+    SetConsoleCP(65001);
+
+    DWORD in_mode = ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT | 0x0080; // ENABLE_EXTENDED_FLAGS
+    in_mode &= ~0x0040; // ENABLE_QUICK_EDIT_MODE
+    in_mode &= ~0x0020; // ENABLE_INSERT_MODE
+    
+    if (!SetConsoleMode(g_con_in, in_mode)) {
+        in_mode = ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT;
+        SetConsoleMode(g_con_in, in_mode);
+    }
+
+    SetConsoleMode(g_con_out, g_old_out_mode | 0x0004); // ENABLE_VIRTUAL_TERMINAL_PROCESSING
+
+    return 0;
+}
+
+void term_shutdown(void) {
+    SetConsoleMode(g_con_in, g_old_in_mode);
+    SetConsoleMode(g_con_out, g_old_out_mode);
+    SetConsoleOutputCP(GetConsoleOutputCP());
+}
+
+static void update_size(void) {
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    if (GetConsoleScreenBufferInfo(g_con_out, &csbi)) {
+        g_cols = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+        g_rows = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+    }
+}
+
+void term_get_size(int* width, int* height) { update_size(); *width = g_cols; *height = g_rows; }
+static int g_unflushed;
+void term_write(const char *buf, int len) { fwrite(buf, 1, len, stdout); g_unflushed = 1; STAT_ADD(bytes, len); }
+void term_flush(void) { fflush(stdout); if (g_unflushed) STAT_ADD(writes, 1); g_unflushed = 0; }
+
+static TermMouseEvent make_mouse_event(const MOUSE_EVENT_RECORD *m) {
+    TermMouseEvent e = {0};
+    static DWORD last_left_down = 0;
+    
+    if (m->dwEventFlags == 0) {
+        if (m->dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED) {
+            DWORD now = GetTickCount();
+            e.type = (now - last_left_down < 400) ? TERM_MOUSE_DOUBLE_CLICK : TERM_MOUSE_LEFT_DOWN;
+            last_left_down = now;
+        }
+        else if (m->dwButtonState & RIGHTMOST_BUTTON_PRESSED) e.type = TERM_MOUSE_RIGHT_DOWN;
+        else if (m->dwButtonState & FROM_LEFT_2ND_BUTTON_PRESSED) e.type = TERM_MOUSE_MIDDLE_DOWN;
+        else e.type = TERM_MOUSE_LEFT_UP;
+    }
+    else if (m->dwEventFlags == MOUSE_MOVED) e.type = TERM_MOUSE_MOVE;
+    else if (m->dwEventFlags == MOUSE_WHEELED) {
+        e.type = TERM_MOUSE_WHEEL;
+        e.wheel = ((SHORT)HIWORD(m->dwButtonState)) / WHEEL_DELTA;
+    }
+    else e.type = TERM_MOUSE_NONE;
+
+    e.x = m->dwMousePosition.X;
+    e.y = m->dwMousePosition.Y;
+    if (m->dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED) e.btn |= 1;
+    if (m->dwButtonState & RIGHTMOST_BUTTON_PRESSED) e.btn |= 2;
+    if (m->dwButtonState & FROM_LEFT_2ND_BUTTON_PRESSED) e.btn |= 4;
+    e.ctrl = m->dwControlKeyState;
+    
+    return e;
+}
+
+static TermKeyEvent make_key_event(const KEY_EVENT_RECORD *k) {
+    TermKeyEvent e = {0};
+    e.key_code = k->wVirtualKeyCode;
+    e.ctrl_code = k->dwControlKeyState;
+    e.pressed = k->bKeyDown;
+    e.repeat = k->wRepeatCount;
+    e.scan = k->wVirtualScanCode;
+    
+    WCHAR wch = k->uChar.UnicodeChar;
+    if (wch != 0) {
+        char *out = e.utf8;
+        if (wch < 0x80) *out++ = (char)wch;
+        else if (wch < 0x800) {
+            *out++ = (char)(0xC0 | (wch >> 6));
+            *out++ = (char)(0x80 | (wch & 0x3F));
+        }
+        else if (wch < 0x10000) {
+            *out++ = (char)(0xE0 | (wch >> 12));
+            *out++ = (char)(0x80 | ((wch >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (wch & 0x3F));
+        }
+        *out = '\0';
+        return e;
+    }
+
+    if (k->wVirtualKeyCode != 0) {
+        BYTE kb[256] = {0};
+        GetKeyboardState(kb);
+        WCHAR buf[8];
+        int n = ToUnicodeEx(k->wVirtualKeyCode, k->wVirtualScanCode, kb, buf, 8, 0, GetKeyboardLayout(0));
+        if (n > 0) {
+            char *out = e.utf8;
+            for (int i = 0; i < n; ++i) {
+                unsigned cp = buf[i];
+                if (cp < 0x80) *out++ = (char)cp;
+                else if (cp < 0x800) {
+                    *out++ = (char)(0xC0 | (cp >> 6));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                }
+                else if (cp < 0x10000) {
+                    *out++ = (char)(0xE0 | (cp >> 12));
+                    *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                }
+            }
+            *out = '\0';
+        }
+    }
+    
+    return e;
+}
+
+/* 控制台输入记录转成事件, 不关心的记录(焦点, 菜单)返回 0 */
+static int make_event(const INPUT_RECORD *rec, TermEvent *ev) {
+    memset(ev, 0, sizeof(*ev));
+    switch (rec->EventType) {
+    case KEY_EVENT:
+        ev->type = TERM_EV_KEY;
+        ev->u.key = make_key_event(&rec->Event.KeyEvent);
+        return 1;
+    case MOUSE_EVENT:
+        ev->type = TERM_EV_MOUSE;
+        ev->u.mouse = make_mouse_event(&rec->Event.MouseEvent);
+        return 1;
+    case WINDOW_BUFFER_SIZE_EVENT:
+        ev->type = TERM_EV_RESIZE;
+        update_size();
+        ev->u.size.cols = g_cols;
+        ev->u.size.rows = g_rows;
+        return 1;
+    }
+    return 0;
+}
+
+TermEvent term_poll_event(void) {
+    TermEvent ev = { .type = TERM_EV_NONE };
+    DWORD cnt = 0;
+    INPUT_RECORD rec;
+    
+    if (!PeekConsoleInputW(g_con_in, &rec, 1, &cnt) || cnt == 0)
+        return ev;
+    
+    ReadConsoleInputW(g_con_in, &rec, 1, &cnt);
+    make_event(&rec, &ev);
+    return ev;
+}
+
+int term_read_events(TermEvent *out, int max, int timeout_ms) {
+    INPUT_RECORD recs[64];
+    DWORD cnt = 0;
+    int n = 0;
+    if (WaitForSingleObject(g_con_in, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms) != WAIT_OBJECT_0)
+        return 0;
+    /* 句柄有信号时已有记录, ReadConsoleInputW 不会再等; 一次取走全部, 粘贴时不再一条一次系统调用 */
+    if (!ReadConsoleInputW(g_con_in, recs, max < 64 ? max : 64, &cnt))
+        return 0;
+    for (DWORD i = 0; i < cnt; i++)
+        if (make_event(&recs[i], &out[n])) n++;
+    return n;
+}
+
+#endif /* TERM_HEADLESS */
@@ -1,66 +1,115 @@
-#ifndef __TERM_H__
-#define __TERM_H__
-
-#include <windows.h>
-
-typedef enum {
-    TERM_MOUSE_NONE = 0, TERM_MOUSE_MOVE, TERM_MOUSE_LEFT_DOWN, TERM_MOUSE_LEFT_UP, TERM_MOUSE_RIGHT_DOWN,
-    TERM_MOUSE_RIGHT_UP, TERM_MOUSE_MIDDLE_DOWN, TERM_MOUSE_MIDDLE_UP, TERM_MOUSE_WHEEL, TERM_MOUSE_DOUBLE_CLICK
-} TermMouseEventType;
-
-typedef struct {
-    int key_code;   
-    union {
-        int ctrl_code;
-        struct {
-            int right_alt_pressed   : 1;
-            int left_alt_pressed    : 1;
-            int right_ctrl_pressed  : 1;
-            int left_ctrl_pressed   : 1;
-            int shift_pressed       : 1;
-            int num_lock_on         : 1;
-            int scroll_lock_on      : 1;
-            int caps_lock_on        : 1;
-            int enhanced_key        : 1;
-        };
-    }; 
-    char utf8[5];   // 0结尾
-    int pressed;      
-    int repeat;       
-    unsigned int scan;
-} TermKeyEvent;
-
-typedef struct {
-    TermMouseEventType type;
-    int x, y; 
-    int btn;        // 1|2|4
-    int ctrl; 
-    int wheel; 
-} TermMouseEvent;
-
-typedef enum { TERM_EV_NONE = 0, TERM_EV_KEY, TERM_EV_MOUSE, TERM_EV_RESIZE } TermEventType;
-typedef struct {
-    TermEventType type;
-    union {
-        TermKeyEvent  key;
-        TermMouseEvent mouse;
-        struct { int cols, rows; } size;
-    } u;
-} TermEvent;
-
-int  term_init(void);       
-void term_shutdown(void);      
-void term_get_size(int* width, int* height);
-TermEvent term_poll_event(void); // 非堵塞
-
-// 光标操作
-void term_hide_cursor(void);
-void term_clear_screen(void);
-void term_move_cursor(int x, int y);
-void term_print_at(int x, int y, const char *text);
-void term_flush_input(void);
-void term_save_cursor(void);
-void term_show_cursor(void);
-
-
+#ifndef __TERM_H__
+#define __TERM_H__
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 按键码取 Win32 虚拟键码的值, 其他平台的输入解码(vt_input.h)也产生同样的值
+enum {
+    TERM_KEY_BACK = 0x08, TERM_KEY_TAB = 0x09, TERM_KEY_RETURN = 0x0D, TERM_KEY_ESCAPE = 0x1B,
+    TERM_KEY_PRIOR = 0x21, TERM_KEY_NEXT, TERM_KEY_END, TERM_KEY_HOME,
+    TERM_KEY_LEFT, TERM_KEY_UP, TERM_KEY_RIGHT, TERM_KEY_DOWN,
+    TERM_KEY_INSERT = 0x2D, TERM_KEY_DELETE = 0x2E
+};
+
+typedef enum {
+    TERM_MOUSE_NONE = 0, TERM_MOUSE_MOVE, TERM_MOUSE_LEFT_DOWN, TERM_MOUSE_LEFT_UP, TERM_MOUSE_RIGHT_DOWN,
+    TERM_MOUSE_RIGHT_UP, TERM_MOUSE_MIDDLE_DOWN, TERM_MOUSE_MIDDLE_UP, TERM_MOUSE_WHEEL, TERM_MOUSE_DOUBLE_CLICK
+} TermMouseEventType;
+
+typedef struct {
+    int key_code;   
+    union {
+        int ctrl_code;
+        struct {
+            int right_alt_pressed   : 1;
+            int left_alt_pressed    : 1;
+            int right_ctrl_pressed  : 1;
+            int left_ctrl_pressed   : 1;
+            int shift_pressed       : 1;
+            int num_lock_on         : 1;
+            int scroll_lock_on      : 1;
+            int caps_lock_on        : 1;
+            int enhanced_key        : 1;
+        };
+    }; 
+    char utf8[5];   // 0结尾
+    int pressed;      
+    int repeat;       
+    unsigned int scan;
+} TermKeyEvent;
+
+typedef struct {
+    TermMouseEventType type;
+    int x, y;       // 0 起始, 与 renderer_t 的格子坐标一致
+    int btn;        // 1|2|4
+    int ctrl; 
+    int wheel; 
+} TermMouseEvent;
+
+typedef enum { TERM_EV_NONE = 0, TERM_EV_KEY, TERM_EV_MOUSE, TERM_EV_RESIZE } TermEventType;
+typedef struct {
+    TermEventType type;
+    union {
+        TermKeyEvent  key;
+        TermMouseEvent mouse;
+        struct { int cols, rows; } size;
+    } u;
+} TermEvent;
+
+int  term_init(void);       
+void term_shutdown(void);      
+void term_get_size(int* width, int* height);
+TermEvent term_poll_event(void); // 非堵塞
+// 堵塞读取: 至多等 timeout_ms 毫秒(<0 一直等), 一次取出已到的至多 max 个事件, 返回个数
+int  term_read_events(TermEvent *out, int max, int timeout_ms);
+
+// 输入线程(可选): 后台线程堵塞在输入源上读取, 事件连同读入时刻放进单生产者单消费者环形队列,
+// UI 线程用 term_input_poll 取出, 不再有系统调用. 队列满时输入线程等待 UI 线程消费, 不丢事件.
+// 队列和线程都属于实例, 没有全局状态; 每个输入源(本进程终端, 或调用方提供的 read)一个实例
+#define TERM_INPUT_SLOTS    4096    // 环形队列槽数, 2 的幂
+#define TERM_INPUT_WAIT_MS  50      // 输入线程单次等待的上限, 也是停止时的最长延迟
+typedef struct term_input_t term_input_t;
+// 与 term_read_events 同样的约定: 至多等 timeout_ms 毫秒, 返回读到的事件数
+typedef int (*term_read_fn)(void *user, TermEvent *out, int max, int timeout_ms);
+term_input_t *term_input_start(term_read_fn read, void *user);  // read 为 NULL 时读本进程终端, 须在 term_init 之后; 失败返回 NULL
+void term_input_stop(term_input_t *in);         // 停止线程, 队列里的事件仍可取出; 读终端时在 term_shutdown 之前调用
+void term_input_free(term_input_t *in);         // 停止并释放; in 可为 NULL
+TermEvent term_input_poll(term_input_t *in, long long *t_ns);   // 非堵塞; t_ns 可为 NULL, 否则得到读入时刻(timer_ns). in 为 NULL 或已停止且取空时直接读输入源
+unsigned long term_input_stalls(term_input_t *in);              // 输入线程因队列满而等待的次数
+
+// 输出: 先写入缓冲, term_flush 时才真正落到终端(一次系统调用)
+void term_write(const char *buf, int len);
+void term_flush(void);
+
+// 光标操作
+void term_hide_cursor(void);
+void term_clear_screen(void);
+void term_move_cursor(int x, int y);
+void term_print_at(int x, int y, const char *text);
+void term_flush_input(void);
+void term_save_cursor(void);
+void term_show_cursor(void);
+
+#ifdef TERM_HEADLESS
+// 无头后端(term_headless.c): 输出进入内存 VT 模拟器, 输入来自脚本事件队列
+#include "vt.h"
+
+typedef struct {
+    long long bytes;    // term_write 写入的字节数
+    long long writes;   // 有数据的 term_flush 次数, 对应真实后端的 write 系统调用
+} TermIoStats;
+
+void  term_headless_resize(int cols, int rows);     // 初始化后调用会投递 TERM_EV_RESIZE
+void  term_headless_push(TermEvent e);
+void  term_headless_push_key(int key_code, const char *utf8);
+void  term_headless_push_mouse(TermMouseEventType type, int x, int y, int btn);
+int   term_headless_pending(void);
+vt_t *term_headless_screen(void);
+TermIoStats term_headless_stats(void);
+void  term_headless_reset_stats(void);
+void  term_headless_discard(int on);    // 1: 输出只计数不解析, 基准测试时排除模拟器开销
+#endif
+
 #endif /* __TERM_H__ */
\ No newline at end of file
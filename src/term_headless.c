@@ -0,0 +1,175 @@
+#include "term.h"
+#include "stats.h"
+#include "thread.h"
+#include "timer.h"
+
+#ifdef TERM_HEADLESS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 无头后端: 输出写入内存缓冲, flush 时喂给 VT 模拟器; 输入来自脚本队列 */
+
+static vt_t *g_vt;
+static int   g_cols = 80, g_rows = 24;
+
+static char *g_pending;
+static int   g_pending_len, g_pending_cap;
+static TermIoStats g_stats;
+static int   g_discard;
+
+/* 脚本线程写入, 输入线程(term_input_start)可能同时读出, 用互斥锁保护;
+ * 读的一方没有事件时在条件变量上等, 写入时唤醒 */
+static TermEvent *g_queue;
+static int        g_q_head, g_q_len, g_q_cap;
+static mutex_t    g_q_mutex;
+static cond_t     g_q_cond;
+static int        g_q_ready;
+
+/* 第一次使用总在主线程(输入线程要等 term_input_start 才有), 懒初始化不需要再加锁 */
+static void q_lock(void) {
+    if (!g_q_ready) {
+        mutex_init(&g_q_mutex);
+        cond_init(&g_q_cond);
+        g_q_ready = 1;
+    }
+    mutex_lock(&g_q_mutex);
+}
+
+static void q_unlock(void) { mutex_unlock(&g_q_mutex); }
+
+int term_init(void) {
+    if (!g_vt) g_vt = vt_new(g_cols, g_rows);
+    return g_vt ? 0 : -1;
+}
+
+void term_shutdown(void) {
+    term_flush();
+}
+
+void term_get_size(int* width, int* height) { *width = g_cols; *height = g_rows; }
+
+void term_write(const char *buf, int len) {
+    if (len <= 0) return;
+    if (g_pending_len + len > g_pending_cap) {
+        int cap = g_pending_cap ? g_pending_cap : 4096;
+        while (cap < g_pending_len + len) cap *= 2;
+        char *p = (char *)realloc(g_pending, cap);
+        if (!p) return;
+        g_pending = p;
+        g_pending_cap = cap;
+    }
+    memcpy(g_pending + g_pending_len, buf, len);
+    g_pending_len += len;
+    g_stats.bytes += len;
+    STAT_ADD(bytes, len);
+}
+
+void term_flush(void) {
+    if (!g_pending_len) return;
+    if (g_vt && !g_discard) vt_feed(g_vt, g_pending, g_pending_len);
+    g_pending_len = 0;
+    g_stats.writes++;
+    STAT_ADD(writes, 1);
+}
+
+/* 调用时已持有锁 */
+static int q_pop_locked(TermEvent *out, int max) {
+    int n = 0;
+    for (; n < max && g_q_len; n++) {
+        out[n] = g_queue[g_q_head];
+        g_q_head = (g_q_head + 1) % g_q_cap;
+        g_q_len--;
+    }
+    return n;
+}
+
+TermEvent term_poll_event(void) {
+    TermEvent ev = { .type = TERM_EV_NONE };
+    q_lock();
+    q_pop_locked(&ev, 1);
+    q_unlock();
+    return ev;
+}
+
+int term_read_events(TermEvent *out, int max, int timeout_ms) {
+    long long deadline = timer_ns() + (long long)timeout_ms * 1000000;
+    q_lock();
+    while (!g_q_len && timeout_ms != 0) {
+        if (timeout_ms < 0) { cond_wait_ms(&g_q_cond, &g_q_mutex, -1); continue; }
+        long long left = deadline - timer_ns();
+        if (left <= 0) break;
+        cond_wait_ms(&g_q_cond, &g_q_mutex, (int)((left + 999999) / 1000000));
+    }
+    int n = q_pop_locked(out, max);
+    q_unlock();
+    return n;
+}
+
+/* ---------- 脚本接口 ---------- */
+void term_headless_push(TermEvent e) {
+    q_lock();
+    if (g_q_len == g_q_cap) {
+        int cap = g_q_cap ? g_q_cap * 2 : 64;
+        TermEvent *q = (TermEvent *)malloc(cap * sizeof(TermEvent));
+        if (!q) { q_unlock(); return; }
+        for (int i = 0; i < g_q_len; i++) q[i] = g_queue[(g_q_head + i) % g_q_cap];
+        free(g_queue);
+        g_queue = q;
+        g_q_head = 0;
+        g_q_cap = cap;
+    }
+    g_queue[(g_q_head + g_q_len) % g_q_cap] = e;
+    g_q_len++;
+    cond_broadcast(&g_q_cond);
+    q_unlock();
+}
+
+void term_headless_push_key(int key_code, const char *utf8) {
+    TermEvent e = { .type = TERM_EV_KEY };
+    e.u.key.key_code = key_code;
+    e.u.key.pressed = 1;
+    e.u.key.repeat = 1;
+    if (utf8) snprintf(e.u.key.utf8, sizeof(e.u.key.utf8), "%s", utf8);
+    term_headless_push(e);
+    e.u.key.pressed = 0;
+    term_headless_push(e);
+}
+
+void term_headless_push_mouse(TermMouseEventType type, int x, int y, int btn) {
+    TermEvent e = { .type = TERM_EV_MOUSE };
+    e.u.mouse.type = type;
+    e.u.mouse.x = x;
+    e.u.mouse.y = y;
+    e.u.mouse.btn = btn;
+    term_headless_push(e);
+}
+
+int term_headless_pending(void) {
+    q_lock();
+    int n = g_q_len;
+    q_unlock();
+    return n;
+}
+
+void term_headless_resize(int cols, int rows) {
+    g_cols = cols;
+    g_rows = rows;
+    if (!g_vt) return;      /* 初始化前只记录大小 */
+    vt_free(g_vt);
+    g_vt = vt_new(cols, rows);
+    TermEvent e = { .type = TERM_EV_RESIZE };
+    e.u.size.cols = cols;
+    e.u.size.rows = rows;
+    term_headless_push(e);
+}
+
+vt_t *term_headless_screen(void) { return g_vt; }
+
+TermIoStats term_headless_stats(void) { return g_stats; }
+
+void term_headless_reset_stats(void) { memset(&g_stats, 0, sizeof(g_stats)); }
+
+void term_headless_discard(int on) { g_discard = on; }
+
+#endif /* TERM_HEADLESS */
@@ -0,0 +1,493 @@
+#include "text_edit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 两块只追加的缓冲: 0 为原文件, 1 为编辑时插入的文本. nls 是其中 '\n' 的位置, 递增 */
+typedef struct {
+    char *data;
+    int   len, cap;
+    int  *nls;
+    int   nnl, nlcap;
+} TeBuf;
+
+typedef struct TeNode {
+    struct TeNode *l, *r;
+    unsigned prio;
+    int buf, start, len;    /* piece: bufs[buf].data[start, start+len) */
+    int nl;                 /* piece 内的换行数 */
+    int sum_len, sum_nl;    /* 整棵子树的合计 */
+} TeNode;
+
+struct text_edit_t {
+    TeBuf   bufs[2];
+    TeNode *root;
+    unsigned seed;
+    int cursor;
+    int goal_x;             /* 上下移动时保持的横坐标, -1 表示按光标重新计算 */
+    int follow;             /* 光标因按键移动, 需要滚进可见区 */
+    int base;               /* 上一帧第 0 行在布局里的位置 */
+    int width;              /* 画过的最宽行, 决定横向内容宽度 */
+};
+
+/* ---------- 缓冲 ---------- */
+static int te_buf_append(TeBuf *b, const char *text, int len) {
+    if (b->len + len > b->cap) {
+        int cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + len) cap *= 2;
+        char *p = (char *)realloc(b->data, cap);
+        if (!p) return -1;
+        b->data = p;
+        b->cap = cap;
+    }
+    for (int i = 0; i < len; i++) {
+        if (text[i] != '\n') continue;
+        if (b->nnl == b->nlcap) {
+            int cap = b->nlcap ? b->nlcap * 2 : 256;
+            int *p = (int *)realloc(b->nls, cap * sizeof(int));
+            if (!p) return -1;
+            b->nls = p;
+            b->nlcap = cap;
+        }
+        b->nls[b->nnl++] = b->len + i;
+    }
+    memcpy(b->data + b->len, text, len);
+    b->len += len;
+    return 0;
+}
+
+/* nls 中第一个 >= pos 的下标 */
+static int te_nl_index(const TeBuf *b, int pos) {
+    int lo = 0, hi = b->nnl;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (b->nls[mid] < pos) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static int te_count_nl(text_edit_t *te, int buf, int start, int len) {
+    const TeBuf *b = &te->bufs[buf];
+    return te_nl_index(b, start + len) - te_nl_index(b, start);
+}
+
+/* ---------- treap ---------- */
+static int te_sum_len(TeNode *t) { return t ? t->sum_len : 0; }
+static int te_sum_nl(TeNode *t) { return t ? t->sum_nl : 0; }
+
+static void te_pull(TeNode *t) {
+    t->sum_len = te_sum_len(t->l) + t->len + te_sum_len(t->r);
+    t->sum_nl = te_sum_nl(t->l) + t->nl + te_sum_nl(t->r);
+}
+
+static void te_node_init(text_edit_t *te, TeNode *t, int buf, int start, int len, unsigned prio) {
+    if (!prio) {
+        te->seed ^= te->seed << 13; te->seed ^= te->seed >> 17; te->seed ^= te->seed << 5;
+        prio = te->seed;
+    }
+    t->l = t->r = NULL;
+    t->prio = prio;
+    t->buf = buf;
+    t->start = start;
+    t->len = len;
+    t->nl = te_count_nl(te, buf, start, len);
+    te_pull(t);
+}
+
+static TeNode *te_node(text_edit_t *te, int buf, int start, int len, unsigned prio) {
+    TeNode *t = (TeNode *)calloc(1, sizeof(TeNode));
+    if (t) te_node_init(te, t, buf, start, len, prio);
+    return t;
+}
+
+static void te_free_tree(TeNode *t) {
+    if (!t) return;
+    te_free_tree(t->l);
+    te_free_tree(t->r);
+    free(t);
+}
+
+/* 按字节偏移切成 [0, pos) 与 [pos, ...); 落在 piece 中间时把它一分为二.
+ * 最多切开一个 piece, 新节点用调用者事先分配的 *spare(用掉后置 NULL), 所以不会中途失败 */
+static void te_split(text_edit_t *te, TeNode *t, int pos, TeNode **a, TeNode **b, TeNode **spare) {
+    if (!t) { *a = *b = NULL; return; }
+    int ll = te_sum_len(t->l);
+    if (pos <= ll) {
+        te_split(te, t->l, pos, a, &t->l, spare);
+        te_pull(t);
+        *b = t;
+    } else if (pos >= ll + t->len) {
+        te_split(te, t->r, pos - ll - t->len, &t->r, b, spare);
+        te_pull(t);
+        *a = t;
+    } else {
+        /* 右半沿用 t 的优先级, 接管 t 的右子树后仍满足堆序 */
+        int k = pos - ll;
+        TeNode *n = *spare;
+        *spare = NULL;
+        te_node_init(te, n, t->buf, t->start + k, t->len - k, t->prio);
+        n->r = t->r;
+        te_pull(n);
+        t->r = NULL;
+        t->len = k;
+        t->nl -= n->nl;
+        te_pull(t);
+        *a = t;
+        *b = n;
+    }
+}
+
+static TeNode *te_merge(TeNode *a, TeNode *b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->prio > b->prio) {
+        a->r = te_merge(a->r, b);
+        te_pull(a);
+        return a;
+    }
+    b->l = te_merge(a, b->l);
+    te_pull(b);
+    return b;
+}
+
+/* 最右的 piece 正好结束在追加缓冲末尾时直接延长它, 连续输入不会增加节点 */
+static int te_extend_last(text_edit_t *te, TeNode *t, int len, int nl) {
+    if (!t) return 0;
+    if (t->r) {
+        if (!te_extend_last(te, t->r, len, nl)) return 0;
+    } else if (t->buf != 1 || t->start + t->len != te->bufs[1].len - len) {
+        return 0;
+    } else {
+        t->len += len;
+        t->nl += nl;
+    }
+    te_pull(t);
+    return 1;
+}
+
+/* ---------- 编辑 ---------- */
+text_edit_t *te_new(void) {
+    text_edit_t *te = (text_edit_t *)calloc(1, sizeof(*te));
+    if (!te) return NULL;
+    te->seed = 2463534242u;
+    te->goal_x = -1;
+    return te;
+}
+
+text_edit_t *te_open(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    text_edit_t *te = te_new();
+    char *chunk = (char *)malloc(1 << 20);
+    int ok = te && chunk;
+    for (size_t n; ok && (n = fread(chunk, 1, 1 << 20, fp)) > 0; ) ok = te_buf_append(&te->bufs[0], chunk, (int)n) == 0;
+    free(chunk);
+    fclose(fp);
+    if (ok && te->bufs[0].len > 0) ok = (te->root = te_node(te, 0, 0, te->bufs[0].len, 0)) != NULL;
+    if (!ok) { te_free(te); return NULL; }
+    return te;
+}
+
+static int te_save_tree(text_edit_t *te, TeNode *t, FILE *fp) {
+    if (!t) return 0;
+    if (te_save_tree(te, t->l, fp)) return -1;
+    if (fwrite(te->bufs[t->buf].data + t->start, 1, t->len, fp) != (size_t)t->len) return -1;
+    return te_save_tree(te, t->r, fp);
+}
+
+int te_save(text_edit_t *te, const char *path) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return -1;
+    int res = te_save_tree(te, te->root, fp);
+    if (fclose(fp)) res = -1;
+    return res;
+}
+
+void te_free(text_edit_t *te) {
+    if (!te) return;
+    te_free_tree(te->root);
+    for (int i = 0; i < 2; i++) { free(te->bufs[i].data); free(te->bufs[i].nls); }
+    free(te);
+}
+
+int te_length(text_edit_t *te) { return te_sum_len(te->root); }
+int te_lines(text_edit_t *te) { return te_sum_nl(te->root) + 1; }
+int te_cursor(text_edit_t *te) { return te->cursor; }
+
+void te_set_cursor(text_edit_t *te, int pos) {
+    te->cursor = mu_clamp(pos, 0, te_length(te));
+    te->goal_x = -1;
+    te->follow = 1;
+}
+
+int te_insert(text_edit_t *te, int pos, const char *text, int len) {
+    if (len < 0) len = (int)strlen(text);
+    if (pos < 0 || pos > te_length(te)) return -1;
+    if (len == 0) return 0;
+    TeBuf *add = &te->bufs[1];
+    int start = add->len, nl0 = add->nnl;
+    if (te_buf_append(add, text, len)) return -1;
+    TeNode *a, *b, *n = NULL;
+    TeNode *spare = (TeNode *)malloc(sizeof(TeNode));
+    if (!spare) return -1;
+    te_split(te, te->root, pos, &a, &b, &spare);
+    if (!te_extend_last(te, a, len, add->nnl - nl0)) {
+        /* 没切开 piece 时 spare 还在, 正好拿来放新文本 */
+        n = spare ? spare : (TeNode *)malloc(sizeof(TeNode));
+        spare = NULL;
+        if (!n) { te->root = te_merge(a, b); return -1; }
+        te_node_init(te, n, 1, start, len, 0);
+    }
+    free(spare);
+    te->root = te_merge(te_merge(a, n), b);
+    if (te->cursor >= pos) te->cursor += len;
+    return 0;
+}
+
+int te_delete(text_edit_t *te, int pos, int len) {
+    int total = te_length(te);
+    if (pos < 0 || pos > total) return -1;
+    len = mu_min(len, total - pos);
+    if (len <= 0) return 0;
+    /* 两次切分最多各用一个新节点, 先分配好, 失败时文档不动 */
+    TeNode *a, *b, *m, *c;
+    TeNode *spare[2] = { (TeNode *)malloc(sizeof(TeNode)), (TeNode *)malloc(sizeof(TeNode)) };
+    if (!spare[0] || !spare[1]) { free(spare[0]); free(spare[1]); return -1; }
+    te_split(te, te->root, pos, &a, &b, &spare[0]);
+    te_split(te, b, len, &m, &c, &spare[1]);
+    free(spare[0]);
+    free(spare[1]);
+    te_free_tree(m);
+    te->root = te_merge(a, c);
+    if (te->cursor > pos) te->cursor = mu_max(pos, te->cursor - len);
+    return 0;
+}
+
+/* 第 line 行的起始偏移: 找第 line 个换行, 越界时返回文档长度 */
+int te_line_start(text_edit_t *te, int line) {
+    if (line <= 0) return 0;
+    if (line > te_sum_nl(te->root)) return te_length(te);
+    TeNode *t = te->root;
+    int off = 0, k = line;
+    while (t) {
+        int ln = te_sum_nl(t->l);
+        if (k <= ln) { t = t->l; continue; }
+        k -= ln;
+        if (k <= t->nl) {
+            const TeBuf *b = &te->bufs[t->buf];
+            int p = b->nls[te_nl_index(b, t->start) + k - 1];
+            return off + te_sum_len(t->l) + (p - t->start) + 1;
+        }
+        k -= t->nl;
+        off += te_sum_len(t->l) + t->len;
+        t = t->r;
+    }
+    return te_length(te);
+}
+
+int te_line_of(text_edit_t *te, int pos) {
+    TeNode *t = te->root;
+    int line = 0;
+    while (t) {
+        int ll = te_sum_len(t->l);
+        if (pos < ll) { t = t->l; continue; }
+        line += te_sum_nl(t->l);
+        pos -= ll;
+        if (pos < t->len) return line + te_count_nl(te, t->buf, t->start, pos);
+        line += t->nl;
+        pos -= t->len;
+        t = t->r;
+    }
+    return line;
+}
+
+/* 只进入与 [pos, pos+len) 相交的子树 */
+static int te_copy(text_edit_t *te, TeNode *t, int pos, char *buf, int len) {
+    if (!t || len <= 0 || pos >= t->sum_len) return 0;
+    int n = 0, ll = te_sum_len(t->l);
+    if (pos < ll) n = te_copy(te, t->l, pos, buf, len);
+    int p = mu_max(pos + n, ll) - ll;
+    if (p < t->len && n < len) {
+        int k = mu_min(t->len - p, len - n);
+        memcpy(buf + n, te->bufs[t->buf].data + t->start + p, k);
+        n += k;
+    }
+    if (n < len) n += te_copy(te, t->r, pos + n - ll - t->len, buf + n, len - n);
+    return n;
+}
+
+int te_read(text_edit_t *te, int pos, char *buf, int len) {
+    if (pos < 0) return 0;
+    return te_copy(te, te->root, pos, buf, len);
+}
+
+static int te_line_end(text_edit_t *te, int line) {
+    return line + 1 < te_lines(te) ? te_line_start(te, line + 1) - 1 : te_length(te);
+}
+
+int te_line(text_edit_t *te, int line, char *buf, int cap) {
+    if (line < 0 || line >= te_lines(te) || cap <= 0) return -1;
+    int s = te_line_start(te, line), e = te_line_end(te, line);
+    int n = te_read(te, s, buf, mu_min(e - s, cap - 1));
+    if (n > 0 && n == e - s && buf[n - 1] == '\r') n--;
+    buf[n] = '\0';
+    return n;
+}
+
+/* ---------- 控件 ---------- */
+static int te_char_len(const char *s, int i, int len) {
+    int k = i + 1;
+    while (k < len && ((unsigned char)s[k] & 0xC0) == 0x80) k++;
+    return k - i;
+}
+
+/* 读出一行用于显示: 控制字符换成空格, 与测量、命中测试用同一份文本 */
+static int te_display_line(text_edit_t *te, int line, char *buf) {
+    int n = te_line(te, line, buf, TE_LINE_MAX + 1);
+    for (int j = 0; j < n; j++) if ((unsigned char)buf[j] < 0x20) buf[j] = ' ';
+    return n;
+}
+
+/* 行内宽度不超过 x 的最大字符边界, 点在字符右半边时取下一个边界 */
+static int te_hit(mu_Context *ctx, const char *s, int len, int x) {
+    mu_Font font = ctx->style->font;
+    int i = 0, w = 0;
+    while (i < len) {
+        int k = te_char_len(s, i, len);
+        int cw = ctx->text_width(font, s + i, k);
+        if (x < w + (cw + 1) / 2) break;
+        w += cw;
+        i += k;
+    }
+    return i;
+}
+
+/* 光标所在行与行内横坐标 */
+static int te_cursor_x(mu_Context *ctx, text_edit_t *te, int *line) {
+    char buf[TE_LINE_MAX + 1];
+    *line = te_line_of(te, te->cursor);
+    int n = te_display_line(te, *line, buf);
+    int col = mu_min(te->cursor - te_line_start(te, *line), n);
+    return ctx->text_width(ctx->style->font, buf, col);
+}
+
+/* 移到 line 行横坐标最接近 x 的位置 */
+static void te_move_to_line(mu_Context *ctx, text_edit_t *te, int line, int x) {
+    char buf[TE_LINE_MAX + 1];
+    line = mu_clamp(line, 0, te_lines(te) - 1);
+    int n = te_display_line(te, line, buf);
+    te->cursor = te_line_start(te, line) + te_hit(ctx, buf, n, x);
+}
+
+static int te_keys(mu_Context *ctx, text_edit_t *te, int page) {
+    int keys = ctx->key_pressed, res = 0;
+    char tmp[4];
+    if (ctx->input_text[0]) {
+        te_insert(te, te->cursor, ctx->input_text, -1);
+        res |= MU_RES_CHANGE;
+    }
+    if (keys & MU_KEY_RETURN) {
+        te_insert(te, te->cursor, "\n", 1);
+        res |= MU_RES_CHANGE;
+    }
+    if (keys & MU_KEY_BACKSPACE && te->cursor > 0) {
+        /* 往前跳过 UTF-8 后续字节 */
+        int n = te_read(te, mu_max(0, te->cursor - 4), tmp, mu_min(4, te->cursor));
+        int k = n;
+        while (k > 1 && ((unsigned char)tmp[k - 1] & 0xC0) == 0x80) k--;
+        te_delete(te, te->cursor - (n - k + 1), n - k + 1);
+        res |= MU_RES_CHANGE;
+    }
+    if (keys & MU_KEY_DELETE && te->cursor < te_length(te)) {
+        int n = te_read(te, te->cursor, tmp, 4);
+        te_delete(te, te->cursor, te_char_len(tmp, 0, n));
+        res |= MU_RES_CHANGE;
+    }
+    if (keys & MU_KEY_LEFT && te->cursor > 0) {
+        int n = te_read(te, mu_max(0, te->cursor - 4), tmp, mu_min(4, te->cursor));
+        int k = n - 1;
+        while (k > 0 && ((unsigned char)tmp[k] & 0xC0) == 0x80) k--;
+        te->cursor -= n - k;
+    }
+    if (keys & MU_KEY_RIGHT && te->cursor < te_length(te)) {
+        int n = te_read(te, te->cursor, tmp, 4);
+        te->cursor += te_char_len(tmp, 0, n);
+    }
+    if (keys & (MU_KEY_HOME | MU_KEY_END)) {
+        int line = te_line_of(te, te->cursor);
+        if (keys & MU_KEY_HOME) {
+            te->cursor = te_line_start(te, line);
+        } else {
+            /* 行尾不受 TE_LINE_MAX 截断; "\r\n" 停在 '\r' 前 */
+            char cr = 0;
+            te->cursor = te_line_end(te, line);
+            if (te->cursor > te_line_start(te, line) && te_read(te, te->cursor - 1, &cr, 1) == 1 && cr == '\r') te->cursor--;
+        }
+    }
+    if (keys & (MU_KEY_LEFT | MU_KEY_RIGHT | MU_KEY_HOME | MU_KEY_END) || res) te->goal_x = -1;
+
+    int dy = (keys & MU_KEY_DOWN ? 1 : 0) - (keys & MU_KEY_UP ? 1 : 0)
+           + (keys & MU_KEY_PAGEDOWN ? page : 0) - (keys & MU_KEY_PAGEUP ? page : 0);
+    if (dy) {
+        int line, x = te_cursor_x(ctx, te, &line);
+        if (te->goal_x < 0) te->goal_x = x;
+        te_move_to_line(ctx, te, line + dy, te->goal_x);
+    }
+    if (res || keys) te->follow = 1;
+    return res;
+}
+
+int te_draw(mu_Context *ctx, text_edit_t *te) {
+    char buf[TE_LINE_MAX + 1];
+    mu_Container *cnt = mu_get_current_container(ctx);
+    mu_Id id = mu_get_id(ctx, &te, sizeof(te));
+    mu_Font font = ctx->style->font;
+    mu_Color color = ctx->style->colors[MU_COLOR_TEXT];
+    int pad = ctx->style->padding;
+    int th = ctx->text_height(font);
+    int res = 0;
+
+    mu_update_control(ctx, id, cnt->body, MU_OPT_HOLDFOCUS);
+    if (ctx->focus == id) res = te_keys(ctx, te, mu_max(1, cnt->body.h / th - 1));
+
+    /* 按键移动了光标: 在布局前滚动, 让光标这一帧就可见; 第 0 行的位置取上一帧的 */
+    if (te->follow) {
+        int line, x = te_cursor_x(ctx, te, &line);
+        int top = pad + te->base + line * (th + ctx->style->spacing);
+        int viewh = cnt->body.h - pad * 2, vieww = cnt->body.w - pad * 2;
+        if (top < cnt->scroll.y) cnt->scroll.y = top;
+        if (top + th > cnt->scroll.y + viewh) cnt->scroll.y = top + th - viewh;
+        if (pad + x < cnt->scroll.x) cnt->scroll.x = pad + x;
+        if (pad + x + 1 > cnt->scroll.x + vieww) cnt->scroll.x = pad + x + 1 - vieww;
+        te->follow = 0;
+    }
+
+    /* 内容比视图宽时按画过的最宽行给出横向滚动范围 */
+    mu_ListClipper lc;
+    mu_Rect first = mu_rect(0, 0, 0, 0);
+    mu_layout_row(ctx, 1, (int[]){ te->width > cnt->body.w - pad * 2 ? te->width : -1 }, th);
+    mu_layout_begin_list(ctx, &lc, te_lines(te), th);
+    te->base = lc.base;
+    for (int i = lc.start; i < lc.end; i++) {
+        mu_Rect r = mu_layout_next(ctx);
+        if (i == lc.start) first = r;
+        int n = te_display_line(te, i, buf);
+        int w = n ? ctx->text_width(font, buf, n) : 0;
+        te->width = mu_max(te->width, w + 1);
+        if (n) mu_draw_text(ctx, font, buf, n, mu_vec2(r.x, r.y), color);
+        /* 按住左键时把光标放到点中的位置 */
+        if (ctx->focus == id && ctx->mouse_down & MU_MOUSE_LEFT && ctx->mouse_pos.y >= r.y && ctx->mouse_pos.y < r.y + th) {
+            te->cursor = te_line_start(te, i) + te_hit(ctx, buf, n, ctx->mouse_pos.x - r.x);
+            te->goal_x = -1;
+        }
+    }
+    mu_layout_end_list(ctx, &lc);
+
+    if (ctx->focus == id && lc.start < lc.end) {
+        int line, x = te_cursor_x(ctx, te, &line);
+        if (line >= lc.start && line < lc.end) {
+            mu_draw_rect(ctx, mu_rect(first.x + x, first.y + (line - lc.start) * lc.stride, 1, th), color);
+        }
+    }
+    return res;
+}
@@ -0,0 +1,32 @@
+#ifndef __TEXT_EDIT_H__
+#define __TEXT_EDIT_H__
+
+#include "microui.h"
+
+/* 多行编辑器: 文本存成 piece table, piece 挂在按长度隐式排序的 treap 上, 每个节点
+ * 汇总子树的字节数和换行数. 原文件与追加缓冲各自记录换行位置, 切分 piece 时用二分
+ * 求换行数, 所以插入、删除、行号与偏移互查都是 O(log n). 绘制时只读出、测量可见行.
+ * 偏移和行号都用 int, 文档不超过 2GB. */
+
+#define TE_LINE_MAX  1024           /* 单行最多读出并显示的字节数 */
+
+typedef struct text_edit_t text_edit_t;
+
+text_edit_t *te_new(void);
+text_edit_t *te_open(const char *path);     /* 整个文件读入内存; 打不开返回 NULL */
+int  te_save(text_edit_t *te, const char *path);    /* 失败返回 -1 */
+void te_free(text_edit_t *te);
+int  te_insert(text_edit_t *te, int pos, const char *text, int len);    /* len < 0 时用 strlen */
+int  te_delete(text_edit_t *te, int pos, int len);
+int  te_length(text_edit_t *te);
+int  te_lines(text_edit_t *te);             /* 换行数 + 1 */
+int  te_line_start(text_edit_t *te, int line);
+int  te_line_of(text_edit_t *te, int pos);  /* pos 所在行 */
+int  te_read(text_edit_t *te, int pos, char *buf, int len);     /* 返回实际读出的字节数, 不加 '\0' */
+int  te_line(text_edit_t *te, int line, char *buf, int cap);    /* 不含行尾 "\r\n", 截断到 cap-1; 越界返回 -1 */
+int  te_cursor(text_edit_t *te);
+void te_set_cursor(text_edit_t *te, int pos);
+/* 在当前容器里绘制并处理输入, 文本被修改时返回 MU_RES_CHANGE */
+int  te_draw(mu_Context *ctx, text_edit_t *te);
+
+#endif /* __TEXT_EDIT_H__ */
@@ -0,0 +1,190 @@
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#include <stdlib.h>
+
+/* 最小线程, 互斥锁, 条件变量, 信号量与原子操作封装: Win32 用 CreateThread/CRITICAL_SECTION/
+ * CONDITION_VARIABLE/Semaphore/Interlocked*, 其余用 pthread 和 GCC __atomic */
+
+typedef unsigned long atom_t;       /* Win32 上 Interlocked 只保证 32 位, 计数按无符号回绕 */
+typedef void (*thread_fn)(void *arg);
+
+typedef struct { thread_fn fn; void *arg; } thread_start_t;
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE thread_t;
+
+static inline DWORD WINAPI thread_trampoline(LPVOID p) {
+    thread_start_t s = *(thread_start_t *)p;
+    free(p);
+    s.fn(s.arg);
+    return 0;
+}
+
+static inline int thread_create(thread_t *t, thread_fn fn, void *arg) {
+    thread_start_t *s = (thread_start_t *)malloc(sizeof(*s));
+    if (!s) return -1;
+    s->fn = fn; s->arg = arg;
+    *t = CreateThread(NULL, 0, thread_trampoline, s, 0, NULL);
+    if (!*t) { free(s); return -1; }
+    return 0;
+}
+
+static inline void thread_join(thread_t t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+static inline void thread_sleep_ms(int ms) { Sleep(ms); }
+
+typedef CRITICAL_SECTION mutex_t;
+static inline void mutex_init(mutex_t *m)    { InitializeCriticalSection(m); }
+static inline void mutex_destroy(mutex_t *m) { DeleteCriticalSection(m); }
+static inline void mutex_lock(mutex_t *m)    { EnterCriticalSection(m); }
+static inline void mutex_unlock(mutex_t *m)  { LeaveCriticalSection(m); }
+
+/* 条件变量: cond_wait_ms 在持有 m 时调用, 最多等 ms 毫秒(<0 一直等), 可能虚假唤醒 */
+typedef CONDITION_VARIABLE cond_t;
+static inline void cond_init(cond_t *c)      { InitializeConditionVariable(c); }
+static inline void cond_destroy(cond_t *c)   { (void)c; }
+static inline void cond_wait_ms(cond_t *c, mutex_t *m, int ms) { SleepConditionVariableCS(c, m, ms < 0 ? INFINITE : (DWORD)ms); }
+static inline void cond_broadcast(cond_t *c) { WakeAllConditionVariable(c); }
+
+typedef HANDLE sema_t;
+static inline int  sema_init(sema_t *s, int n) { *s = CreateSemaphore(NULL, n, 0x7fffffff, NULL); return *s ? 0 : -1; }
+static inline void sema_destroy(sema_t *s)     { CloseHandle(*s); }
+static inline void sema_wait(sema_t *s)        { WaitForSingleObject(*s, INFINITE); }
+static inline void sema_post(sema_t *s)        { ReleaseSemaphore(*s, 1, NULL); }
+
+static inline int thread_cpu_count(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+}
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+typedef pthread_t thread_t;
+
+static inline void *thread_trampoline(void *p) {
+    thread_start_t s = *(thread_start_t *)p;
+    free(p);
+    s.fn(s.arg);
+    return NULL;
+}
+
+static inline int thread_create(thread_t *t, thread_fn fn, void *arg) {
+    thread_start_t *s = (thread_start_t *)malloc(sizeof(*s));
+    if (!s) return -1;
+    s->fn = fn; s->arg = arg;
+    if (pthread_create(t, NULL, thread_trampoline, s)) { free(s); return -1; }
+    return 0;
+}
+
+static inline void thread_join(thread_t t) { pthread_join(t, NULL); }
+static inline void thread_sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+typedef pthread_mutex_t mutex_t;
+static inline void mutex_init(mutex_t *m)    { pthread_mutex_init(m, NULL); }
+static inline void mutex_destroy(mutex_t *m) { pthread_mutex_destroy(m); }
+static inline void mutex_lock(mutex_t *m)    { pthread_mutex_lock(m); }
+static inline void mutex_unlock(mutex_t *m)  { pthread_mutex_unlock(m); }
+
+/* 条件变量: cond_wait_ms 在持有 m 时调用, 最多等 ms 毫秒(<0 一直等), 可能虚假唤醒 */
+typedef pthread_cond_t cond_t;
+static inline void cond_init(cond_t *c)      { pthread_cond_init(c, NULL); }
+static inline void cond_destroy(cond_t *c)   { pthread_cond_destroy(c); }
+static inline void cond_wait_ms(cond_t *c, mutex_t *m, int ms) {
+    if (ms < 0) { pthread_cond_wait(c, m); return; }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+    pthread_cond_timedwait(c, m, &ts);
+}
+static inline void cond_broadcast(cond_t *c) { pthread_cond_broadcast(c); }
+
+/* 计数信号量; 用互斥锁加条件变量实现, 不依赖各平台 sem_t 的差异 */
+typedef struct { pthread_mutex_t m; pthread_cond_t c; int n; } sema_t;
+static inline int sema_init(sema_t *s, int n) {
+    s->n = n;
+    if (pthread_mutex_init(&s->m, NULL)) return -1;
+    if (pthread_cond_init(&s->c, NULL)) { pthread_mutex_destroy(&s->m); return -1; }
+    return 0;
+}
+static inline void sema_destroy(sema_t *s) { pthread_cond_destroy(&s->c); pthread_mutex_destroy(&s->m); }
+static inline void sema_wait(sema_t *s) {
+    pthread_mutex_lock(&s->m);
+    while (s->n == 0) pthread_cond_wait(&s->c, &s->m);
+    s->n--;
+    pthread_mutex_unlock(&s->m);
+}
+static inline void sema_post(sema_t *s) {
+    pthread_mutex_lock(&s->m);
+    s->n++;
+    pthread_cond_signal(&s->c);
+    pthread_mutex_unlock(&s->m);
+}
+
+static inline int thread_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+#endif
+
+#if defined(_WIN32) && !defined(__GNUC__)
+static inline atom_t atom_load(volatile atom_t *p)            { return (atom_t)InterlockedCompareExchange((volatile LONG *)p, 0, 0); }
+static inline void   atom_store(volatile atom_t *p, atom_t v) { InterlockedExchange((volatile LONG *)p, (LONG)v); }
+static inline atom_t atom_add(volatile atom_t *p, atom_t v)   { return (atom_t)InterlockedExchangeAdd((volatile LONG *)p, (LONG)v); }
+static inline int    atom_cas(volatile atom_t *p, atom_t *expect, atom_t v) {
+    atom_t old = (atom_t)InterlockedCompareExchange((volatile LONG *)p, (LONG)v, (LONG)*expect);
+    if (old == *expect) return 1;
+    *expect = old;
+    return 0;
+}
+#else
+/* load 为 acquire, store 为 release, add/cas 为 acq_rel */
+static inline atom_t atom_load(volatile atom_t *p)            { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void   atom_store(volatile atom_t *p, atom_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline atom_t atom_add(volatile atom_t *p, atom_t v)   { return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL); }
+static inline int    atom_cas(volatile atom_t *p, atom_t *expect, atom_t v) {
+    return __atomic_compare_exchange_n(p, expect, v, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+/* ---------- 有界 MPMC 环形队列(Vyukov) ----------
+ * 槽由调用方定义, 第一个成员必须是 volatile atom_t seq; 槽数为 2 的幂, mask = 槽数 - 1.
+ * 槽序号按 "真实序号 - 槽下标" 存放, 全零(静态初值或 calloc)即为空队列, 无需初始化.
+ * 生产者: mpmc_claim 抢占 head 处的空槽(满了返回 NULL), 写好内容后 mpmc_publish.
+ * 消费者(同一时刻只有一个): mpmc_peek 取 tail 处已发布的槽, 读完 mpmc_release 后推进 tail. */
+static inline volatile atom_t *mpmc_slot(void *ring, size_t stride, atom_t mask, atom_t pos) {
+    return (volatile atom_t *)((char *)ring + (size_t)(pos & mask) * stride);
+}
+
+static inline void *mpmc_claim(void *ring, size_t stride, atom_t mask, volatile atom_t *head, atom_t *pos) {
+    atom_t p = atom_load(head);
+    for (;;) {
+        volatile atom_t *seq = mpmc_slot(ring, stride, mask, p);
+        long d = (long)(atom_load(seq) + (p & mask) - p);
+        if (d == 0) { if (atom_cas(head, &p, p + 1)) { *pos = p; return (void *)seq; } }
+        else if (d < 0) return NULL;
+        else p = atom_load(head);
+    }
+}
+
+static inline void mpmc_publish(void *slot, atom_t mask, atom_t pos) {
+    atom_store((volatile atom_t *)slot, pos + 1 - (pos & mask));
+}
+
+static inline void *mpmc_peek(void *ring, size_t stride, atom_t mask, atom_t tail) {
+    volatile atom_t *seq = mpmc_slot(ring, stride, mask, tail);
+    return atom_load(seq) + (tail & mask) == tail + 1 ? (void *)seq : NULL;   /* 空或尚未写完 */
+}
+
+static inline void mpmc_release(void *slot, atom_t mask, atom_t tail) {
+    atom_store((volatile atom_t *)slot, tail + mask + 1 - (tail & mask));
+}
+
+#endif /* __THREAD_H__ */
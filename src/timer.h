@@ -0,0 +1,24 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/* 高精度单调时钟, 单位纳秒 */
+#ifdef _WIN32
+#include <windows.h>
+static inline long long timer_ns(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    long long q = now.QuadPart, f = freq.QuadPart;
+    return q / f * 1000000000LL + q % f * 1000000000LL / f;
+}
+#else
+#include <time.h>
+static inline long long timer_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#endif
+
+#endif /* __TIMER_H__ */
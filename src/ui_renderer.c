@@ -1,116 +1,993 @@
-#include "ui_renderer.h"
-
-static int g_first;
-static renderer_t *g_last_renderer; 
-static renderer_t *g_renderer; 
-static mu_Rect g_clip_rect = {0};
-static int g_is_clipping = 0;
-
-static mu_Rect rect_intersect(mu_Rect a, mu_Rect b) {
-    int x1 = a.x > b.x ? a.x : b.x;
-    int y1 = a.y > b.y ? a.y : b.y;
-    int x2 = (a.x + a.w) < (b.x + b.w) ? (a.x + a.w) : (b.x + b.w);
-    int y2 = (a.y + a.h) < (b.y + b.h) ? (a.y + a.h) : (b.y + b.h);
-
-    if (x2 <= x1 || y2 <= y1) return (mu_Rect){0, 0, 0, 0};
-    return (mu_Rect){x1, y1, x2 - x1, y2 - y1};
-}
-
-static int rgb_to_mu(mu_Color color) {
-    return (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b;
-}
-
-void r_init(void) {
-    term_init();
-    int width = 0, height = 0;
-    term_get_size(&width, &height);
-    g_renderer = renderer_new(width, height, (style_t){.fg=-1, .bg=-1, .raw=0});
-    g_last_renderer = renderer_new(width, height, (style_t){.fg=-1, .bg=-1, .raw=0}); 
-    g_first = 1;
-}
-
-
-void r_clear(mu_Color color) {
-    int background = rgb_to_mu(color); 
-    for (int i = 0; i < g_renderer->w * g_renderer->h; i++) {
-        g_renderer->cells[i] = (utf8_t){" ", 1, 1};
-        g_renderer->styles[i].bg = background;
-    }
-}
-
-void r_draw_rect(mu_Rect r, mu_Color color) {
-    r = (g_is_clipping) ? rect_intersect(r, g_clip_rect) : r;
-    if (r.w <= 0 || r.h <= 0) return;
-    for(int y = r.y; y < r.y + r.h; y++)
-    for(int x = r.x; x < r.x + r.w; x++) {
-        if(x >= g_renderer->w || y >= g_renderer->h) continue;
-        g_renderer->styles[y * g_renderer->w + x].bg = rgb_to_mu(color);
-    }
-}
-
-void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color) {
-    mu_Rect r = mu_rect(pos.x, pos.y, g_renderer->w-pos.x, g_renderer->h-pos.y);
-    r = (g_is_clipping) ? rect_intersect(r, g_clip_rect) : r;
-    if (r.w <= 0 || r.h <= 0) return;
-
-    style_t s = g_renderer->styles[pos.y * g_renderer->w + pos.x];
-    s.fg=rgb_to_mu(color);
-    renderer_set_str(g_renderer, pos.x, pos.y, text, &s, r.w);
-}
-
-void r_draw_icon(int id, mu_Rect rect, mu_Color color) {
-    const char* icon;
-    switch (id) {
-        case MU_ICON_CLOSE:     icon = "✕";   break; 
-        case MU_ICON_CHECK:     icon = "*";   break;
-        case MU_ICON_COLLAPSED: icon = "⏵";  break;
-        case MU_ICON_EXPANDED:  icon = "⏷";   break;
-        default:                              break;
-    }
-    
-    r_draw_text(icon, mu_vec2(rect.x, rect.y), color);
-}
-
-int  r_get_text_width(const char *text, int len) {
-    utf8_t utf8_buf[UTF8_STR_MAX];
-    int n = str_to_utf8(text, utf8_buf, UTF8_STR_MAX);
-    int width = 0;
-    for(int i = 0; i < n; i++) width += utf8_buf[i].width;
-    return width;
-}
-
-int  r_get_text_height(void) {
-    return 1;
-}
-
-void r_set_clip_rect(mu_Rect rect) {
-    g_is_clipping = 1;
-    g_clip_rect = rect;
-}
-
-void r_present(void) {
-    if (g_first) {
-        g_first = 0;
-
-        term_clear_screen();
-        printf("%s", renderer_to_string(g_renderer));
-    } else {
-        for (int i = 0; i < g_renderer->w * g_renderer->h; i++) {
-            if (!utf8_cmp(g_renderer->cells[i], g_last_renderer->cells[i]) && 
-                !style_cmp(g_renderer->styles[i], g_last_renderer->styles[i])) {
-                continue;
-            }
-
-            int x = i % g_renderer->w;
-            int y = i / g_renderer->w;
-            term_move_cursor(x+1, y);
-            
-            printf("%s\x1b[0m", renderer_xy_to_string(g_renderer, x, y));
-        }
-    }
-
-    for(int i = 0; i < g_renderer->w * g_renderer->h; i++) {
-        g_last_renderer->cells[i] = g_renderer->cells[i];
-        g_last_renderer->styles[i] = g_renderer->styles[i];
-    }
-}
\ No newline at end of file
+#include "ui_renderer.h"
+#include "stats.h"
+#include "workers.h"
+#include "timer.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/* 光栅化目标: 屏幕, 屏幕上的一条水平带, 或某个根容器的离屏缓存面.
+ * 裁剪状态跟着目标走, 各条带可以在不同线程里同时回放 */
+typedef struct {
+    renderer_t    *r;
+    int            ox, oy;      /* 目标 (0,0) 对应的屏幕坐标 */
+    mu_Rect        band;        /* 允许写入的屏幕区域 */
+    mu_Rect        clip;
+    int            clipping;
+    unsigned char *mask;        /* 缓存面每格的写入情况(R_MASK_*), 画屏幕时为 NULL */
+    int            bad;         /* 缓存面: 出现了不能离屏重放的绘制 */
+    long long      cells;       /* 写入的格子数, 回到主线程后再计入统计 */
+} RTarget;
+
+enum { R_MASK_BG = 1, R_MASK_FULL = 2 };   /* 只改了背景色 / 整格(字符和样式)都写了 */
+
+typedef struct RCache RCache;
+typedef struct RBand RBand;
+
+/* 一块屏幕的全部状态. 各实例互不相干, 可以在不同线程里同时使用 */
+struct ui_renderer_t {
+    renderer_t    *cur, *last;  /* 正在画的帧 / 终端上已有的内容 */
+    int            first;       /* 下次输出先清屏 */
+    RTarget        screen;
+
+    RCache        *cache;       /* 根容器光栅缓存, 按容器地址开放寻址 */
+    int            cache_cap, cache_len, cache_frame;
+    int            cache_on;
+
+    workers_t     *workers;
+    RBand         *bands;
+    int            band_count, band_cap, band_rows;
+    int            banding;     /* 本帧在分带: 绘制先收集, 最后并行回放 */
+
+    char          *out;
+    int            out_len, out_cap;
+    style_t        pen;         /* 终端当前 SGR 状态 */
+    ur_write_fn    write;
+    void          *user;
+    int            fd;          /* ur_new_fd 的输出 fd */
+    char          *fd_out;      /* fd 暂时写不下的输出, 下次输出前先写它 */
+    int            fd_len, fd_cap;
+
+    /* 本次输出: 来源(cur 或降色深后的副本)与范围 */
+    const renderer_t *src;
+    renderer_t     quant;
+    mu_Rect        area;
+    int            shifts;      /* 允许 ICH/DCH 平移 */
+
+    /* 带宽预算(令牌桶) */
+    int            budget;      /* 每秒字节数, 0 为不限 */
+    double         tokens;      /* 现在可发的字节数, 不超过 budget */
+    long long      tick;        /* 上次补充令牌的时刻(ns) */
+    mu_Rect        focus;       /* 超预算时优先输出的区域 */
+    int            quality;     /* 上次输出的降级程度, UR_Q_* */
+    int            need;        /* 被推迟时最小一档输出的字节数 */
+    utf8_t        *undo_cells;  /* 试算时被 ICH/DCH 改过的旧帧行, 放弃这次试算时恢复 */
+    style_t       *undo_styles;
+    int           *undo_rows;
+    int            undo_len;
+};
+
+static mu_Rect rect_intersect(mu_Rect a, mu_Rect b) {
+    int x1 = a.x > b.x ? a.x : b.x;
+    int y1 = a.y > b.y ? a.y : b.y;
+    int x2 = (a.x + a.w) < (b.x + b.w) ? (a.x + a.w) : (b.x + b.w);
+    int y2 = (a.y + a.h) < (b.y + b.h) ? (a.y + a.h) : (b.y + b.h);
+
+    if (x2 <= x1 || y2 <= y1) return (mu_Rect){0, 0, 0, 0};
+    return (mu_Rect){x1, y1, x2 - x1, y2 - y1};
+}
+
+static int rect_contains(mu_Rect outer, mu_Rect r) {
+    return r.x >= outer.x && r.y >= outer.y &&
+           r.x + r.w <= outer.x + outer.w && r.y + r.h <= outer.y + outer.h;
+}
+
+/* alpha >= 128 表示终端默认色 */
+static int rgb_to_mu(mu_Color color) {
+    return color.a >= 128 ? -1 : (color.r << 16) | (color.g << 8) | color.b;
+}
+
+static void cache_free_all(ui_renderer_t *ur);
+
+static void flush_cells(RTarget *t) {
+    STAT_ADD(cells_written, t->cells);
+    t->cells = 0;
+}
+
+ui_renderer_t *ur_new(int w, int h, ur_write_fn write, void *user) {
+    ui_renderer_t *ur = (ui_renderer_t *)calloc(1, sizeof(*ur));
+    if (!ur) return NULL;
+    ur->cache_on = 1;
+    ur->write = write;
+    ur->user = user;
+    if (ur_resize(ur, w, h)) { ur_free(ur); return NULL; }
+    return ur;
+}
+
+static void bands_free(ui_renderer_t *ur);
+
+void ur_free(ui_renderer_t *ur) {
+    if (!ur) return;
+    renderer_free(ur->cur);
+    renderer_free(ur->last);
+    cache_free_all(ur);
+    bands_free(ur);
+    workers_free(ur->workers);
+    free(ur->out);
+    free(ur->fd_out);
+    free(ur->quant.styles);
+    free(ur->undo_cells);
+    free(ur->undo_styles);
+    free(ur->undo_rows);
+    free(ur);
+}
+
+int ur_resize(ui_renderer_t *ur, int w, int h) {
+    renderer_free(ur->cur);
+    renderer_free(ur->last);
+    ur->cur = renderer_new(w, h, (style_t){.fg=-1, .bg=-1, .raw=0});
+    ur->last = renderer_new(w, h, (style_t){.fg=-1, .bg=-1, .raw=0});
+    ur->screen = (RTarget){ .r = ur->cur, .band = mu_rect(0, 0, w, h) };
+    cache_free_all(ur);
+    free(ur->quant.styles);
+    free(ur->undo_cells);
+    free(ur->undo_styles);
+    free(ur->undo_rows);
+    ur->quant.styles = NULL;
+    ur->undo_cells = NULL;
+    ur->undo_styles = NULL;
+    ur->undo_rows = NULL;
+    ur->first = 1;
+    return ur->cur && ur->last ? 0 : -1;
+}
+
+void ur_clear(ui_renderer_t *ur, mu_Color color) {
+    renderer_t *d = ur->cur;
+    int background = rgb_to_mu(color);
+    for (int i = 0; i < d->w * d->h; i++) {
+        d->cells[i] = (utf8_t){" ", 1, 1};
+        d->styles[i].bg = background;
+    }
+    STAT_ADD(cells_written, d->w * d->h);
+}
+
+renderer_t *ur_get_renderer(ui_renderer_t *ur) {
+    return ur->cur;
+}
+
+/* 坐标和裁剪矩形都是屏幕坐标, 写入时再换算到目标 */
+static void draw_rect(RTarget *t, mu_Rect r, mu_Color color) {
+    renderer_t *d = t->r;
+    r = (t->clipping) ? rect_intersect(r, t->clip) : r;
+    r = rect_intersect(r, t->band);
+    if (r.w <= 0 || r.h <= 0) return;
+    if (t->mask && !rect_contains(mu_rect(t->ox, t->oy, d->w, d->h), r)) { t->bad = 1; return; }
+    int bg = rgb_to_mu(color);
+    for(int y = r.y - t->oy; y < r.y - t->oy + r.h; y++)
+    for(int x = r.x - t->ox; x < r.x - t->ox + r.w; x++) {
+        d->styles[y * d->w + x].bg = bg;
+        if (t->mask) t->mask[y * d->w + x] |= R_MASK_BG;
+    }
+    t->cells += r.w * r.h;
+}
+
+static void draw_glyphs(RTarget *t, const utf8_t *g, int count, mu_Vec2 pos, mu_Color color) {
+    renderer_t *d = t->r;
+    if (pos.y < t->band.y || pos.y >= t->band.y + t->band.h) return;
+    mu_Rect r = mu_rect(pos.x, pos.y, t->band.x + t->band.w - pos.x, 1);
+    r = (t->clipping) ? rect_intersect(r, t->clip) : r;
+    if (r.w <= 0 || r.h <= 0) return;
+
+    int x = pos.x - t->ox, y = pos.y - t->oy;
+    if (t->mask && (x < 0 || y < 0 || x >= d->w || y >= d->h)) { t->bad = 1; return; }
+    /* 每个字保留所在格的背景, 被遮住的背景矩形丢掉后其余格子不受影响 */
+    int n = renderer_put_glyphs(d, x, y, g, count, rgb_to_mu(color), r.w);
+    if (t->mask) {
+        /* 写到缓存面右边界而屏幕还没到头: 可能被截断 */
+        if (x + n >= d->w && t->ox + d->w < t->band.x + t->band.w) { t->bad = 1; return; }
+        /* 背景必须都是本容器画的, 结果才与下层无关 */
+        int end = n < d->w - x ? x + n : d->w;
+        for (int i = y * d->w + x; i < y * d->w + end; i++) {
+            if (!t->mask[i]) { t->bad = 1; return; }
+            t->mask[i] = R_MASK_FULL | R_MASK_BG;
+        }
+    }
+    t->cells += n;
+}
+
+static void draw_text(RTarget *t, const char *text, mu_Vec2 pos, mu_Color color) {
+    utf8_t buf[UTF8_STR_MAX];
+    int n = str_to_utf8(text, buf, UTF8_STR_MAX);
+    draw_glyphs(t, buf, n, pos, color);
+}
+
+/* 图标字符预先解码好, 不必每次从 UTF-8 字面量解析 */
+static const utf8_t g_icons[MU_ICON_MAX] = {
+    [MU_ICON_CLOSE]     = {{0xE2, 0x9C, 0x95}, 3, 1},     /* ✕ */
+    [MU_ICON_CHECK]     = {{'*'}, 1, 1},
+    [MU_ICON_COLLAPSED] = {{0xE2, 0x8F, 0xB5}, 3, 1},     /* ⏵ */
+    [MU_ICON_EXPANDED]  = {{0xE2, 0x8F, 0xB7}, 3, 1},     /* ⏷ */
+};
+
+static void draw_icon(RTarget *t, int id, mu_Rect rect, mu_Color color) {
+    if (id <= 0 || id >= MU_ICON_MAX) return;
+    draw_glyphs(t, &g_icons[id], 1, mu_vec2(rect.x, rect.y), color);
+}
+
+int  r_get_text_width(const char *text, int len) {
+    utf8_t utf8_buf[UTF8_STR_MAX];
+    int n = str_to_utf8_n(text, len, utf8_buf, UTF8_STR_MAX);
+    int width = 0;
+    for(int i = 0; i < n; i++) width += utf8_buf[i].width;
+    return width;
+}
+
+int  r_text_width(mu_Font font, const char *text, int len) {
+    (void)font;
+    return r_get_text_width(text, len < 0 ? (int)strlen(text) : len);
+}
+
+int  r_text_glyphs(mu_Font font, const char *text, int len, void *glyphs, int *width) {
+    utf8_t *g = (utf8_t *)glyphs;
+    (void)font;
+    int n = str_to_utf8_n(text, len, g, len);
+    *width = 0;
+    if (n < 0) return 0;
+    for (int i = 0; i < n; i++) *width += g[i].width;
+    return n;
+}
+
+int  r_get_text_height(void) {
+    return 1;
+}
+
+int  r_text_height(mu_Font font) {
+    (void)font;
+    return r_get_text_height();
+}
+
+/* ---------- 根容器光栅缓存 ----------
+ * 每个根容器的命令是一段连续区间(head..tail, 内嵌的根容器由 head 跳过),
+ * 区间哈希(mu_Container.hash)不变时直接把缓存面贴到屏幕上.
+ * 连续两帧哈希相同才建缓存面, 每帧都在变的容器直接画屏幕, 不付额外的贴图开销.
+ * 贴图按格合成: 整格写过的覆盖下层, 只改过背景色的只覆盖背景色, 其余透出下层,
+ * 与直接按顺序画到屏幕上结果一致. */
+struct RCache {
+    mu_Container  *cnt;
+    mu_Id          hash;        /* 缓存面对应的命令哈希, 0 表示无效 */
+    mu_Id          last_hash;   /* 上一帧的命令哈希 */
+    mu_Id          bad_hash;    /* 这个哈希的命令不能缓存 */
+    int            frame;       /* 最近一次使用的帧 */
+    mu_Rect        box;         /* 缓存面对应的屏幕区域 */
+    RTarget        t;
+};
+
+static void cache_entry_free(RCache *e) {
+    renderer_free(e->t.r);
+    free(e->t.mask);
+}
+
+static void cache_free_all(ui_renderer_t *ur) {
+    for (int i = 0; i < ur->cache_cap; i++) if (ur->cache[i].cnt) cache_entry_free(&ur->cache[i]);
+    free(ur->cache);
+    ur->cache = NULL;
+    ur->cache_cap = ur->cache_len = 0;
+}
+
+static unsigned cache_slot(mu_Container *cnt) {
+    return (unsigned)(((size_t)cnt >> 4) * 2654435761u);
+}
+
+static void cache_insert(ui_renderer_t *ur, RCache e) {
+    unsigned i = cache_slot(e.cnt) & (ur->cache_cap - 1);
+    while (ur->cache[i].cnt) i = (i + 1) & (ur->cache_cap - 1);
+    ur->cache[i] = e;
+    ur->cache_len++;
+}
+
+/* 重建哈希表(扩容); drop 时丢掉本帧没用到的项 */
+static void cache_rehash(ui_renderer_t *ur, int cap, int drop) {
+    RCache *old = ur->cache;
+    int old_cap = ur->cache_cap;
+    ur->cache = (RCache *)calloc(cap, sizeof(RCache));
+    ur->cache_cap = cap;
+    ur->cache_len = 0;
+    for (int i = 0; i < old_cap; i++) {
+        if (!old[i].cnt) continue;
+        if (!drop || old[i].frame == ur->cache_frame) cache_insert(ur, old[i]);
+        else cache_entry_free(&old[i]);
+    }
+    free(old);
+}
+
+static RCache *cache_get(ui_renderer_t *ur, mu_Container *cnt) {
+    if ((ur->cache_len + 1) * 2 > ur->cache_cap) cache_rehash(ur, ur->cache_cap ? ur->cache_cap * 2 : 64, 0);
+    RCache *c = ur->cache;
+    unsigned i = cache_slot(cnt) & (ur->cache_cap - 1);
+    while (c[i].cnt && c[i].cnt != cnt) i = (i + 1) & (ur->cache_cap - 1);
+    if (!c[i].cnt) {
+        memset(&c[i], 0, sizeof(RCache));
+        c[i].cnt = cnt;
+        ur->cache_len++;
+    }
+    c[i].frame = ur->cache_frame;
+    return &c[i];
+}
+
+/* 不透明窗口盖住下层的字, 否则只有背景色被覆盖; mu_end 据此丢掉被盖住的命令 */
+static void clear_rect(RTarget *t, mu_Rect r) {
+    renderer_t *d = t->r;
+    r = rect_intersect(r, t->band);
+    if (r.w <= 0 || r.h <= 0) return;
+    if (t->mask && !rect_contains(mu_rect(t->ox, t->oy, d->w, d->h), r)) { t->bad = 1; return; }
+    for(int y = r.y - t->oy; y < r.y - t->oy + r.h; y++)
+    for(int x = r.x - t->ox; x < r.x - t->ox + r.w; x++) {
+        d->cells[y * d->w + x] = (utf8_t){" ", 1, 1};
+        d->styles[y * d->w + x] = (style_t){.fg=-1, .bg=-1, .raw=0};
+        if (t->mask) t->mask[y * d->w + x] = R_MASK_FULL | R_MASK_BG;
+    }
+    t->cells += r.w * r.h;
+}
+
+static void draw_command(RTarget *t, const mu_Command *cmd) {
+    switch (cmd->type) {
+        case MU_COMMAND_TEXT: draw_text(t, cmd->text.str, cmd->text.pos, cmd->text.color); break;
+        case MU_COMMAND_GLYPHS: draw_glyphs(t, (const utf8_t *)cmd->glyphs.glyphs, cmd->glyphs.count, cmd->glyphs.pos, cmd->glyphs.color); break;
+        case MU_COMMAND_RECT: draw_rect(t, cmd->rect.rect, cmd->rect.color); break;
+        case MU_COMMAND_ICON: draw_icon(t, cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
+        case MU_COMMAND_CLIP: t->clip = cmd->clip.rect; t->clipping = 1; break;
+    }
+}
+
+static void draw_root(RTarget *t, mu_Container *cnt) {
+    mu_Command *cmd = (mu_Command *)((char *)cnt->head + sizeof(mu_JumpCommand));
+    t->clipping = 0;
+    if (cnt->opaque) clear_rect(t, cnt->rect);
+    while (cmd != cnt->tail) {
+        if (cmd->type == MU_COMMAND_JUMP) { cmd = cmd->jump.dst; continue; }    /* 跳过内嵌的根容器 */
+        draw_command(t, cmd);
+        if (t->bad) return;
+        cmd = (mu_Command *)((char *)cmd + cmd->base.size);
+    }
+}
+
+/* 在缓存面上重放; 成功返回 1 */
+static int cache_build(ui_renderer_t *ur, RCache *e, mu_Container *cnt, mu_Rect box) {
+    RTarget *t = &e->t;
+    if (!t->r || t->r->w != box.w || t->r->h != box.h) {
+        cache_entry_free(e);
+        t->r = renderer_new(box.w, box.h, (style_t){.fg=-1, .bg=-1, .raw=0});
+        t->mask = (unsigned char *)malloc((size_t)box.w * box.h);
+        if (!t->r || !t->mask) { cache_entry_free(e); t->r = NULL; t->mask = NULL; return 0; }
+    }
+    for (int i = 0; i < box.w * box.h; i++) {
+        t->r->cells[i]  = (utf8_t){" ", 1, 1};
+        t->r->styles[i] = (style_t){.fg=-1, .bg=-1, .raw=0};
+    }
+    memset(t->mask, 0, (size_t)box.w * box.h);
+    t->ox = box.x;
+    t->oy = box.y;
+    t->band = mu_rect(0, 0, ur->cur->w, ur->cur->h);
+    t->bad = 0;
+    draw_root(t, cnt);
+    flush_cells(t);
+    if (t->bad) { e->bad_hash = cnt->hash; e->hash = 0; return 0; }
+    e->hash = cnt->hash;
+    e->box = box;
+    return 1;
+}
+
+/* 只贴屏幕上 [y0, y1) 这几行 */
+static void cache_blit(renderer_t *d, const RCache *e, int y0, int y1) {
+    const renderer_t *src = e->t.r;
+    if (y0 < e->box.y) y0 = e->box.y;
+    if (y1 > e->box.y + src->h) y1 = e->box.y + src->h;
+    for (int y = y0 - e->box.y; y < y1 - e->box.y; y++) {
+        const unsigned char *m = e->t.mask + y * src->w;
+        int si = y * src->w, di = (y + e->box.y) * d->w + e->box.x;
+        for (int x = 0; x < src->w; x++) {
+            if (m[x] & R_MASK_FULL) {
+                d->cells[di + x]  = src->cells[si + x];
+                d->styles[di + x] = src->styles[si + x];
+            } else if (m[x]) {
+                d->styles[di + x].bg = src->styles[si + x].bg;
+            }
+        }
+    }
+}
+
+/* ---------- 分带并行光栅化 ----------
+ * 屏幕按行切成水平带. 先串行走一遍命令, 按 y 范围(与当时生效的裁剪矩形求交)把每条命令
+ * 分进它覆盖的带, 再由线程池各回放一条带: 带内保持原顺序, 写入限制在本带的行里,
+ * 所以结果与串行逐格一致. 根容器缓存面的建立仍在串行阶段, 贴图同样按带拆开. */
+#define R_BAND_MIN_CELLS  (64 * 1024)   /* 屏幕小于这个格数时分带不划算, 仍串行 */
+#define R_BAND_ROWS_MIN   8
+#define R_BANDS_PER_THREAD 4            /* 带数多于线程数, 忙闲不均时能摊开 */
+
+enum { R_ITEM_CMD, R_ITEM_BLIT, R_ITEM_CLEAR };
+
+typedef struct {
+    int            kind;
+    const void    *p;           /* mu_Command / RCache / mu_Container */
+    const mu_Rect *clip;        /* 生效的裁剪矩形, NULL 为不裁剪 */
+} RItem;
+
+struct RBand {
+    RItem   *items;
+    int      len, cap;
+    RTarget  t;
+};
+
+static void bands_free(ui_renderer_t *ur) {
+    for (int i = 0; i < ur->band_cap; i++) free(ur->bands[i].items);
+    free(ur->bands);
+    ur->bands = NULL;
+    ur->band_cap = ur->band_count = 0;
+}
+
+static void band_push(ui_renderer_t *ur, int kind, const void *p, const mu_Rect *clip, int y, int h) {
+    if (clip) {
+        int y1 = mu_min(y + h, clip->y + clip->h);
+        y = mu_max(y, clip->y);
+        h = y1 - y;
+    }
+    int y1 = mu_min(y + h, ur->cur->h);
+    y = mu_max(y, 0);
+    if (y1 <= y) return;
+    for (int b = y / ur->band_rows; b <= (y1 - 1) / ur->band_rows; b++) {
+        RBand *band = &ur->bands[b];
+        if (band->len == band->cap) {
+            int cap = band->cap ? band->cap * 2 : 256;
+            RItem *items = (RItem *)realloc(band->items, cap * sizeof(RItem));
+            if (!items) continue;   /* 内存不足时这条带少画一项, 不致崩溃 */
+            band->items = items;
+            band->cap = cap;
+        }
+        band->items[band->len++] = (RItem){ kind, p, clip };
+    }
+}
+
+static void band_push_root(ui_renderer_t *ur, mu_Container *cnt) {
+    const mu_Rect *clip = NULL;
+    mu_Command *cmd = (mu_Command *)((char *)cnt->head + sizeof(mu_JumpCommand));
+    if (cnt->opaque) band_push(ur, R_ITEM_CLEAR, cnt, NULL, cnt->rect.y, cnt->rect.h);
+    while (cmd != cnt->tail) {
+        switch (cmd->type) {
+            case MU_COMMAND_JUMP: cmd = cmd->jump.dst; continue;
+            case MU_COMMAND_CLIP: clip = &cmd->clip.rect; break;
+            case MU_COMMAND_RECT: band_push(ur, R_ITEM_CMD, cmd, clip, cmd->rect.rect.y, cmd->rect.rect.h); break;
+            case MU_COMMAND_ICON: band_push(ur, R_ITEM_CMD, cmd, clip, cmd->icon.rect.y, 1); break;
+            case MU_COMMAND_TEXT: band_push(ur, R_ITEM_CMD, cmd, clip, cmd->text.pos.y, 1); break;
+            case MU_COMMAND_GLYPHS: band_push(ur, R_ITEM_CMD, cmd, clip, cmd->glyphs.pos.y, 1); break;
+        }
+        cmd = (mu_Command *)((char *)cmd + cmd->base.size);
+    }
+}
+
+static void band_run(void *user, int i) {
+    RBand *band = &((ui_renderer_t *)user)->bands[i];
+    RTarget *t = &band->t;
+    for (int k = 0; k < band->len; k++) {
+        const RItem *it = &band->items[k];
+        t->clipping = it->clip != NULL;
+        if (it->clip) t->clip = *it->clip;
+        switch (it->kind) {
+            case R_ITEM_CMD: draw_command(t, (const mu_Command *)it->p); break;
+            case R_ITEM_BLIT: cache_blit(t->r, (const RCache *)it->p, t->band.y, t->band.y + t->band.h); break;
+            case R_ITEM_CLEAR: clear_rect(t, ((const mu_Container *)it->p)->rect); break;
+        }
+    }
+}
+
+/* 屏幕够大且有多个线程时开始收集本帧的绘制 */
+static int bands_begin(ui_renderer_t *ur) {
+    renderer_t *d = ur->cur;
+    int n = workers_count(ur->workers);
+    if (n <= 1 || d->w * d->h < R_BAND_MIN_CELLS) return 0;
+    int bands = n * R_BANDS_PER_THREAD;
+    ur->band_rows = mu_max(R_BAND_ROWS_MIN, (d->h + bands - 1) / bands);
+    ur->band_count = (d->h + ur->band_rows - 1) / ur->band_rows;
+    if (ur->band_count > ur->band_cap) {
+        RBand *b = (RBand *)realloc(ur->bands, ur->band_count * sizeof(RBand));
+        if (!b) return 0;
+        memset(b + ur->band_cap, 0, (ur->band_count - ur->band_cap) * sizeof(RBand));
+        ur->bands = b;
+        ur->band_cap = ur->band_count;
+    }
+    for (int i = 0; i < ur->band_count; i++) {
+        int y = i * ur->band_rows;
+        ur->bands[i].len = 0;
+        ur->bands[i].t = (RTarget){ .r = d, .band = mu_rect(0, y, d->w, mu_min(ur->band_rows, d->h - y)) };
+    }
+    return 1;
+}
+
+static void bands_end(ui_renderer_t *ur) {
+    workers_run(ur->workers, ur->band_count, band_run, ur);
+    for (int i = 0; i < ur->band_count; i++) flush_cells(&ur->bands[i].t);
+}
+
+void ur_set_threads(ui_renderer_t *ur, int n) {
+    if (n == workers_count(ur->workers)) return;
+    workers_free(ur->workers);
+    ur->workers = n > 1 ? workers_new(n) : NULL;
+}
+
+static void emit_root(ui_renderer_t *ur, mu_Container *cnt) {
+    if (ur->banding) band_push_root(ur, cnt);
+    else draw_root(&ur->screen, cnt);
+}
+
+static void emit_blit(ui_renderer_t *ur, RCache *e) {
+    if (ur->banding) band_push(ur, R_ITEM_BLIT, e, NULL, e->box.y, e->box.h);
+    else cache_blit(ur->cur, e, 0, ur->cur->h);
+}
+
+static void draw_root_cached(ui_renderer_t *ur, mu_Container *cnt) {
+    RCache *e = cache_get(ur, cnt);
+    /* 多留一格给窗口边框 */
+    mu_Rect box = rect_intersect(mu_rect(cnt->rect.x - 1, cnt->rect.y - 1, cnt->rect.w + 2, cnt->rect.h + 2),
+                                 mu_rect(0, 0, ur->cur->w, ur->cur->h));
+    int stable = (cnt->hash == e->last_hash);
+    e->last_hash = cnt->hash;
+
+    if (e->hash == cnt->hash && !memcmp(&e->box, &box, sizeof(box))) {
+        STAT_ADD(cache_hits, 1);
+        emit_blit(ur, e);
+        return;
+    }
+    STAT_ADD(cache_misses, 1);
+    if (stable && cnt->hash != e->bad_hash && box.w > 0 && box.h > 0 && cache_build(ur, e, cnt, box)) {
+        emit_blit(ur, e);
+        return;
+    }
+    e->hash = 0;
+    emit_root(ur, cnt);
+}
+
+void ur_set_cache(ui_renderer_t *ur, int on) {
+    ur->cache_on = on;
+    if (!on) cache_free_all(ur);
+}
+
+void ur_draw_commands(ui_renderer_t *ur, mu_Context *ctx) {
+    mu_Command *cmd = NULL;
+    int roots = ctx->root_list.idx;
+    STAT_PHASE_BEGIN(STAT_PHASE_RASTER);
+    ur->screen.clipping = 0;
+    ur->banding = roots > 0 && bands_begin(ur);
+    if (ur->cache_on && roots > 0) {
+        /* root_list 在 mu_end 里已按 z 序排好. 先把表扩够, 收集期间表项地址不能变 */
+        ur->cache_frame++;
+        while ((ur->cache_len + roots + 1) * 2 > ur->cache_cap) cache_rehash(ur, ur->cache_cap ? ur->cache_cap * 2 : 64, 0);
+        for (int i = 0; i < roots; i++) draw_root_cached(ur, ctx->root_list.items[i]);
+        if (ur->banding) bands_end(ur);
+        if (ur->cache_len > roots) cache_rehash(ur, ur->cache_cap, 1); /* 释放已消失容器的缓存 */
+    } else if (roots > 0) {
+        for (int i = 0; i < roots; i++) emit_root(ur, ctx->root_list.items[i]);
+        if (ur->banding) bands_end(ur);
+    } else {
+        while (mu_next_command(ctx, &cmd)) draw_command(&ur->screen, cmd);
+    }
+    ur->banding = 0;
+    flush_cells(&ur->screen);
+    STAT_PHASE_END(STAT_PHASE_RASTER);
+}
+
+/* ---------- 差分输出 ---------- */
+#define R_SHIFT_MAX   16    /* 行内水平位移(ICH/DCH)检测的最大列数 */
+#define R_MOVE_COST   8     /* 估算一次光标定位(CUP)的字节数 */
+
+static const utf8_t  g_blank_cell  = {" ", 1, 1};
+static const style_t g_blank_style = {.fg=-1, .bg=-1, .raw=0};
+static const utf8_t  g_unknown_cell = {{0xFF, 0xFF, 0xFF, 0xFF}, 4, 1};  /* 旧帧里内容不确定的格子: 不是合法 UTF-8, 与任何新格都不等, 一定重画 */
+
+static void out_write(ui_renderer_t *ur, const char *s, int len) {
+    if (ur->out_len + len > ur->out_cap) {
+        int cap = ur->out_cap ? ur->out_cap : 4096;
+        while (cap < ur->out_len + len) cap *= 2;
+        char *p = (char *)realloc(ur->out, cap);
+        if (!p) return;
+        ur->out = p;
+        ur->out_cap = cap;
+    }
+    memcpy(ur->out + ur->out_len, s, len);
+    ur->out_len += len;
+}
+
+static void out_csi(ui_renderer_t *ur, int n, char final) {
+    char buf[16];
+    out_write(ur, buf, sprintf(buf, "\x1b[%d%c", n, final));
+}
+
+static void out_cup(ui_renderer_t *ur, int x, int y) {
+    char buf[32];
+    out_write(ur, buf, sprintf(buf, "\x1b[%d;%dH", y + 1, x + 1));
+}
+
+static void out_pen(ui_renderer_t *ur, style_t s) {
+    if (!style_cmp(ur->pen, s)) return;
+    out_write(ur, "\x1b[0m", 4);
+    STAT_ADD(sgr, 1);
+    if (style_cmp(s, g_blank_style)) {
+        char seq[STYLE_STR_MAX];
+        out_write(ur, seq, style_to_buf(s, seq));
+    }
+    ur->pen = s;
+}
+
+/* 按显示效果比较: 无属性的空格不关心前景色 */
+static int cell_eq_raw(utf8_t ua, style_t sa, utf8_t ub, style_t sb) {
+    if (utf8_cmp(ua, ub)) return 0;
+    if (ua.len == 1 && ua.bytes[0] == ' ' && !sa.raw && !sb.raw) return sa.bg == sb.bg;
+    return !style_cmp(sa, sb);
+}
+
+static int cell_eq(const renderer_t *a, int ia, const renderer_t *b, int ib) {
+    return cell_eq_raw(a->cells[ia], a->styles[ia], b->cells[ib], b->styles[ib]);
+}
+
+/* ICH/DCH 产生的空白格取当前背景色(BCE), 这里选成与新帧相邻格一致 */
+static style_t shift_fill(const renderer_t *n, int y, int l, int k) {
+    int x = k > 0 ? l : n->w - 1;
+    style_t s = g_blank_style;
+    s.bg = n->styles[y * n->w + x].bg;
+    return s;
+}
+
+/* 在 l 处插入(k>0)或删除(k<0) |k| 列后, 旧行第 x 列的来源下标, -1 表示空白 */
+static int shift_src(int x, int l, int k, int w) {
+    if (x < l) return x;
+    if (k > 0) return (x < l + k) ? -1 : x - k;
+    return (x - k < w) ? x - k : -1;
+}
+
+/* 估算把(位移后的)旧行 [l, w) 画成新行的代价: 变化格数 + 每段一次光标定位 */
+static int row_cost(ui_renderer_t *ur, int y, int l, int k) {
+    const renderer_t *n = ur->src, *o = ur->last;
+    int w = n->w, base = y * w, cost = 0, in_run = 0;
+    style_t fill = shift_fill(n, y, l, k);
+    for (int x = l; x < w; x++) {
+        int src = shift_src(x, l, k, w), eq;
+        if (src < 0) eq = cell_eq_raw(n->cells[base + x], n->styles[base + x], g_blank_cell, fill);
+        else         eq = cell_eq(n, base + x, o, base + src);
+        if (eq) { in_run = 0; continue; }
+        if (!in_run) cost += R_MOVE_COST;
+        in_run = 1;
+        cost++;
+    }
+    return cost;
+}
+
+/* 寻找最省的水平位移; 返回 0 表示直接重画 */
+static int detect_shift(ui_renderer_t *ur, int y, int l, int r) {
+    const renderer_t *n = ur->src, *o = ur->last;
+    int w = n->w, base = y * w;
+    if (r - l < 2) return 0;
+    int best = 0, best_cost = row_cost(ur, y, l, 0);
+    for (int d = 1; d <= R_SHIFT_MAX && l + d < w; d++) {
+        for (int k = d; k >= -d; k -= 2 * d) {
+            /* 快速排除: 位移后最后一个变化格必须能对上 */
+            int src = shift_src(r, l, k, w);
+            if (src < 0 || !cell_eq(n, base + r, o, base + src)) continue;
+            if (k < 0 && o->cells[base + l - k].len == 0) continue;    /* 不能从宽字符中间删 */
+            int cost = row_cost(ur, y, l, k) + R_MOVE_COST;
+            if (cost < best_cost) { best_cost = cost; best = k; }
+        }
+    }
+    return best;
+}
+
+/* 在终端和旧帧模型上同时执行 ICH/DCH */
+static void apply_shift(ui_renderer_t *ur, int y, int l, int k) {
+    renderer_t *o = ur->last;
+    int w = o->w, base = y * w, n = k > 0 ? k : -k;
+    utf8_t  *c = o->cells + base;
+    style_t *s = o->styles + base;
+    style_t fill = shift_fill(ur->src, y, l, k);
+
+    if (ur->budget) {
+        /* 预算模式下这次输出可能作废, 先记下旧行 */
+        memcpy(ur->undo_cells + ur->undo_len * w, c, w * sizeof(*c));
+        memcpy(ur->undo_styles + ur->undo_len * w, s, w * sizeof(*s));
+        ur->undo_rows[ur->undo_len++] = y;
+    }
+    out_pen(ur, fill);
+    out_cup(ur, l, y);
+    out_csi(ur, n, k > 0 ? '@' : 'P');
+
+    if (k > 0) {
+        memmove(c + l + n, c + l, (w - l - n) * sizeof(*c));
+        memmove(s + l + n, s + l, (w - l - n) * sizeof(*s));
+        for (int x = l; x < l + n; x++) { c[x] = g_blank_cell; s[x] = fill; }
+        /* 被挤出右边界的宽字符只剩半个, 各终端处理不一(擦掉或留着), 记为未知 */
+        if (c[w - 1].width > 1) c[w - 1] = g_unknown_cell;
+    } else {
+        memmove(c + l, c + l + n, (w - l - n) * sizeof(*c));
+        memmove(s + l, s + l + n, (w - l - n) * sizeof(*s));
+        for (int x = w - n; x < w; x++) { c[x] = g_blank_cell; s[x] = fill; }
+    }
+}
+
+static void paint_row(ui_renderer_t *ur, int y, int l) {
+    const renderer_t *n = ur->src, *o = ur->last;
+    int w = n->w, base = y * w, cx = -1;
+    for (int x = l; x < ur->area.x + ur->area.w; x++) {
+        const utf8_t *u = &n->cells[base + x];
+        if (u->len == 0) continue;      /* 宽字符的后半格随前半格一起输出 */
+        int wd = u->width ? u->width : 1, same = 1;
+        for (int i = x; i < x + wd && i < w; i++) same &= cell_eq(n, base + i, o, base + i);
+        if (same) continue;
+
+        if (cx != x) out_cup(ur, x, y);
+        out_pen(ur, n->styles[base + x]);
+        STAT_ADD(cells_changed, 1);
+        if (u->width) out_write(ur, (const char *)u->bytes, u->len);
+        else          out_write(ur, " ", 1);
+        cx = x + wd;
+    }
+}
+
+static void present_row(ui_renderer_t *ur, int y) {
+    const renderer_t *n = ur->src, *o = ur->last;
+    int base = y * n->w, x0 = ur->area.x, x1 = ur->area.x + ur->area.w, l = x0, r = x1 - 1;
+    while (l < x1 && cell_eq(n, base + l, o, base + l)) l++;
+    if (l == x1) return;
+    while (r > l && cell_eq(n, base + r, o, base + r)) r--;
+    /* 从新旧两行都对齐的字符起点开始 */
+    while (l > x0 && (n->cells[base + l].len == 0 || o->cells[base + l].len == 0)) l--;
+
+    int k = ur->shifts ? detect_shift(ur, y, l, r) : 0;
+    if (k) apply_shift(ur, y, l, k);
+    paint_row(ur, y, l);
+}
+
+/* 生成 ur->area 范围的差分输出, 不改旧帧(ICH/DCH 除外, 见 undo) */
+static void present_pass(ui_renderer_t *ur, const renderer_t *src, mu_Rect area, int shifts) {
+    ur->src = src;
+    ur->area = area;
+    ur->shifts = shifts && area.x == 0 && area.w == src->w;
+    ur->out_len = 0;
+    ur->undo_len = 0;
+    if (ur->first) out_write(ur, "\x1b[0m\x1b[2J", 8);
+    ur->pen = g_blank_style;
+    for (int y = area.y; y < area.y + area.h; y++) present_row(ur, y);
+    out_pen(ur, g_blank_style);
+}
+
+/* 放弃这次试算: 恢复被 ICH/DCH 改过的旧帧行 */
+static void present_undo(ui_renderer_t *ur) {
+    int w = ur->last->w;
+    for (int i = 0; i < ur->undo_len; i++) {
+        int y = ur->undo_rows[i];
+        memcpy(ur->last->cells + y * w, ur->undo_cells + i * w, w * sizeof(utf8_t));
+        memcpy(ur->last->styles + y * w, ur->undo_styles + i * w, w * sizeof(style_t));
+    }
+    ur->undo_len = 0;
+}
+
+/* 发出这次输出, 终端上 area 范围的内容已与 src 一致 */
+static void present_commit(ui_renderer_t *ur) {
+    const renderer_t *src = ur->src;
+    renderer_t *last = ur->last;
+    mu_Rect a = ur->area;
+    ur->first = 0;      /* 先清掉: 写出失败时 write 回调可以再置位, 要求下次整屏重画 */
+    if (ur->out_len && ur->write) ur->write(ur->user, ur->out, ur->out_len);
+    for (int y = a.y; y < a.y + a.h; y++) {
+        memcpy(last->cells + y * last->w + a.x, src->cells + y * src->w + a.x, a.w * sizeof(utf8_t));
+        memcpy(last->styles + y * last->w + a.x, src->styles + y * src->w + a.x, a.w * sizeof(style_t));
+    }
+}
+
+/* 当前帧降到 colors 色的副本 */
+static const renderer_t *present_quantize(ui_renderer_t *ur, int colors) {
+    renderer_t *q = &ur->quant, *cur = ur->cur;
+    int n = cur->w * cur->h;
+    q->cells = cur->cells;
+    q->w = cur->w;
+    q->h = cur->h;
+    for (int i = 0; i < n; i++) {
+        q->styles[i] = cur->styles[i];
+        q->styles[i].fg = style_quantize(cur->styles[i].fg, colors);
+        q->styles[i].bg = style_quantize(cur->styles[i].bg, colors);
+    }
+    return q;
+}
+
+static int budget_alloc(ui_renderer_t *ur) {
+    size_t n = (size_t)ur->cur->w * ur->cur->h;
+    if (!ur->quant.styles) ur->quant.styles = (style_t *)malloc(n * sizeof(style_t));
+    if (!ur->undo_cells) ur->undo_cells = (utf8_t *)malloc(n * sizeof(utf8_t));
+    if (!ur->undo_styles) ur->undo_styles = (style_t *)malloc(n * sizeof(style_t));
+    if (!ur->undo_rows) ur->undo_rows = (int *)malloc(ur->cur->h * sizeof(int));
+    return ur->quant.styles && ur->undo_cells && ur->undo_styles && ur->undo_rows ? 0 : -1;
+}
+
+/* 超预算时逐级降级: 全彩 -> 256 色 -> 16 色 -> 只输出焦点区域 -> 整帧推迟(与后面的帧合并).
+ * 令牌桶攒满一秒的量仍放不下时, 照发 16 色的整屏, 保证画面至少每秒跟上一次 */
+static void present_budget(ui_renderer_t *ur) {
+    renderer_t *cur = ur->cur;
+    mu_Rect full = mu_rect(0, 0, cur->w, cur->h);
+    long long now = timer_ns();
+    ur->tokens += (double)(now - ur->tick) * ur->budget / 1e9;
+    if (ur->tokens > ur->budget) ur->tokens = ur->budget;
+    ur->tick = now;
+
+    present_pass(ur, cur, full, 1);
+    if (ur->out_len <= ur->tokens) { ur->quality = UR_Q_FULL; goto send; }
+    present_undo(ur);
+    present_pass(ur, present_quantize(ur, 256), full, 0);
+    if (ur->out_len <= ur->tokens) { ur->quality = UR_Q_256; goto send; }
+    present_pass(ur, present_quantize(ur, 16), full, 0);
+    if (ur->out_len <= ur->tokens) { ur->quality = UR_Q_16; goto send; }
+    if (ur->tokens >= ur->budget) { ur->quality = UR_Q_16; goto send; }
+    int need = ur->out_len;
+
+    mu_Rect focus = rect_intersect(ur->focus, full);
+    if (focus.w > 0 && !ur->first) {
+        present_pass(ur, &ur->quant, focus, 0);
+        if (ur->out_len > 0 && ur->out_len <= ur->tokens) {
+            present_commit(ur);
+            ur->tokens -= ur->out_len;
+            ur->quality = UR_Q_FOCUS;
+            ur->need = need;
+            return;
+        }
+    }
+    ur->quality = UR_Q_DEFERRED;
+    ur->need = need;
+    return;
+
+send:
+    present_commit(ur);
+    ur->tokens -= ur->out_len;
+    ur->need = 0;
+}
+
+void ur_present(ui_renderer_t *ur) {
+    renderer_t *cur = ur->cur;
+    STAT_PHASE_BEGIN(STAT_PHASE_PRESENT);
+    if (ur->first) {
+        /* 清屏后终端内容已知: 全部为默认样式的空格 */
+        for (int i = 0; i < cur->w * cur->h; i++) {
+            ur->last->cells[i]  = g_blank_cell;
+            ur->last->styles[i] = g_blank_style;
+        }
+    }
+    if (ur->budget && !budget_alloc(ur)) {
+        present_budget(ur);
+    } else {
+        present_pass(ur, cur, mu_rect(0, 0, cur->w, cur->h), 1);
+        present_commit(ur);
+    }
+    STAT_PHASE_END(STAT_PHASE_PRESENT);
+}
+
+void ur_set_budget(ui_renderer_t *ur, int bytes_per_sec) {
+    ur->budget = bytes_per_sec > 0 ? bytes_per_sec : 0;
+    ur->tokens = ur->budget;
+    ur->tick = timer_ns();
+    ur->need = 0;
+    ur->quality = UR_Q_FULL;
+}
+
+void ur_set_focus(ui_renderer_t *ur, mu_Rect rect) {
+    ur->focus = rect;
+}
+
+int ur_quality(ui_renderer_t *ur) {
+    return ur->quality;
+}
+
+int ur_deferred_ms(ui_renderer_t *ur) {
+    if (!ur->budget || !ur->need) return -1;
+    double wait = (mu_min(ur->need, ur->budget) - ur->tokens) * 1000.0 / ur->budget;
+    wait -= (double)(timer_ns() - ur->tick) / 1e6;
+    return wait > 0 ? (int)wait + 1 : 0;
+}
+
+/* ---------- 输出到 fd ---------- */
+/* 尽量写出去; 写满时最多等 UR_FD_WAIT_MS, 返回写出的字节数 */
+static int fd_write(ui_renderer_t *ur, const char *buf, int len) {
+    int done = 0;
+    while (done < len) {
+#ifdef _WIN32
+        int n = _write(ur->fd, buf + done, len - done);
+#else
+        int n = (int)write(ur->fd, buf + done, len - done);
+#endif
+        if (n > 0) { done += n; continue; }
+#ifndef _WIN32
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd p = { .fd = ur->fd, .events = POLLOUT };
+            if (poll(&p, 1, UR_FD_WAIT_MS) > 0) continue;
+        }
+#endif
+        break;
+    }
+    return done;
+}
+
+int ur_flush(ui_renderer_t *ur) {
+    if (!ur->fd_len) return 0;
+    int n = fd_write(ur, ur->fd_out, ur->fd_len);
+    memmove(ur->fd_out, ur->fd_out + n, ur->fd_len - n);
+    ur->fd_len -= n;
+    return ur->fd_len;
+}
+
+int ur_backlog(ui_renderer_t *ur) {
+    return ur->fd_len;
+}
+
+/* 写不下的部分留到下次; 积压超过 UR_FD_MAX 时整个丢掉, 下次输出清屏重画 */
+static void fd_sink(void *user, const char *buf, int len) {
+    ui_renderer_t *ur = (ui_renderer_t *)user;
+    int n = ur_flush(ur) ? 0 : fd_write(ur, buf, len);
+    buf += n;
+    len -= n;
+    if (!len) return;
+    if (ur->fd_len + len > UR_FD_MAX) {
+        ur->fd_len = 0;
+        ur->first = 1;
+        return;
+    }
+    if (ur->fd_len + len > ur->fd_cap) {
+        int cap = ur->fd_cap ? ur->fd_cap : 4096;
+        while (cap < ur->fd_len + len) cap *= 2;
+        char *p = (char *)realloc(ur->fd_out, cap);
+        if (!p) { ur->fd_len = 0; ur->first = 1; return; }
+        ur->fd_out = p;
+        ur->fd_cap = cap;
+    }
+    memcpy(ur->fd_out + ur->fd_len, buf, len);
+    ur->fd_len += len;
+}
+
+ui_renderer_t *ur_new_fd(int w, int h, int fd) {
+    ui_renderer_t *ur = ur_new(w, h, fd_sink, NULL);
+    if (!ur) return NULL;
+    ur->user = ur;
+    ur->fd = fd;
+    return ur;
+}
+
+/* ---------- 输出到本进程的终端 ---------- */
+static void term_sink(void *user, const char *buf, int len) {
+    (void)user;
+    term_write(buf, len);
+    term_flush();
+}
+
+ui_renderer_t *ur_new_term(void) {
+    term_init();
+    int width = 0, height = 0;
+    term_get_size(&width, &height);
+    return ur_new(width, height, term_sink, NULL);
+}
+
+int ur_fit_term(ui_renderer_t *ur) {
+    term_init();
+    int width = 0, height = 0;
+    term_get_size(&width, &height);
+    return ur_resize(ur, width, height);
+}
+
+/* ---------- 直接绘制: 不经命令列表, 用于测试和简单界面 ---------- */
+void ur_draw_rect(ui_renderer_t *ur, mu_Rect r, mu_Color color)                 { draw_rect(&ur->screen, r, color); flush_cells(&ur->screen); }
+void ur_draw_text(ui_renderer_t *ur, const char *text, mu_Vec2 pos, mu_Color color) { draw_text(&ur->screen, text, pos, color); flush_cells(&ur->screen); }
+void ur_draw_icon(ui_renderer_t *ur, int id, mu_Rect rect, mu_Color color)      { draw_icon(&ur->screen, id, rect, color); flush_cells(&ur->screen); }
+void ur_draw_glyphs(ui_renderer_t *ur, const mu_GlyphCommand *cmd) {
+    draw_glyphs(&ur->screen, (const utf8_t *)cmd->glyphs, cmd->count, cmd->pos, cmd->color);
+    flush_cells(&ur->screen);
+}
+
+void ur_set_clip_rect(ui_renderer_t *ur, mu_Rect rect) {
+    ur->screen.clipping = 1;
+    ur->screen.clip = rect;
+}
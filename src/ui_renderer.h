@@ -1,19 +1,63 @@
-#ifndef __UI_RENDERER_H__
-#define __UI_RENDERER_H__ 
-
-#include "microui.h"
-#include "term.h"
-#include "renderer.h"
-#include "log.h"
-
-void r_init(void);
-void r_clear(mu_Color color);
-void r_draw_rect(mu_Rect r, mu_Color color);
-void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color);
-void r_draw_icon(int id, mu_Rect rect, mu_Color color);
-int  r_get_text_width(const char *text, int len);
-int  r_get_text_height(void);
-void r_set_clip_rect(mu_Rect rect);
-void r_present(void);
-
+#ifndef __UI_RENDERER_H__
+#define __UI_RENDERER_H__ 
+
+#include "microui.h"
+#include "term.h"
+#include "renderer.h"
+#include "log.h"
+
+/* 渲染实例: 一块屏幕的渲染缓冲、根容器缓存和差分输出状态, 各实例互不相干.
+ * 多会话时每个会话一个实例, 可以在不同线程里同时使用; 只读共享的只有图标字形表.
+ * 每次 ur_present 的输出一次性交给 write 回调. 没有全局的默认实例, 单屏程序用 ur_new_term 建一个. */
+typedef struct ui_renderer_t ui_renderer_t;
+typedef void (*ur_write_fn)(void *user, const char *buf, int len);
+
+ui_renderer_t *ur_new(int w, int h, ur_write_fn write, void *user);    // 失败返回 NULL
+void ur_free(ui_renderer_t *ur);
+int  ur_resize(ui_renderer_t *ur, int w, int h);    // 下次输出整屏重画; 失败返回 -1
+void ur_clear(ui_renderer_t *ur, mu_Color color);
+void ur_draw_commands(ui_renderer_t *ur, mu_Context *ctx);
+void ur_present(ui_renderer_t *ur);
+void ur_set_cache(ui_renderer_t *ur, int on);
+void ur_set_threads(ui_renderer_t *ur, int n);
+renderer_t *ur_get_renderer(ui_renderer_t *ur);
+
+/* 输出写到 fd(pty/socket/管道), fd 应为非阻塞. 写满时最多等 UR_FD_WAIT_MS,
+ * 剩下的积压起来, 在下次 present 或 ur_flush 时先写; 积压超过 UR_FD_MAX 就丢弃, 下次清屏重画 */
+#define UR_FD_WAIT_MS   10
+#define UR_FD_MAX       (1 << 20)
+ui_renderer_t *ur_new_fd(int w, int h, int fd);
+int  ur_flush(ui_renderer_t *ur);   // 写出积压的输出, 返回仍未写出的字节数; 有积压时可等 fd 可写再调
+int  ur_backlog(ui_renderer_t *ur); // 积压的字节数, 不写
+
+/* 带宽预算: 超出每秒字节数时逐级降级 -- 降到 256 色, 再到 16 色, 再只输出焦点区域,
+ * 最后整帧推迟到令牌够了再与之后的帧合并输出. 画面始终是最新的, 只是变粗糙;
+ * 预算恢复后下一次输出自动补回全彩和被推迟的区域 */
+enum { UR_Q_FULL, UR_Q_256, UR_Q_16, UR_Q_FOCUS, UR_Q_DEFERRED };
+void ur_set_budget(ui_renderer_t *ur, int bytes_per_sec);  // 0 为不限(默认)
+void ur_set_focus(ui_renderer_t *ur, mu_Rect rect);         // 超预算时优先输出的区域
+int  ur_quality(ui_renderer_t *ur);                         // 上次 ur_present 的降级程度, UR_Q_*
+int  ur_deferred_ms(ui_renderer_t *ur);                     // 有推迟的内容时, 多少毫秒后值得再 present; 否则 -1
+
+/* 输出到本进程的终端: 先 term_init, 尺寸取自 term_get_size, 输出到 term_write.
+ * 终端尺寸变化(TERM_EV_RESIZE)后调 ur_fit_term, 下次输出整屏重画 */
+ui_renderer_t *ur_new_term(void);
+int  ur_fit_term(ui_renderer_t *ur);
+
+/* 直接绘制, 不经命令列表; 坐标为屏幕坐标, 裁剪矩形一直生效到下次设置 */
+void ur_draw_rect(ui_renderer_t *ur, mu_Rect r, mu_Color color);
+void ur_draw_text(ui_renderer_t *ur, const char *text, mu_Vec2 pos, mu_Color color);
+void ur_draw_icon(ui_renderer_t *ur, int id, mu_Rect rect, mu_Color color);
+void ur_draw_glyphs(ui_renderer_t *ur, const mu_GlyphCommand *cmd);     // MU_COMMAND_GLYPHS: 已解码的字符直接拷进格子
+void ur_set_clip_rect(ui_renderer_t *ur, mu_Rect rect);
+
+/* 文本测量, 与实例无关 */
+int  r_get_text_width(const char *text, int len);
+// 作为 mu_Context.text_width / text_height: 按终端格宽测量, 每行一格高
+int  r_text_width(mu_Font font, const char *text, int len);
+int  r_text_height(mu_Font font);
+// 作为 mu_Context.text_glyphs, 配合 glyph_size = sizeof(utf8_t): 文本在压入命令时解码一次
+int  r_text_glyphs(mu_Font font, const char *text, int len, void *glyphs, int *width);
+int  r_get_text_height(void);
+
 #endif /* __UI_RENDERER_H__ */
\ No newline at end of file
@@ -0,0 +1,349 @@
+#ifndef __VT_H__
+#define __VT_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include "utf8.h"
+#include "style.h"
+#include "renderer.h"
+
+/* 内存中的 VT 终端模拟器: 把输出字节流解析到一块 renderer_t 屏幕上,
+ * 用于无头测试和基准. 支持 CUP/SGR/EL/ED/ECH/REP/ICH/DCH/IL/DL/SU/SD,
+ * DECSTBM 滚动区域, 光标保存恢复, 以及 DEC 2026 同步输出. */
+
+#define VT_MAX_PARAMS 16
+
+enum { VT_GROUND, VT_ESC, VT_CSI, VT_OSC, VT_OSC_ESC };
+
+typedef struct {
+    renderer_t *screen;
+    int     x, y;               /* 光标, 0 起始 */
+    int     wrap_pending;       /* 写满最后一列后, 下一个字符才换行 */
+    int     top, bot;           /* 滚动区域 [top, bot] */
+    style_t pen;
+    int     save_x, save_y;
+    style_t save_pen;
+    utf8_t  last;               /* REP 重复的字符 */
+    int     cursor_visible;
+    int     sync;               /* DEC 2026 是否处于同步更新中 */
+    int     sync_frames;        /* 完整的同步帧数 */
+
+    /* 解析器 */
+    int     state;
+    int     params[VT_MAX_PARAMS], nparams;
+    char    priv;               /* '?' 等私有前缀 */
+    uint8_t u8[4];
+    int     u8_len, u8_need;
+} vt_t;
+
+static const style_t vt_default_style = {.fg=-1, .bg=-1, .raw=0};
+
+static inline int vt_min(int a, int b) { return a < b ? a : b; }
+static inline int vt_max(int a, int b) { return a > b ? a : b; }
+static inline int vt_clamp(int x, int a, int b) { return vt_min(b, vt_max(a, x)); }
+
+static inline void vt_reset(vt_t *vt) {
+    renderer_t *s = vt->screen;
+    memset(vt, 0, sizeof(*vt));
+    vt->screen = s;
+    vt->bot = s->h - 1;
+    vt->pen = vt->save_pen = vt_default_style;
+    vt->last = (utf8_t){" ", 1, 1};
+    vt->cursor_visible = 1;
+    for (int i = 0; i < s->w * s->h; i++) {
+        s->cells[i]  = (utf8_t){" ", 1, 1};
+        s->styles[i] = vt_default_style;
+    }
+}
+
+static inline vt_t *vt_new(int w, int h) {
+    vt_t *vt = (vt_t *)calloc(1, sizeof(*vt));
+    if (!vt) return NULL;
+    vt->screen = renderer_new(w, h, vt_default_style);
+    if (!vt->screen) { free(vt); return NULL; }
+    vt_reset(vt);
+    return vt;
+}
+
+static inline void vt_free(vt_t *vt) {
+    if (!vt) return;
+    renderer_free(vt->screen);
+    free(vt);
+}
+
+/* ---------- 屏幕操作 ---------- */
+static inline void vt_erase(vt_t *vt, int x0, int y, int x1) {
+    renderer_t *s = vt->screen;
+    style_t blank = {.fg=-1, .bg=vt->pen.bg, .raw=0};   /* BCE */
+    if (x0 < 0) x0 = 0;
+    if (x1 > s->w) x1 = s->w;
+    for (int x = x0; x < x1; x++) {
+        s->cells[y * s->w + x]  = (utf8_t){" ", 1, 1};
+        s->styles[y * s->w + x] = blank;
+    }
+}
+
+/* 把 [top, bot] 区域内的行向上(n>0)或向下(n<0)滚动 */
+static inline void vt_scroll(vt_t *vt, int top, int bot, int n) {
+    renderer_t *s = vt->screen;
+    int rows = bot - top + 1, w = s->w;
+    if (rows <= 0 || n == 0) return;
+    int k = n > 0 ? n : -n;
+    if (k > rows) k = rows;
+    if (n > 0) {
+        memmove(s->cells  + top * w, s->cells  + (top + k) * w, (rows - k) * w * sizeof(utf8_t));
+        memmove(s->styles + top * w, s->styles + (top + k) * w, (rows - k) * w * sizeof(style_t));
+        for (int y = bot - k + 1; y <= bot; y++) vt_erase(vt, 0, y, w);
+    } else {
+        memmove(s->cells  + (top + k) * w, s->cells  + top * w, (rows - k) * w * sizeof(utf8_t));
+        memmove(s->styles + (top + k) * w, s->styles + top * w, (rows - k) * w * sizeof(style_t));
+        for (int y = top; y < top + k; y++) vt_erase(vt, 0, y, w);
+    }
+}
+
+static inline void vt_linefeed(vt_t *vt) {
+    if (vt->y == vt->bot) vt_scroll(vt, vt->top, vt->bot, 1);
+    else if (vt->y < vt->screen->h - 1) vt->y++;
+}
+
+/* 在光标处插入(n>0)或删除(n<0)字符, 右侧内容随之移动 */
+static inline void vt_shift_chars(vt_t *vt, int n) {
+    renderer_t *s = vt->screen;
+    int w = s->w, k = n > 0 ? n : -n, x = vt->x;
+    utf8_t  *c  = s->cells  + vt->y * w;
+    style_t *st = s->styles + vt->y * w;
+    if (k > w - x) k = w - x;
+    if (n > 0) {
+        memmove(c + x + k,  c + x,  (w - x - k) * sizeof(*c));
+        memmove(st + x + k, st + x, (w - x - k) * sizeof(*st));
+        vt_erase(vt, x, vt->y, x + k);
+    } else {
+        memmove(c + x,  c + x + k,  (w - x - k) * sizeof(*c));
+        memmove(st + x, st + x + k, (w - x - k) * sizeof(*st));
+        vt_erase(vt, w - k, vt->y, w);
+    }
+}
+
+static inline void vt_put(vt_t *vt, utf8_t u) {
+    renderer_t *s = vt->screen;
+    if (u.width == 0) return;
+    if (vt->wrap_pending || vt->x + u.width > s->w) {
+        vt->x = 0;
+        vt->wrap_pending = 0;
+        vt_linefeed(vt);
+    }
+    /* 覆盖宽字符的一半时, 另一半也被擦掉 */
+    utf8_t *row = s->cells + vt->y * s->w;
+    int end = vt->x + u.width;
+    if (row[vt->x].len == 0 && vt->x > 0) row[vt->x - 1] = (utf8_t){" ", 1, 1};
+    renderer_set(s, vt->x, vt->y, &u, &vt->pen);
+    if (end < s->w && row[end].len == 0) row[end] = (utf8_t){" ", 1, 1};
+    vt->last = u;
+    vt->x += u.width;
+    if (vt->x >= s->w) { vt->x = s->w - 1; vt->wrap_pending = 1; }
+}
+
+/* ---------- SGR ---------- */
+static inline int vt_color16(int i)  { return style_palette_rgb(i & 15); }
+static inline int vt_color256(int i) { return style_palette_rgb(i); }
+
+static inline void vt_sgr(vt_t *vt) {
+    style_t *p = &vt->pen;
+    if (vt->nparams == 0) { *p = vt_default_style; return; }
+    for (int i = 0; i < vt->nparams; i++) {
+        int a = vt->params[i];
+        switch (a) {
+        case 0:  *p = vt_default_style; break;
+        case 1:  p->bold = 1;       break;
+        case 3:  p->italic = 1;     break;
+        case 4:  p->underline = 1;  break;
+        case 5:  p->blink = 1;      break;
+        case 7:  p->reverse = 1;    break;
+        case 9:  p->strike = 1;     break;
+        case 22: p->bold = 0;       break;
+        case 23: p->italic = 0;     break;
+        case 24: p->underline = 0;  break;
+        case 25: p->blink = 0;      break;
+        case 27: p->reverse = 0;    break;
+        case 29: p->strike = 0;     break;
+        case 39: p->fg = -1;        break;
+        case 49: p->bg = -1;        break;
+        case 38: case 48: {
+            int *dst = (a == 38) ? &p->fg : &p->bg;
+            if (i + 1 < vt->nparams && vt->params[i + 1] == 5 && i + 2 < vt->nparams) {
+                *dst = vt_color256(vt->params[i + 2]);
+                i += 2;
+            } else if (i + 1 < vt->nparams && vt->params[i + 1] == 2 && i + 4 < vt->nparams) {
+                *dst = (vt->params[i + 2] << 16) | (vt->params[i + 3] << 8) | vt->params[i + 4];
+                i += 4;
+            }
+            break;
+        }
+        default:
+            if (a >= 30 && a <= 37)   p->fg = vt_color16(a - 30);
+            if (a >= 40 && a <= 47)   p->bg = vt_color16(a - 40);
+            if (a >= 90 && a <= 97)   p->fg = vt_color16(a - 90 + 8);
+            if (a >= 100 && a <= 107) p->bg = vt_color16(a - 100 + 8);
+            break;
+        }
+    }
+}
+
+/* ---------- CSI ---------- */
+static inline int vt_param(vt_t *vt, int i, int def) {
+    return (i < vt->nparams && vt->params[i] > 0) ? vt->params[i] : def;
+}
+
+static inline void vt_csi(vt_t *vt, char final) {
+    renderer_t *s = vt->screen;
+    int n = vt_param(vt, 0, 1);
+    if (vt->priv == '?') {
+        for (int i = 0; i < vt->nparams; i++) {
+            int on = (final == 'h');
+            if (final != 'h' && final != 'l') break;
+            if (vt->params[i] == 25) vt->cursor_visible = on;
+            if (vt->params[i] == 2026) {
+                if (vt->sync && !on) vt->sync_frames++;
+                vt->sync = on;
+            }
+        }
+        return;
+    }
+    if (final != 'm' && final != 'b') vt->wrap_pending = 0;
+    switch (final) {
+    case 'A': vt->y = vt_max(vt->y - n, 0); break;
+    case 'B': vt->y = vt_min(vt->y + n, s->h - 1); break;
+    case 'C': vt->x = vt_min(vt->x + n, s->w - 1); break;
+    case 'D': vt->x = vt_max(vt->x - n, 0); break;
+    case 'G': vt->x = vt_clamp(n - 1, 0, s->w - 1); break;
+    case 'd': vt->y = vt_clamp(n - 1, 0, s->h - 1); break;
+    case 'H': case 'f':
+        vt->y = vt_clamp(vt_param(vt, 0, 1) - 1, 0, s->h - 1);
+        vt->x = vt_clamp(vt_param(vt, 1, 1) - 1, 0, s->w - 1);
+        break;
+    case 'J': {
+        int m = vt->nparams ? vt->params[0] : 0;
+        if (m == 0) { vt_erase(vt, vt->x, vt->y, s->w); for (int y = vt->y + 1; y < s->h; y++) vt_erase(vt, 0, y, s->w); }
+        if (m == 1) { vt_erase(vt, 0, vt->y, vt->x + 1); for (int y = 0; y < vt->y; y++) vt_erase(vt, 0, y, s->w); }
+        if (m == 2 || m == 3) for (int y = 0; y < s->h; y++) vt_erase(vt, 0, y, s->w);
+        break;
+    }
+    case 'K': {
+        int m = vt->nparams ? vt->params[0] : 0;
+        if (m == 0) vt_erase(vt, vt->x, vt->y, s->w);
+        if (m == 1) vt_erase(vt, 0, vt->y, vt->x + 1);
+        if (m == 2) vt_erase(vt, 0, vt->y, s->w);
+        break;
+    }
+    case 'X': vt_erase(vt, vt->x, vt->y, vt->x + n); break;
+    case '@': vt_shift_chars(vt, n); break;
+    case 'P': vt_shift_chars(vt, -n); break;
+    case 'L': if (vt->y >= vt->top && vt->y <= vt->bot) vt_scroll(vt, vt->y, vt->bot, -n); break;
+    case 'M': if (vt->y >= vt->top && vt->y <= vt->bot) vt_scroll(vt, vt->y, vt->bot, n); break;
+    case 'S': vt_scroll(vt, vt->top, vt->bot, n); break;
+    case 'T': vt_scroll(vt, vt->top, vt->bot, -n); break;
+    case 'b': for (int i = 0; i < n; i++) vt_put(vt, vt->last); break;
+    case 'm': vt_sgr(vt); break;
+    case 'r': {
+        int top = vt_param(vt, 0, 1) - 1, bot = vt_param(vt, 1, s->h) - 1;
+        if (top < bot && bot < s->h) { vt->top = top; vt->bot = bot; }
+        vt->x = vt->y = 0;
+        break;
+    }
+    case 's': vt->save_x = vt->x; vt->save_y = vt->y; vt->save_pen = vt->pen; break;
+    case 'u': vt->x = vt->save_x; vt->y = vt->save_y; vt->pen = vt->save_pen; break;
+    default: break;
+    }
+}
+
+/* ---------- 字节流入口 ---------- */
+static inline void vt_feed(vt_t *vt, const char *buf, int len) {
+    for (int i = 0; i < len; i++) {
+        uint8_t b = (uint8_t)buf[i];
+        switch (vt->state) {
+        case VT_GROUND:
+            if (vt->u8_need) {
+                vt->u8[vt->u8_len++] = b;
+                if (vt->u8_len < vt->u8_need) break;
+                utf8_t u = {{0}, (uint8_t)vt->u8_len, 0};
+                memcpy(u.bytes, vt->u8, vt->u8_len);
+                u.width = utf8_width(u.bytes, u.len);
+                vt->u8_need = 0;
+                vt_put(vt, u);
+                break;
+            }
+            if (b == 0x1b) { vt->state = VT_ESC; break; }
+            if (b == '\r') { vt->x = 0; vt->wrap_pending = 0; break; }
+            if (b == '\n') { vt_linefeed(vt); vt->wrap_pending = 0; break; }
+            if (b == '\b') { if (vt->x > 0) vt->x--; vt->wrap_pending = 0; break; }
+            if (b == '\t') { vt->x = vt_min((vt->x / 8 + 1) * 8, vt->screen->w - 1); break; }
+            if (b < 0x20 || b == 0x7f) break;
+            if (b >= 0x80) {
+                vt->u8[0] = b;
+                vt->u8_len = 1;
+                vt->u8_need = (b & 0xE0) == 0xC0 ? 2 : (b & 0xF0) == 0xE0 ? 3 : (b & 0xF8) == 0xF0 ? 4 : 0;
+                break;
+            }
+            vt_put(vt, (utf8_t){{b}, 1, 1});
+            break;
+
+        case VT_ESC:
+            vt->state = VT_GROUND;
+            if (b == '[') { vt->state = VT_CSI; vt->nparams = 0; vt->priv = 0; memset(vt->params, 0, sizeof(vt->params)); }
+            else if (b == ']') vt->state = VT_OSC;
+            else if (b == '7') { vt->save_x = vt->x; vt->save_y = vt->y; vt->save_pen = vt->pen; }
+            else if (b == '8') { vt->x = vt->save_x; vt->y = vt->save_y; vt->pen = vt->save_pen; }
+            else if (b == 'D') vt_linefeed(vt);
+            else if (b == 'E') { vt->x = 0; vt_linefeed(vt); }
+            else if (b == 'M') { if (vt->y == vt->top) vt_scroll(vt, vt->top, vt->bot, -1); else if (vt->y > 0) vt->y--; }
+            else if (b == 'c') vt_reset(vt);
+            break;
+
+        case VT_CSI:
+            if (b >= '0' && b <= '9') {
+                if (vt->nparams == 0) vt->nparams = 1;
+                int *p = &vt->params[vt->nparams - 1];
+                *p = *p * 10 + (b - '0');
+            } else if (b == ';' || b == ':') {
+                if (vt->nparams == 0) vt->nparams = 1;
+                if (vt->nparams < VT_MAX_PARAMS) vt->nparams++;
+            } else if (b >= 0x3C && b <= 0x3F) {
+                vt->priv = (char)b;
+            } else if (b >= 0x40 && b <= 0x7E) {
+                vt->state = VT_GROUND;
+                vt_csi(vt, (char)b);
+            }
+            break;
+
+        case VT_OSC:
+            if (b == 0x07) vt->state = VT_GROUND;
+            else if (b == 0x1b) vt->state = VT_OSC_ESC;
+            break;
+
+        case VT_OSC_ESC:
+            vt->state = (b == '\\') ? VT_GROUND : VT_OSC;
+            break;
+        }
+    }
+}
+
+/* 取第 y 行的纯文本(不含样式), 返回写入的字节数 */
+static inline int vt_row_text(const vt_t *vt, int y, char *buf, int size) {
+    renderer_t *s = vt->screen;
+    int n = 0;
+    for (int x = 0; x < s->w; x++) {
+        const utf8_t *u = &s->cells[y * s->w + x];
+        if (u->len == 0) continue;
+        if (n + u->len >= size) break;
+        memcpy(buf + n, u->bytes, u->len);
+        n += u->len;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+static inline style_t vt_style_at(const vt_t *vt, int x, int y) {
+    return vt->screen->styles[y * vt->screen->w + x];
+}
+
+#endif /* __VT_H__ */
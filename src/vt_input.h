@@ -0,0 +1,191 @@
+#ifndef __VT_INPUT_H__
+#define __VT_INPUT_H__
+
+#include <string.h>
+#include "term.h"
+
+/* 终端输入解码: 把从 tty 或 socket 读到的字节流解成 TermEvent.
+ * 支持 UTF-8 文本, C0 控制键, CSI/SS3 方向键与编辑键(含修饰键参数), SGR 鼠标(1006),
+ * 以及窗口尺寸报告 CSI 8;rows;cols t. 终端只报告按下, 每个按键产生按下、松开两个事件.
+ * 跨两次读取的不完整序列留到下次; 单独的 ESC 位于一次输入末尾时按 Esc 键处理. */
+
+#define VTI_SEQ_MAX 32      /* 超过这个长度仍未结束的序列当作垃圾丢掉 */
+
+typedef struct {
+    unsigned char buf[VTI_SEQ_MAX];
+    int           len;
+} vti_t;
+
+typedef void (*vti_emit_fn)(void *user, const TermEvent *e);
+
+static inline void vti_key(TermEvent *e, int key_code, int mods) {
+    e->type = TERM_EV_KEY;
+    e->u.key.key_code = key_code;
+    e->u.key.pressed = 1;
+    e->u.key.repeat = 1;
+    /* xterm 修饰键参数: 1 + (shift 1 | alt 2 | ctrl 4) */
+    if (mods > 1) {
+        e->u.key.shift_pressed     = (mods - 1) & 1;
+        e->u.key.left_alt_pressed  = ((mods - 1) >> 1) & 1;
+        e->u.key.left_ctrl_pressed = ((mods - 1) >> 2) & 1;
+    }
+}
+
+static inline int vti_letter_key(unsigned char c) {
+    switch (c) {
+        case 'A': return TERM_KEY_UP;
+        case 'B': return TERM_KEY_DOWN;
+        case 'C': return TERM_KEY_RIGHT;
+        case 'D': return TERM_KEY_LEFT;
+        case 'H': return TERM_KEY_HOME;
+        case 'F': return TERM_KEY_END;
+    }
+    return 0;
+}
+
+static inline int vti_tilde_key(int n) {
+    switch (n) {
+        case 1: case 7: return TERM_KEY_HOME;
+        case 4: case 8: return TERM_KEY_END;
+        case 2: return TERM_KEY_INSERT;
+        case 3: return TERM_KEY_DELETE;
+        case 5: return TERM_KEY_PRIOR;
+        case 6: return TERM_KEY_NEXT;
+    }
+    return 0;
+}
+
+static inline void vti_mouse(TermEvent *e, int b, int x, int y, int release) {
+    TermMouseEvent *m = &e->u.mouse;
+    static const TermMouseEventType down[3] = { TERM_MOUSE_LEFT_DOWN, TERM_MOUSE_MIDDLE_DOWN, TERM_MOUSE_RIGHT_DOWN };
+    static const TermMouseEventType up[3]   = { TERM_MOUSE_LEFT_UP, TERM_MOUSE_MIDDLE_UP, TERM_MOUSE_RIGHT_UP };
+    static const int btn[4] = { 1, 4, 2, 0 };
+    e->type = TERM_EV_MOUSE;
+    m->x = x - 1;
+    m->y = y - 1;
+    m->ctrl = (b >> 4) & 1;
+    if (b & 64) {
+        m->type = TERM_MOUSE_WHEEL;
+        m->wheel = (b & 1) ? -1 : 1;
+    } else if (b & 32) {
+        m->type = TERM_MOUSE_MOVE;
+        m->btn = btn[b & 3];
+    } else if ((b & 3) < 3) {
+        m->type = release ? up[b & 3] : down[b & 3];
+        m->btn = btn[b & 3];
+    } else {
+        m->type = TERM_MOUSE_MOVE;
+    }
+}
+
+/* CSI 序列, p[0..1] 为 "\x1b[" */
+static inline int vti_csi(const unsigned char *p, int n, TermEvent *e) {
+    int params[4] = {0}, np = 0, i = 2;
+    unsigned char priv = 0;
+    if (i < n && (p[i] == '<' || p[i] == '?' || p[i] == '>')) priv = p[i++];
+    for (; i < n; i++) {
+        unsigned char c = p[i];
+        if (c >= '0' && c <= '9') { if (np < 4) params[np] = params[np] * 10 + (c - '0'); }
+        else if (c == ';') np++;
+        else if (c >= 0x40 && c <= 0x7e) break;
+        else if (c < 0x20) return i;    /* 序列里混进控制字符: 丢掉已读部分 */
+    }
+    if (i == n) return n >= VTI_SEQ_MAX ? n : 0;
+    np = np + 1 < 4 ? np + 1 : 4;
+    unsigned char final = p[i];
+    if (priv == '<' && (final == 'M' || final == 'm') && np >= 3) {
+        vti_mouse(e, params[0], params[1], params[2], final == 'm');
+    } else if (priv) {
+        /* 其他私有序列不关心 */
+    } else if (final == '~') {
+        int key = vti_tilde_key(params[0]);
+        if (key) vti_key(e, key, np > 1 ? params[1] : 0);
+    } else if (final == 'Z') {
+        vti_key(e, TERM_KEY_TAB, 2);
+    } else if (final == 't' && params[0] == 8 && np >= 3) {
+        e->type = TERM_EV_RESIZE;
+        e->u.size.rows = params[1];
+        e->u.size.cols = params[2];
+    } else if (vti_letter_key(final)) {
+        vti_key(e, vti_letter_key(final), np > 1 ? params[1] : 0);
+    }
+    return i + 1;
+}
+
+/* 解码一个事件, 返回用掉的字节数, 0 表示序列不完整. 被忽略的序列 e->type 为 TERM_EV_NONE */
+static inline int vti_parse(const unsigned char *p, int n, TermEvent *e) {
+    memset(e, 0, sizeof(*e));
+    if (n <= 0) return 0;
+    unsigned char c = p[0];
+    if (c == 0x1b) {
+        if (n < 2) return 0;
+        if (p[1] == '[') return vti_csi(p, n, e);
+        if (p[1] == 'O') {
+            if (n < 3) return 0;
+            if (vti_letter_key(p[2])) vti_key(e, vti_letter_key(p[2]), 0);
+            return 3;
+        }
+        /* ESC 前缀: Alt + 下一个键 */
+        int k = vti_parse(p + 1, n - 1, e);
+        if (k && e->type == TERM_EV_KEY) e->u.key.left_alt_pressed = 1;
+        return k ? k + 1 : 0;
+    }
+    if (c == '\r' || c == '\n') { vti_key(e, TERM_KEY_RETURN, 0); return 1; }
+    if (c == 0x7f || c == 0x08) { vti_key(e, TERM_KEY_BACK, 0); return 1; }
+    if (c == '\t')              { vti_key(e, TERM_KEY_TAB, 0); return 1; }
+    if (c < 0x20) {
+        vti_key(e, c ? 'A' + c - 1 : ' ', 0);
+        e->u.key.left_ctrl_pressed = 1;
+        return 1;
+    }
+    int len = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+    if (!len) return 1;         /* 非法的首字节 */
+    if (n < len) return 0;
+    vti_key(e, 0, 0);
+    memcpy(e->u.key.utf8, p, len);
+    return len;
+}
+
+static inline void vti_emit(const TermEvent *e, vti_emit_fn emit, void *user) {
+    if (e->type == TERM_EV_NONE) return;
+    emit(user, e);
+    if (e->type == TERM_EV_KEY) {
+        TermEvent up = *e;
+        up.u.key.pressed = 0;
+        emit(user, &up);
+    }
+}
+
+static inline void vti_feed(vti_t *v, const char *data, int len, vti_emit_fn emit, void *user) {
+    const unsigned char *p = (const unsigned char *)data;
+    TermEvent e;
+    /* 先把上次剩下的半截序列补完 */
+    while (v->len && len > 0) {
+        v->buf[v->len++] = *p++;
+        len--;
+        int k = vti_parse(v->buf, v->len, &e);
+        if (k) {
+            vti_emit(&e, emit, user);
+            /* 序列可能比缓冲里的字节短(比如被控制字符打断), 剩下的退回输入 */
+            p -= v->len - k;
+            len += v->len - k;
+            v->len = 0;
+        } else if (v->len == VTI_SEQ_MAX) {
+            v->len = 0;
+        }
+    }
+    while (len > 0) {
+        int k = vti_parse(p, len, &e);
+        if (!k) {
+            if (len == 1 && p[0] == 0x1b) { vti_key(&e, TERM_KEY_ESCAPE, 0); vti_emit(&e, emit, user); return; }
+            memcpy(v->buf, p, len);
+            v->len = len;
+            return;
+        }
+        vti_emit(&e, emit, user);
+        p += k;
+        len -= k;
+    }
+}
+
+#endif /* __VT_INPUT_H__ */
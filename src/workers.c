@@ -0,0 +1,76 @@
+#include "workers.h"
+#include "thread.h"
+
+/* 每轮给每个工作线程发一个 wake, 做完各回一个 done; 多拿到的 wake 只会空跑一遍,
+ * 回的 done 数仍与发出的 wake 数相等, 所以 run 返回时没有线程还在碰本轮的数据. */
+struct workers_t {
+    int              n;
+    thread_t        *threads;
+    sema_t           wake, done;
+    int              quit;
+    workers_fn       fn;
+    void            *user;
+    int              count;
+    volatile atom_t  next;          /* 下一个待领取的下标 */
+};
+
+static void workers_drain(workers_t *w) {
+    for (;;) {
+        int i = (int)atom_add(&w->next, 1);
+        if (i >= w->count) break;
+        w->fn(w->user, i);
+    }
+}
+
+static void workers_thread(void *arg) {
+    workers_t *w = (workers_t *)arg;
+    for (;;) {
+        sema_wait(&w->wake);
+        if (w->quit) break;
+        workers_drain(w);
+        sema_post(&w->done);
+    }
+}
+
+workers_t *workers_new(int threads) {
+    workers_t *w = (workers_t *)calloc(1, sizeof(*w));
+    if (!w) return NULL;
+    if (threads < 1) threads = 1;
+    w->threads = (thread_t *)malloc(threads * sizeof(thread_t));
+    if (!w->threads || sema_init(&w->wake, 0)) { free(w->threads); free(w); return NULL; }
+    if (sema_init(&w->done, 0)) { sema_destroy(&w->wake); free(w->threads); free(w); return NULL; }
+    /* 起不来的线程就少用几个 */
+    w->n = 1;
+    while (w->n < threads && !thread_create(&w->threads[w->n - 1], workers_thread, w)) w->n++;
+    return w;
+}
+
+void workers_free(workers_t *w) {
+    if (!w) return;
+    w->quit = 1;
+    for (int i = 1; i < w->n; i++) sema_post(&w->wake);
+    for (int i = 1; i < w->n; i++) thread_join(w->threads[i - 1]);
+    sema_destroy(&w->wake);
+    sema_destroy(&w->done);
+    free(w->threads);
+    free(w);
+}
+
+int workers_count(workers_t *w) {
+    return w ? w->n : 1;
+}
+
+void workers_run(workers_t *w, int count, workers_fn fn, void *user) {
+    if (!w || w->n == 1 || count <= 1) {
+        for (int i = 0; i < count; i++) fn(user, i);
+        return;
+    }
+    int helpers = count - 1 < w->n - 1 ? count - 1 : w->n - 1;
+    w->fn = fn;
+    w->user = user;
+    w->count = count;
+    atom_store(&w->next, 0);
+    for (int i = 0; i < helpers; i++) sema_post(&w->wake);
+    workers_drain(w);
+    for (int i = 0; i < helpers; i++) sema_wait(&w->done);
+}
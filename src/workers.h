@@ -0,0 +1,15 @@
+#ifndef __WORKERS_H__
+#define __WORKERS_H__
+
+/* 固定大小的线程池, 只做一件事: 把下标 [0, count) 分给各线程并行执行, 全部做完才返回.
+ * 调用线程也参与; 下标按原子计数逐个领取, 各项耗时不均也能摊开. 同一时刻只能有一个调用者. */
+
+typedef struct workers_t workers_t;
+typedef void (*workers_fn)(void *user, int index);
+
+workers_t *workers_new(int threads);        /* 共 threads 个线程(含调用者), 另起 threads-1 个 */
+void workers_free(workers_t *w);
+int  workers_count(workers_t *w);           /* 实际参与的线程数, 含调用者 */
+void workers_run(workers_t *w, int count, workers_fn fn, void *user);
+
+#endif /* __WORKERS_H__ */
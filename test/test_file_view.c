@@ -0,0 +1,80 @@
+#include "../src/minitest.h"
+#include "../src/file_view.h"
+#include "../src/thread.h"
+#include "test_util.h"
+#include <stdio.h>
+
+#define FV_TEST_LINES 100000
+
+static int fv_wait(file_view_t *fv, long long lines) {
+    for (int i = 0; i < 300; i++) {
+        if (!fv_indexing(fv) && fv_lines(fv) == lines) return 1;
+        thread_sleep_ms(10);
+    }
+    return 0;
+}
+
+TEST(test, file_view) {
+    const char *path = "test_file_view.tmp";
+    char buf[64], want[64];
+    FILE *fp = fopen(path, "wb");
+    ASSERT_TRUE(fp != NULL);
+    for (int i = 0; i < FV_TEST_LINES; i++) fprintf(fp, "line %d%s\n", i, i % 3 ? "" : "\r");
+    fclose(fp);
+
+    file_view_t *fv = fv_open(path);
+    ASSERT_TRUE(fv != NULL);
+    ASSERT_TRUE(fv_open("no/such/file") == NULL);
+    ASSERT_TRUE(fv_wait(fv, FV_TEST_LINES));
+    ASSERT_EQ(fv_line(fv, FV_TEST_LINES, buf, sizeof(buf)), -1);
+    for (int i = 0; i < FV_TEST_LINES; i += 997) {
+        sprintf(want, "line %d", i);
+        ASSERT_EQ(fv_line(fv, i, buf, sizeof(buf)), (int)strlen(want));
+        ASSERT_STREQ(buf, want);
+    }
+    /* 截断到缓冲区大小 */
+    ASSERT_EQ(fv_line(fv, 12345, buf, 5), 4);
+    ASSERT_STREQ(buf, "line");
+
+    /* 文件变长: 末尾没有换行的半行也算一行 */
+    fp = fopen(path, "ab");
+    fputs("tail 1\ntail 2", fp);
+    fclose(fp);
+    ASSERT_TRUE(fv_wait(fv, FV_TEST_LINES + 2));
+    fv_line(fv, FV_TEST_LINES + 1, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "tail 2");
+
+    /* 只画可见行, 跳转到指定行 */
+    mu_Context *ctx = test_ctx_new_ex(NULL, test_byte_width);
+    for (int frame = 0; frame < 3; frame++) {
+        if (frame == 0) fv_goto(fv, 50000);
+        mu_begin(ctx);
+        if (mu_begin_window_ex(ctx, "file", mu_rect(0, 0, 40, 12), MU_OPT_NOCLOSE)) {
+            fv_draw(ctx, fv);
+            mu_end_window(ctx);
+        }
+        mu_end(ctx);
+    }
+    int texts = 0, top = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type != MU_COMMAND_TEXT) continue;
+        texts++;
+        if (cmd->text.pos.y == 1 && !strncmp(cmd->text.str, "line ", 5)) top = atoi(cmd->text.str + 5);
+    }
+    ASSERT_TRUE(texts < 20);
+    ASSERT_EQ(top, 50000);
+    ASSERT_EQ(mu_get_container(ctx, "file")->content_size.y, FV_TEST_LINES + 2);
+
+    /* 文件被截断后重建索引 */
+    fp = fopen(path, "wb");
+    fputs("a\nb\n", fp);
+    fclose(fp);
+    ASSERT_TRUE(fv_wait(fv, 2));
+    fv_line(fv, 1, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "b");
+
+    test_ctx_free(ctx);
+    fv_close(fv);
+    remove(path);
+}
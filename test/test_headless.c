@@ -0,0 +1,1262 @@
+#include "../src/minitest.h"
+#include "../src/ui_renderer.h"
+#include "../src/stats.h"
+#include "../src/thread.h"
+#include "../src/timer.h"
+#include "../src/vt_input.h"
+#include "test_util.h"
+
+#ifdef TERM_HEADLESS
+
+static const char *screen_row(int y) {
+    static char buf[512];
+    vt_row_text(term_headless_screen(), y, buf, sizeof(buf));
+    return buf;
+}
+
+static void draw_line(ui_renderer_t *ur, const char *text) {
+    ur_clear(ur, mu_color(0, 0, 0, 0));
+    ur_draw_text(ur, text, mu_vec2(2, 1), mu_color(255, 255, 255, 0));
+}
+
+TEST(test, headless_present) {
+    term_headless_resize(40, 4);
+    ui_renderer_t *ur = ur_new_term();
+
+    draw_line(ur, "hello world");
+    ur_present(ur);
+    ASSERT_STREQ(screen_row(1), "  hello world                           ");
+    ASSERT_EQ(vt_style_at(term_headless_screen(), 2, 1).fg, 0xFFFFFF);
+
+    /* 内容不变时不产生任何输出 */
+    term_headless_reset_stats();
+    draw_line(ur, "hello world");
+    ur_present(ur);
+    ASSERT_EQ(term_headless_stats().bytes, 0);
+    ASSERT_EQ(term_headless_stats().writes, 0);
+
+    /* 行中插入字符: 用 ICH 平移, 只画新字符 */
+    term_headless_reset_stats();
+    draw_line(ur, "hello, world");
+    ur_present(ur);
+    ASSERT_STREQ(screen_row(1), "  hello, world                          ");
+    ASSERT_EQ(term_headless_stats().writes, 1);
+    ASSERT_TRUE(term_headless_stats().bytes < 64);
+
+    /* 删除字符: DCH */
+    draw_line(ur, "hell, world");
+    ur_present(ur);
+    ASSERT_STREQ(screen_row(1), "  hell, world                           ");
+
+    ur_free(ur);
+    term_shutdown();
+}
+
+/* ur_new 的 write 回调: 记下每帧的输出并喂给 vt 模拟器 */
+typedef struct {
+    vt_t *vt;
+    int   writes, bytes;
+    char  last[8192];
+} PresentLog;
+
+static void present_capture(void *user, const char *buf, int len) {
+    PresentLog *pl = (PresentLog *)user;
+    int n = len < (int)sizeof(pl->last) - 1 ? len : (int)sizeof(pl->last) - 1;
+    pl->writes++;
+    pl->bytes += len;
+    memcpy(pl->last, buf, n);
+    pl->last[n] = '\0';
+    vt_feed(pl->vt, buf, len);
+}
+
+static void present_reset(PresentLog *pl) {
+    pl->writes = pl->bytes = 0;
+    pl->last[0] = '\0';
+}
+
+/* vt 屏幕与渲染缓冲显示效果一致: 字相同, 背景相同, 非空格的前景相同 */
+static int present_same(vt_t *vt, renderer_t *r) {
+    for (int i = 0; i < r->w * r->h; i++) {
+        style_t s = vt_style_at(vt, i % r->w, i / r->w), want = r->styles[i];
+        if (utf8_cmp(vt->screen->cells[i], r->cells[i]) || s.bg != want.bg) return 0;
+        if (r->cells[i].bytes[0] != ' ' && s.fg != want.fg) return 0;
+    }
+    return 1;
+}
+
+/* 每行一种背景色, 文字白色; 偶数行右边有一段高亮背景(平移整行不再划算), 位移补出的空白格要取对颜色 */
+static void present_rows(ui_renderer_t *ur, char rows[][64], int h) {
+    ur_clear(ur, mu_color(0, 0, 0, 0));
+    for (int y = 0; y < h; y++) {
+        ur_draw_rect(ur, mu_rect(0, y, 40, 1), mu_color(0, 0, 40 * y, 0));
+        if (y % 2 == 0) ur_draw_rect(ur, mu_rect(30, y, 6, 1), mu_color(90, 0, 0, 0));
+        ur_draw_text(ur, rows[y], mu_vec2(0, y), mu_color(255, 255, 255, 0));
+    }
+}
+
+TEST(test, present_diff) {
+    PresentLog pl = { .vt = vt_new(40, 6) };
+    ui_renderer_t *ur = ur_new(40, 6, present_capture, &pl);
+    renderer_t *r = ur_get_renderer(ur);
+
+    /* 首帧: 先清屏, 整帧一次 write; 写到最后一格也不换行滚屏 */
+    vt_feed(pl.vt, "stale screen", 12);
+    ur_clear(ur, mu_color(0, 0, 0, 0));
+    ur_draw_text(ur, "top", mu_vec2(0, 0), mu_color(255, 255, 255, 0));
+    ur_draw_text(ur, "bottom right", mu_vec2(28, 5), mu_color(255, 255, 255, 0));
+    ur_present(ur);
+    ASSERT_EQ(pl.writes, 1);
+    ASSERT_EQ(strncmp(pl.last, "\x1b[0m\x1b[2J", 8), 0);
+    ASSERT_TRUE(strchr(pl.last, '\n') == NULL);
+    ASSERT_TRUE(present_same(pl.vt, r));
+
+    /* 格子 (x, y) 输出到终端第 y+1 行第 x+1 列, 点在那里的鼠标事件解码回同一个 (x, y) */
+    present_reset(&pl);
+    ur_draw_text(ur, "X", mu_vec2(7, 3), mu_color(255, 255, 255, 0));
+    ur_present(ur);
+    ASSERT_TRUE(strstr(pl.last, "\x1b[4;8H") != NULL);
+    TermEvent e = { 0 };
+    ASSERT_TRUE(vti_parse((const unsigned char *)"\x1b[<0;8;4M", 10, &e) > 0);
+    ASSERT_EQ(e.u.mouse.x, 7);
+    ASSERT_EQ(e.u.mouse.y, 3);
+    ASSERT_EQ(vt_row_text(pl.vt, 3, pl.last, sizeof(pl.last)) > 7 && pl.last[7] == 'X', 1);
+
+    /* 插入宽字符: ICH 平移两列; 删除: DCH; 右边平移过去的文字不再重画 */
+    char rows[6][64] = { "alpha beta gamma", "one two three four five", "", "wide 中文 text", "x", "tail" };
+    present_rows(ur, rows, 6);
+    ur_present(ur);
+    present_reset(&pl);
+    strcpy(rows[1], "one 中two three four five");
+    present_rows(ur, rows, 6);
+    ur_present(ur);
+    ASSERT_EQ(pl.writes, 1);
+    ASSERT_TRUE(strstr(pl.last, "\x1b[2@") != NULL);
+    ASSERT_TRUE(strstr(pl.last, "two") == NULL);
+    ASSERT_TRUE(present_same(pl.vt, r));
+    present_reset(&pl);
+    strcpy(rows[3], "wide text");
+    present_rows(ur, rows, 6);
+    ur_present(ur);
+    ASSERT_TRUE(strstr(pl.last, "\x1b[5P") != NULL);
+    ASSERT_TRUE(strstr(pl.last, "text") == NULL);
+    ASSERT_TRUE(present_same(pl.vt, r));
+
+    /* 随机在行中插入、删除(含宽字符, 跨越高亮段), 终端画面始终与缓冲一致 */
+    static const char *pieces[] = { "a", "bc", "中", "文字", " ", "xyz " };
+    unsigned seed = 1;
+    for (int step = 0; step < 400; step++) {
+        seed = seed * 1103515245 + 12345;
+        char *row = rows[(seed >> 8) % 6];
+        int len = (int)strlen(row), at = (int)((seed >> 12) % (len + 1));
+        while (at > 0 && ((unsigned char)row[at] & 0xC0) == 0x80) at--;
+        if ((seed >> 20) & 1 && len > 0) {
+            int end = at;
+            do end++; while (end < len && ((unsigned char)row[end] & 0xC0) == 0x80);
+            if (end > len) end = len;
+            memmove(row + at, row + end, len - end + 1);
+        } else {
+            const char *p = pieces[(seed >> 24) % 6];
+            int n = (int)strlen(p);
+            if (r_get_text_width(row, len) + r_get_text_width(p, n) > 38) continue;
+            memmove(row + at + n, row + at, len - at + 1);
+            memcpy(row + at, p, n);
+        }
+        present_reset(&pl);
+        present_rows(ur, rows, 6);
+        ur_present(ur);
+        ASSERT_TRUE(pl.writes <= 1);
+        ASSERT_TRUE(present_same(pl.vt, r));
+    }
+
+    /* 改变尺寸后重新清屏, 按新尺寸整屏输出 */
+    vt_free(pl.vt);
+    pl.vt = vt_new(30, 5);
+    ASSERT_EQ(ur_resize(ur, 30, 5), 0);
+    r = ur_get_renderer(ur);
+    present_reset(&pl);
+    present_rows(ur, rows, 5);
+    ur_present(ur);
+    ASSERT_EQ(pl.writes, 1);
+    ASSERT_EQ(strncmp(pl.last, "\x1b[0m\x1b[2J", 8), 0);
+    ASSERT_TRUE(present_same(pl.vt, r));
+
+    ur_free(ur);
+    vt_free(pl.vt);
+}
+
+TEST(test, headless_input) {
+    static int clicks = 0;
+    mu_Context *ctx = test_ctx_new(NULL);
+    term_headless_resize(40, 10);
+    ui_renderer_t *ur = ur_new_term();
+    while (term_headless_pending()) term_poll_event();  /* 丢弃之前测试留下的 resize 事件 */
+
+    /* 脚本输入: 移到按钮上(悬停需要一帧生效), 按下再抬起 */
+    term_headless_push_mouse(TERM_MOUSE_MOVE, 5, 1, 0);
+    term_headless_push_mouse(TERM_MOUSE_MOVE, 5, 1, 0);
+    term_headless_push_mouse(TERM_MOUSE_LEFT_DOWN, 5, 1, 1);
+    term_headless_push_mouse(TERM_MOUSE_LEFT_UP, 5, 1, 0);
+
+    for (int frame = 0; frame < 5; frame++) {
+        TermEvent e = term_poll_event();
+        if (e.type == TERM_EV_MOUSE) {
+            if (e.u.mouse.type == TERM_MOUSE_MOVE)      mu_input_mousemove(ctx, e.u.mouse.x, e.u.mouse.y);
+            if (e.u.mouse.type == TERM_MOUSE_LEFT_DOWN) mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT);
+            if (e.u.mouse.type == TERM_MOUSE_LEFT_UP)   mu_input_mouseup(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT);
+        }
+        mu_begin(ctx);
+        if (mu_begin_window_ex(ctx, "win", mu_rect(0, 0, 30, 6), MU_OPT_NOCLOSE)) {
+            mu_layout_row(ctx, 1, (int[]){-1}, 0);
+            if (mu_button(ctx, "Click")) clicks++;
+            mu_end_window(ctx);
+        }
+        mu_end(ctx);
+
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        mu_Command *cmd = NULL;
+        while (mu_next_command(ctx, &cmd)) {
+            switch (cmd->type) {
+                case MU_COMMAND_TEXT: ur_draw_text(ur, cmd->text.str, cmd->text.pos, cmd->text.color); break;
+                case MU_COMMAND_RECT: ur_draw_rect(ur, cmd->rect.rect, cmd->rect.color); break;
+                case MU_COMMAND_ICON: ur_draw_icon(ur, cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
+                case MU_COMMAND_CLIP: ur_set_clip_rect(ur, cmd->clip.rect); break;
+            }
+        }
+        ur_present(ur);
+    }
+
+    ASSERT_EQ(term_headless_pending(), 0);
+    ASSERT_EQ(clicks, 1);
+    ASSERT_TRUE(strstr(screen_row(0), "win") != NULL);
+    ASSERT_TRUE(strstr(screen_row(1), "Click") != NULL);
+
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(ctx);
+}
+
+static void push_later(void *arg) {
+    thread_sleep_ms(20);
+    term_headless_push_mouse(TERM_MOUSE_MOVE, (int)(size_t)arg, 0, 0);
+}
+
+TEST(test, input_thread) {
+    term_init();
+    while (term_headless_pending()) term_poll_event();
+    term_input_t *in = term_input_start(NULL, NULL);
+    ASSERT_TRUE(in != NULL);
+
+    /* 一次粘贴远超队列容量: 输入线程等待消费, 事件不丢, 顺序不变 */
+    enum { N = TERM_INPUT_SLOTS * 2 + 100 };
+    long long t0 = timer_ns();
+    TermEvent k = { .type = TERM_EV_KEY };
+    k.u.key.pressed = 1;
+    for (int i = 0; i < N; i++) {
+        k.u.key.repeat = i;
+        term_headless_push(k);
+    }
+    while (!term_input_stalls(in)) thread_sleep_ms(1);    /* 队列满了才开始取 */
+    long long last = t0;
+    for (int i = 0; i < N; ) {
+        long long t;
+        TermEvent e = term_input_poll(in, &t);
+        if (e.type == TERM_EV_NONE) { thread_sleep_ms(1); continue; }
+        ASSERT_EQ(e.u.key.repeat, i);
+        ASSERT_TRUE(t >= last);
+        last = t;
+        i++;
+    }
+
+    /* 时间戳取自读入时刻, 而不是 UI 线程取出的时刻 */
+    long long pushed = timer_ns();
+    term_headless_push_mouse(TERM_MOUSE_MOVE, 3, 4, 0);
+    while (term_headless_pending()) thread_sleep_ms(1);
+    thread_sleep_ms(20);
+    long long t = 0;
+    TermEvent e;
+    while ((e = term_input_poll(in, &t)).type == TERM_EV_NONE) thread_sleep_ms(1);
+    ASSERT_EQ(e.u.mouse.x, 3);
+    ASSERT_TRUE(t >= pushed);
+    ASSERT_TRUE(timer_ns() - t >= 20000000LL);
+
+    /* 停止后直接读终端 */
+    term_input_stop(in);
+    term_headless_push_mouse(TERM_MOUSE_MOVE, 7, 1, 0);
+    ASSERT_EQ(term_input_poll(in, NULL).u.mouse.x, 7);
+    ASSERT_EQ(term_input_poll(in, NULL).type, TERM_EV_NONE);
+    term_input_free(in);
+
+    /* 没有事件时读取方在条件变量上等, 写入后立即醒来, 不靠轮询间隔 */
+    TermEvent got[1];
+    long long t1 = timer_ns();
+    ASSERT_EQ(term_read_events(got, 1, 30), 0);
+    ASSERT_TRUE(timer_ns() - t1 >= 25000000LL);
+    thread_t th;
+    ASSERT_EQ(thread_create(&th, push_later, (void *)(size_t)9), 0);
+    t1 = timer_ns();
+    ASSERT_EQ(term_read_events(got, 1, 5000), 1);
+    ASSERT_EQ(got[0].u.mouse.x, 9);
+    ASSERT_TRUE(timer_ns() - t1 < 2000000000LL);
+    thread_join(th);
+}
+
+static void hash_frame(mu_Context *ctx, const char *label) {
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "win", mu_rect(0, 0, 30, 6), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        mu_button(ctx, "Click");
+        mu_label(ctx, label);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+TEST(test, frame_hash) {
+    mu_Context *ctx = test_ctx_new(NULL);
+
+    hash_frame(ctx, "a");
+    ASSERT_TRUE(mu_frame_changed(ctx));
+    hash_frame(ctx, "a");
+    ASSERT_TRUE(!mu_frame_changed(ctx));
+
+    /* 鼠标在无交互区域移动: 命令不变 */
+    mu_input_mousemove(ctx, 50, 20);
+    hash_frame(ctx, "a");
+    hash_frame(ctx, "a");
+    ASSERT_TRUE(!mu_frame_changed(ctx));
+
+    /* 悬停按钮改变颜色 (移动后的第一帧就生效), 文本改变, 都算变化 */
+    mu_input_mousemove(ctx, 5, 1);
+    hash_frame(ctx, "a");
+    ASSERT_TRUE(mu_frame_changed(ctx));
+    hash_frame(ctx, "a");
+    ASSERT_TRUE(!mu_frame_changed(ctx));
+    hash_frame(ctx, "b");
+    ASSERT_TRUE(mu_frame_changed(ctx));
+
+    test_ctx_free(ctx);
+}
+
+/* 按 z 序逐个根容器重放命令, 不透明窗口先清掉所盖住的格子 */
+static void replay(ui_renderer_t *ur, mu_Context *ctx) {
+    renderer_t *r = ur_get_renderer(ur);
+    for (int i = 0; i < ctx->root_list.idx; i++) {
+        mu_Container *cnt = ctx->root_list.items[i];
+        for (int y = cnt->rect.y; cnt->opaque && y < cnt->rect.y + cnt->rect.h; y++)
+        for (int x = cnt->rect.x; x < cnt->rect.x + cnt->rect.w; x++) {
+            if (x < 0 || y < 0 || x >= r->w || y >= r->h) continue;
+            r->cells[y * r->w + x] = (utf8_t){" ", 1, 1};
+            r->styles[y * r->w + x] = (style_t){.fg=-1, .bg=-1, .raw=0};
+        }
+        ur_set_clip_rect(ur, mu_rect(0, 0, r->w, r->h));
+        mu_Command *cmd = (mu_Command *)((char *)cnt->head + sizeof(mu_JumpCommand));
+        while (cmd != cnt->tail) {
+            switch (cmd->type) {
+                case MU_COMMAND_JUMP: cmd = cmd->jump.dst; continue;
+                case MU_COMMAND_TEXT: ur_draw_text(ur, cmd->text.str, cmd->text.pos, cmd->text.color); break;
+                case MU_COMMAND_RECT: ur_draw_rect(ur, cmd->rect.rect, cmd->rect.color); break;
+                case MU_COMMAND_ICON: ur_draw_icon(ur, cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
+                case MU_COMMAND_CLIP: ur_set_clip_rect(ur, cmd->clip.rect); break;
+            }
+            cmd = (mu_Command *)((char *)cmd + cmd->base.size);
+        }
+    }
+}
+
+static void cache_scene(mu_Context *ctx, int frame) {
+    char buf[32];
+    mu_begin(ctx);
+    for (int i = 0; i < 4; i++) {
+        sprintf(buf, "w%d", i);
+        /* 第 3 帧起 w1 移动; 窗口互相重叠 */
+        mu_Rect r = mu_rect(i * 8 + (i == 1 && frame >= 3 ? frame : 0), i * 2, 20, 8);
+        if (mu_begin_window_ex(ctx, buf, r, MU_OPT_NOCLOSE)) {
+            if (i == 1 && frame >= 3) mu_get_current_container(ctx)->rect = r;
+            mu_layout_row(ctx, 1, (int[]){-1}, 0);
+            sprintf(buf, "n=%d", i == 2 ? frame : 0);
+            mu_label(ctx, buf);
+            mu_label(ctx, "a long label clipped by the window 世界");
+            if (mu_begin_treenode_ex(ctx, "node", MU_OPT_EXPANDED)) {
+                mu_button(ctx, "btn");
+                mu_end_treenode(ctx);
+            }
+            /* 内嵌根容器 */
+            if (i == 3 && mu_begin_window_ex(ctx, "inner", mu_rect(2, 12, 10, 4), MU_OPT_NOCLOSE)) {
+                mu_label(ctx, frame & 1 ? "odd" : "even");
+                mu_end_window(ctx);
+            }
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+TEST(test, raster_cache) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    term_headless_resize(50, 20);
+    ui_renderer_t *ur = ur_new_term();
+    ur_set_cache(ur, 1);
+
+    renderer_t *r = ur_get_renderer(ur);
+    int n = r->w * r->h;
+    utf8_t  *cells  = malloc(n * sizeof(utf8_t));
+    style_t *styles = malloc(n * sizeof(style_t));
+    for (int frame = 0; frame < 8; frame++) {
+        cache_scene(ctx, frame);
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        ur_draw_commands(ur, ctx);
+        memcpy(cells, r->cells, n * sizeof(utf8_t));
+        memcpy(styles, r->styles, n * sizeof(style_t));
+
+        /* 不走缓存直接重放, 结果必须逐格一致 */
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        replay(ur, ctx);
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(utf8_cmp(cells[i], r->cells[i]), 0);
+            ASSERT_EQ(style_cmp(styles[i], r->styles[i]), 0);
+        }
+    }
+
+    /* 静止的窗口应命中缓存 */
+    stats_enable(1);
+    cache_scene(ctx, 8);
+    ur_draw_commands(ur, ctx);
+    cache_scene(ctx, 9);
+    ASSERT_TRUE(stats_last()->cache_hits >= 2);
+    stats_enable(0);
+
+    free(cells);
+    free(styles);
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(ctx);
+}
+
+static void pool_scene(mu_Context *ctx, int windows) {
+    char buf[32];
+    mu_begin(ctx);
+    for (int i = 0; i < windows; i++) {
+        sprintf(buf, "w%d", i);
+        if (mu_begin_window_ex(ctx, buf, mu_rect(i % 40, i % 20, 20, 8), MU_OPT_NOCLOSE))
+            mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+TEST(test, container_pool) {
+    mu_Context *ctx = test_ctx_new(&(mu_Config){ .container_pool_size = 8, .treenode_pool_size = 8 });
+
+    /* 一帧内超过初始容量: 池按需扩大, 已有容器指针不变 */
+    pool_scene(ctx, 1);
+    mu_Container *first = mu_get_container(ctx, "w0");
+    pool_scene(ctx, 30);
+    ASSERT_EQ(ctx->root_list.idx, 30);
+    ASSERT_TRUE(ctx->container_pool.cap >= 30);
+    ASSERT_TRUE(mu_get_container(ctx, "w0") == first);
+
+    /* 根容器按 zindex 排序 */
+    for (int i = 1; i < ctx->root_list.idx; i++)
+        ASSERT_TRUE(ctx->root_list.items[i - 1]->zindex < ctx->root_list.items[i]->zindex);
+    mu_bring_to_front(ctx, first);
+    pool_scene(ctx, 30);
+    ASSERT_TRUE(ctx->root_list.items[ctx->root_list.idx - 1] == first);
+
+    /* 不再使用的容器被 LRU 复用, 池不再扩大 */
+    int cap = ctx->container_pool.cap;
+    for (int f = 0; f < 4; f++) {
+        char buf[32];
+        mu_begin(ctx);
+        for (int i = 0; i < 25; i++) {
+            sprintf(buf, "f%d-%d", f, i);
+            if (mu_begin_window(ctx, buf, mu_rect(0, 0, 10, 5))) mu_end_window(ctx);
+        }
+        mu_end(ctx);
+    }
+    ASSERT_EQ(ctx->container_pool.cap, cap);
+    ASSERT_TRUE(mu_get_container(ctx, "f3-24") != NULL);
+    ASSERT_EQ(ctx->root_list.idx, 25);
+
+    /* 直接操作池: 同帧插入超过容量, 删除一半后其余仍可查到 */
+    mu_Pool *pool = &ctx->treenode_pool;
+    for (int i = 0; i < 100; i++) {
+        int idx = mu_pool_init(ctx, pool, mu_get_id(ctx, &i, sizeof(i)));
+        ASSERT_EQ(mu_pool_get(ctx, pool, mu_get_id(ctx, &i, sizeof(i))), idx);
+    }
+    ASSERT_TRUE(pool->cap >= 100);
+    for (int i = 0; i < 100; i += 2)
+        mu_pool_remove(ctx, pool, mu_pool_get(ctx, pool, mu_get_id(ctx, &i, sizeof(i))));
+    for (int i = 0; i < 100; i++) {
+        int idx = mu_pool_get(ctx, pool, mu_get_id(ctx, &i, sizeof(i)));
+        ASSERT_TRUE(i & 1 ? idx >= 0 : idx == -1);
+    }
+
+    test_ctx_free(ctx);
+}
+
+static void deep_scene(mu_Context *ctx, int windows) {
+    char buf[32];
+    mu_begin(ctx);
+    for (int i = 0; i < windows; i++) {
+        sprintf(buf, "w%d", i);
+        if (mu_begin_window_ex(ctx, buf, mu_rect(i % 40, i % 20, 20, 8), MU_OPT_NOCLOSE)) {
+            /* 嵌套深度超过所有栈的初始容量 */
+            for (int d = 0; d < 40; d++) { mu_push_id(ctx, &d, sizeof(d)); mu_layout_begin_column(ctx); }
+            mu_label(ctx, buf);
+            for (int d = 0; d < 40; d++) { mu_layout_end_column(ctx); mu_pop_id(ctx); }
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+TEST(test, context_growth) {
+    mu_Context *big = test_ctx_new(NULL);
+    /* 极小的初始容量: 命令列表分块, 栈按需扩大 */
+    mu_Context *small = test_ctx_new(&(mu_Config){ .container_pool_size = 1, .command_list_size = 64, .root_list_size = 1,
+        .container_stack_size = 1, .clip_stack_size = 1, .id_stack_size = 1, .layout_stack_size = 1 });
+
+    for (int frame = 0; frame < 3; frame++) {
+        deep_scene(big, 100);
+        deep_scene(small, 100);
+        ASSERT_EQ(small->root_list.idx, 100);
+        ASSERT_TRUE(small->container_chunk_count >= 8);     /* 容器按块分配, 块表也按需扩大 */
+        ASSERT_TRUE(small->command_list.first->next != NULL);
+        ASSERT_EQ(small->frame_hash, big->frame_hash);
+
+        /* 两边的命令流逐条相同 */
+        mu_Command *a = NULL, *b = NULL;
+        int n = 0;
+        for (;;) {
+            int ra = mu_next_command(big, &a), rb = mu_next_command(small, &b);
+            ASSERT_EQ(ra, rb);
+            if (!ra) break;
+            ASSERT_EQ(a->type, b->type);
+            if (a->type == MU_COMMAND_TEXT) {
+                ASSERT_STREQ(a->text.str, b->text.str);
+                ASSERT_EQ(memcmp(&a->text.pos, &b->text.pos, sizeof(mu_Vec2)), 0);
+            } else if (a->type == MU_COMMAND_CLIP) {
+                ASSERT_EQ(memcmp(&a->clip.rect, &b->clip.rect, sizeof(mu_Rect)), 0);
+            } else if (a->type == MU_COMMAND_RECT) {
+                ASSERT_EQ(memcmp(&a->rect.rect, &b->rect.rect, sizeof(mu_Rect)), 0);
+            }
+            n++;
+        }
+        ASSERT_TRUE(n > 100);
+    }
+
+    test_ctx_free(big);
+    test_ctx_free(small);
+}
+
+static int list_scene(mu_Context *ctx, int count, int scroll, int clipped) {
+    char buf[32];
+    int drawn = 0;
+    mu_get_container(ctx, "list")->scroll.y = scroll;
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "list", mu_rect(0, 0, 30, 12), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        mu_label(ctx, "header");
+        mu_layout_row(ctx, 2, (int[]){8, -1}, 0);
+        mu_ListClipper lc = { .start = 0, .end = count };
+        if (clipped) mu_layout_begin_list(ctx, &lc, count, 0);
+        for (int i = lc.start; i < lc.end; i++) {
+            sprintf(buf, "%d", i);
+            mu_label(ctx, buf);
+            mu_label(ctx, "row");
+            drawn++;
+        }
+        if (clipped) mu_layout_end_list(ctx, &lc);
+        mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        mu_label(ctx, "footer");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    return drawn;
+}
+
+TEST(test, list_clipper) {
+    mu_Context *a = test_ctx_new(NULL);
+    mu_Context *b = test_ctx_new(NULL);
+
+    term_headless_resize(32, 14);
+    ui_renderer_t *ur = ur_new_term();
+    ur_set_cache(ur, 0);
+    renderer_t *r = ur_get_renderer(ur);
+    int n = r->w * r->h;
+    utf8_t *cells = malloc(n * sizeof(utf8_t));
+
+    /* 与逐行调用的结果一致: 画面, 内容尺寸 */
+    int scrolls[] = { 0, 1, 7, 100, 188, 190, 1000 };
+    for (int k = 0; k < 7; k++) {
+        for (int f = 0; f < 2; f++) {
+            list_scene(a, 200, scrolls[k], 0);
+            list_scene(b, 200, scrolls[k], 1);
+        }
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        ur_draw_commands(ur, a);
+        memcpy(cells, r->cells, n * sizeof(utf8_t));
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        ur_draw_commands(ur, b);
+        for (int i = 0; i < n; i++) ASSERT_EQ(utf8_cmp(cells[i], r->cells[i]), 0);
+        ASSERT_EQ(mu_get_container(a, "list")->content_size.y, mu_get_container(b, "list")->content_size.y);
+        ASSERT_EQ(mu_get_container(a, "list")->content_size.x, mu_get_container(b, "list")->content_size.x);
+    }
+
+    /* 大数据量: 只有可见行执行控件代码 */
+    list_scene(b, 100000, 50000, 1);
+    ASSERT_TRUE(list_scene(b, 100000, 50000, 1) <= 11 + 2);    /* 可见 11 行, 加上下边界各一行 */
+    ASSERT_EQ(mu_get_container(b, "list")->content_size.y, 100000 + 2);
+    ASSERT_EQ(list_scene(b, 0, 0, 1), 0);
+
+    ur_set_cache(ur, 1);
+    free(cells);
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(a);
+    test_ctx_free(b);
+}
+
+static int idle_scene(mu_Context *ctx, int animate) {
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "idle", mu_rect(0, 0, 30, 10), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){10}, 0);
+        mu_button(ctx, "b1");
+        if (animate) mu_request_frame(ctx);
+        mu_end_window(ctx);
+    }
+    return mu_end(ctx);
+}
+
+/* 跑到不再需要新的一帧为止, 返回跑了几帧 */
+static int idle_settle(mu_Context *ctx) {
+    int n = 1;
+    while (idle_scene(ctx, 0) && n < 10) n++;
+    return n;
+}
+
+TEST(test, needs_frame) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    term_headless_resize(40, 12);
+    ui_renderer_t *ur = ur_new_term();
+
+    ASSERT_TRUE(mu_needs_frame(ctx));
+    ASSERT_TRUE(idle_settle(ctx) <= 3);     /* 先定下悬停窗口, 再定下悬停控件 */
+    ASSERT_TRUE(!mu_needs_frame(ctx));
+
+    /* 移出标题栏会改变悬停, 之后在空白处移动不需要新帧 */
+    ASSERT_TRUE(mu_input_mousemove(ctx, 20, 5));
+    ASSERT_TRUE(idle_settle(ctx) <= 3);
+    ASSERT_TRUE(!mu_input_mousemove(ctx, 21, 6));
+    ASSERT_TRUE(!mu_input_mousemove(ctx, 15, 3));
+    ASSERT_TRUE(!mu_needs_frame(ctx));
+
+    /* 移到按钮上: 输入和 mu_end 都报告需要新帧, 悬停稳定后不再需要 */
+    ASSERT_TRUE(mu_input_mousemove(ctx, 2, 1));
+    ASSERT_TRUE(idle_scene(ctx, 0));
+    ASSERT_TRUE(idle_settle(ctx) <= 2);
+    ASSERT_TRUE(ctx->hover != 0);
+    ASSERT_TRUE(!mu_input_mousemove(ctx, 3, 1));
+
+    /* 没有焦点时按键和文字也要新帧(可能是全局快捷键), 这一帧就把它们用掉; 松键、零滚动不需要 */
+    ASSERT_TRUE(mu_input_keydown(ctx, MU_KEY_BACKSPACE));
+    ASSERT_EQ(ctx->key_pressed, MU_KEY_BACKSPACE);
+    idle_settle(ctx);
+    ASSERT_EQ(ctx->key_pressed, 0);
+    ASSERT_TRUE(!mu_input_keyup(ctx, MU_KEY_BACKSPACE));
+    ASSERT_TRUE(mu_input_text(ctx, "x"));
+    idle_settle(ctx);
+    ASSERT_STREQ(ctx->input_text, "");
+    ASSERT_TRUE(!mu_input_scroll(ctx, 0, 0));
+    ASSERT_TRUE(mu_input_scroll(ctx, 0, 1));
+    ASSERT_TRUE(mu_input_mousemove(ctx, 3, 1));     /* 位置没变也报告已有的需要 */
+    ASSERT_TRUE(idle_settle(ctx) <= 2);
+
+    /* 拖动标题栏: 按住期间每次移动都需要新帧 */
+    ASSERT_TRUE(mu_input_mousemove(ctx, 5, 0));
+    idle_settle(ctx);
+    ASSERT_TRUE(mu_input_mousedown(ctx, 5, 0, MU_MOUSE_LEFT));
+    idle_scene(ctx, 0);
+    ASSERT_TRUE(mu_input_mousemove(ctx, 6, 0));
+    ASSERT_TRUE(idle_scene(ctx, 0));
+    ASSERT_TRUE(mu_input_mouseup(ctx, 6, 0, MU_MOUSE_LEFT));
+    ASSERT_TRUE(idle_settle(ctx) <= 3);
+    ASSERT_EQ(mu_get_container(ctx, "idle")->rect.x, 1);
+
+    /* 控件请求动画 */
+    ASSERT_TRUE(idle_scene(ctx, 1));
+    ASSERT_TRUE(mu_needs_frame(ctx));
+    ASSERT_TRUE(!idle_scene(ctx, 0));
+
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(ctx);
+}
+
+static char g_edit[32];
+
+static int edit_scene(mu_Context *ctx) {
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "edit", mu_rect(0, 0, 30, 10), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 1, (int[]){20}, 0);
+        mu_textbox(ctx, g_edit, sizeof(g_edit));
+        mu_end_window(ctx);
+    }
+    return mu_end(ctx);
+}
+
+/* 像主循环那样只在需要时跑帧 */
+static void edit_run(mu_Context *ctx, int need) {
+    for (int n = 0; need && n < 10; n++) need = edit_scene(ctx);
+}
+
+/* 没有焦点时打的字当帧用掉, 不会留给之后获得焦点的输入框 */
+TEST(test, unfocused_text) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    g_edit[0] = '\0';
+    edit_run(ctx, 1);
+    ASSERT_EQ(ctx->focus, 0);
+
+    /* 鼠标先停在输入框上, 再打字, 最后点击 */
+    edit_run(ctx, mu_input_mousemove(ctx, 3, 1));
+    ASSERT_TRUE(ctx->hover != 0);
+    edit_run(ctx, mu_input_text(ctx, "x"));
+    edit_run(ctx, mu_input_text(ctx, "y"));
+    edit_run(ctx, mu_input_keydown(ctx, MU_KEY_BACKSPACE));
+    edit_run(ctx, mu_input_keyup(ctx, MU_KEY_BACKSPACE));
+    edit_run(ctx, mu_input_text(ctx, "z"));
+    edit_run(ctx, mu_input_mousedown(ctx, 3, 1, MU_MOUSE_LEFT));
+    edit_run(ctx, mu_input_mouseup(ctx, 3, 1, MU_MOUSE_LEFT));
+    ASSERT_TRUE(ctx->focus != 0);
+    ASSERT_STREQ(g_edit, "");
+
+    edit_run(ctx, mu_input_text(ctx, "a"));
+    ASSERT_STREQ(g_edit, "a");
+    test_ctx_free(ctx);
+}
+
+static void glyph_scene(mu_Context *ctx) {
+    static int check = 1;
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "glyphs", mu_rect(1, 1, 24, 10), 0)) {
+        mu_label(ctx, "Hello 世界🌍🚀");
+        mu_label(ctx, "a label that is much wider than the window");
+        mu_checkbox(ctx, "check", &check);
+        if (mu_begin_treenode(ctx, "node")) {
+            mu_text(ctx, "wrapped text that spans lines 中文换行");
+            mu_end_treenode(ctx);
+        }
+        mu_begin_treenode(ctx, "closed");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+TEST(test, glyph_commands) {
+    mu_Context *a = test_ctx_new(NULL);
+    mu_Context *b = test_ctx_new(NULL);
+    b->text_glyphs = r_text_glyphs;
+    b->glyph_size = sizeof(utf8_t);
+
+    term_headless_resize(32, 14);
+    ui_renderer_t *ur = ur_new_term();
+    renderer_t *r = ur_get_renderer(ur);
+    int n = r->w * r->h;
+    utf8_t *cells = malloc(n * sizeof(utf8_t));
+    style_t *styles = malloc(n * sizeof(style_t));
+
+    /* 与逐字节解码的文本命令画出完全相同的格子, 有无根容器缓存都一样 */
+    for (int cache = 0; cache < 2; cache++) {
+        ur_set_cache(ur, cache);
+        for (int f = 0; f < 3; f++) {
+            glyph_scene(a);
+            glyph_scene(b);
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, a);
+            memcpy(cells, r->cells, n * sizeof(utf8_t));
+            memcpy(styles, r->styles, n * sizeof(style_t));
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, b);
+            for (int i = 0; i < n; i++) {
+                ASSERT_EQ(utf8_cmp(cells[i], r->cells[i]), 0);
+                ASSERT_EQ(memcmp(&styles[i], &r->styles[i], sizeof(style_t)), 0);
+            }
+        }
+    }
+
+    /* 文本全部以字形命令下发, 宽度已算好; 帧不变时哈希也不变 */
+    int glyphs = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(b, &cmd)) {
+        ASSERT_TRUE(cmd->type != MU_COMMAND_TEXT);
+        if (cmd->type != MU_COMMAND_GLYPHS) continue;
+        glyphs++;
+        const utf8_t *g = (const utf8_t *)cmd->glyphs.glyphs;
+        if (g[0].bytes[0] == 'H') {
+            ASSERT_EQ(cmd->glyphs.count, 10);
+            ASSERT_EQ(cmd->glyphs.width, 14);
+        }
+    }
+    ASSERT_TRUE(glyphs >= 5);     /* 零宽裁剪区里的 "check" 不再生成命令 */
+    glyph_scene(b);
+    ASSERT_TRUE(!mu_frame_changed(b));
+
+    free(cells);
+    free(styles);
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(a);
+    test_ctx_free(b);
+}
+
+static int g_back_runs;
+
+static void cull_scene(mu_Context *ctx, int front) {
+    mu_begin(ctx);
+    const char *names[] = { "half", "back", "gone" };
+    const mu_Rect rects[] = { mu_rect(26, 4, 20, 8), mu_rect(4, 3, 16, 6), mu_rect(100, 100, 20, 8) };
+    for (int i = 0; i < 3; i++) {
+        if (mu_begin_window_ex(ctx, names[i], rects[i], MU_OPT_NOCLOSE)) {
+            if (i == 1) g_back_runs++;
+            for (int k = 0; k < 6; k++) mu_label(ctx, "some words in a row");
+            mu_end_window(ctx);
+        }
+    }
+    if (front && mu_begin_window_ex(ctx, "front", mu_rect(2, 2, 30, 10), MU_OPT_NOCLOSE)) {
+        mu_label(ctx, "front");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+static int cull_count(mu_Context *ctx) {
+    int n = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) n++;
+    return n;
+}
+
+static int in_roots(mu_Context *ctx, const char *name) {
+    mu_Container *cnt = mu_get_container(ctx, name);
+    for (int i = 0; i < ctx->root_list.idx; i++) if (ctx->root_list.items[i] == cnt) return 1;
+    return 0;
+}
+
+TEST(test, occlusion) {
+    mu_Context *a = test_ctx_new(&(mu_Config){ .cull = 1 });
+    mu_Context *b = test_ctx_new(NULL);
+    term_headless_resize(60, 20);
+    ui_renderer_t *ur = ur_new_term();
+    a->viewport = mu_rect(0, 0, 60, 20);
+    renderer_t *r = ur_get_renderer(ur);
+    int n = r->w * r->h;
+    utf8_t *cells = malloc(n * sizeof(utf8_t));
+    style_t *styles = malloc(n * sizeof(style_t));
+
+    /* 剔除前后画出的格子完全相同, 有无根容器缓存都一样 */
+    int first = 0;
+    for (int cache = 0; cache < 2; cache++) {
+        ur_set_cache(ur, cache);
+        for (int f = 0; f < 3; f++) {
+            cull_scene(a, 1);
+            cull_scene(b, 1);
+            if (!first) first = cull_count(b);
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, b);
+            memcpy(cells, r->cells, n * sizeof(utf8_t));
+            memcpy(styles, r->styles, n * sizeof(style_t));
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, a);
+            for (int i = 0; i < n; i++) {
+                ASSERT_EQ(utf8_cmp(cells[i], r->cells[i]), 0);
+                ASSERT_EQ(style_cmp(styles[i], r->styles[i]), 0);
+            }
+        }
+    }
+
+    /* 视口外的窗口和被整个盖住的窗口照常运行, 只是不画; 半遮挡的窗口丢掉被盖住的命令 */
+    ASSERT_TRUE(!in_roots(a, "gone") && !in_roots(a, "back"));
+    ASSERT_TRUE(mu_get_container(a, "back")->root_frame == a->frame);
+    ASSERT_TRUE(in_roots(a, "half") && in_roots(b, "back"));
+    ASSERT_EQ(mu_get_container(a, "back")->culled_frame, a->frame);
+    ASSERT_EQ(mu_get_container(a, "back")->rect.w, 16);
+    ASSERT_TRUE(mu_get_container(a, "back")->open);
+    ASSERT_TRUE(cull_count(a) < cull_count(b));
+    ASSERT_TRUE(!mu_needs_frame(a));
+    cull_scene(a, 1);
+    ASSERT_TRUE(!mu_frame_changed(a));
+
+    /* 不开剔除时被盖住的窗口也照常运行, 但下一帧起不再生成命令 */
+    ASSERT_EQ(mu_get_container(b, "back")->culled_frame, b->frame);
+    ASSERT_TRUE(cull_count(b) < first);
+    ASSERT_TRUE(!mu_needs_frame(b));
+    int runs = g_back_runs;
+    cull_scene(b, 1);
+    ASSERT_EQ(g_back_runs, runs + 1);
+    ASSERT_TRUE(!mu_frame_changed(b));
+
+    /* 挡住它的窗口关掉的那一帧还没有它的命令, 要求再跑一帧画出来 */
+    cull_scene(a, 0);
+    ASSERT_TRUE(in_roots(a, "back"));
+    ASSERT_TRUE(mu_frame_changed(a));
+    ASSERT_TRUE(mu_needs_frame(a));
+    int shown = cull_count(a);
+    cull_scene(a, 0);
+    ASSERT_TRUE(mu_frame_changed(a));
+    ASSERT_TRUE(!mu_needs_frame(a));
+    ASSERT_TRUE(cull_count(a) > shown);
+    ASSERT_EQ(mu_get_container(a, "back")->rect.x, 4);
+
+    free(cells);
+    free(styles);
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(a);
+    test_ctx_free(b);
+}
+
+/* 命中网格: 悬停根容器与逐个比较的结果相同; 判为不需要新帧的移动, 跑一帧也确实什么都没变 */
+#define HIT_WINDOWS 120
+
+static unsigned hit_rand(unsigned *seed) { return (*seed = *seed * 1103515245u + 12345u) >> 16; }
+
+static int hit_scene(mu_Context *ctx, const int *shown) {
+    char name[16];
+    mu_begin(ctx);
+    for (int i = 0; i < HIT_WINDOWS; i++) {
+        if (!shown[i]) continue;
+        sprintf(name, "hit %d", i);
+        mu_Rect r = mu_rect(i * 37 % 170, i * 13 % 50, 12 + i % 20, 4 + i % 7);
+        if (mu_begin_window_ex(ctx, name, r, MU_OPT_NOTITLE | MU_OPT_NORESIZE)) {
+            mu_layout_row(ctx, 2, (int[]){ 5, -1 }, 0);
+            mu_button(ctx, "a");
+            mu_button(ctx, "b");
+            mu_end_window(ctx);
+        }
+    }
+    return mu_end(ctx);
+}
+
+static void hit_settle(mu_Context *ctx, const int *shown) {
+    for (int i = 0; i < 5 && hit_scene(ctx, shown); i++) {}
+}
+
+/* 逐个比较: 本帧跑过的根容器中包含鼠标且 zindex 最大的 */
+static mu_Container *hit_reference(mu_Context *ctx) {
+    mu_Container *best = NULL;
+    for (int i = 0; i < ctx->root_list.idx; i++) {
+        mu_Container *c = ctx->root_list.items[i];
+        mu_Rect r = c->rect;
+        mu_Vec2 p = ctx->mouse_pos;
+        if (p.x >= r.x && p.x < r.x + r.w && p.y >= r.y && p.y < r.y + r.h && (!best || c->zindex > best->zindex)) best = c;
+    }
+    return best;
+}
+
+TEST(test, hit_grid) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    int shown[HIT_WINDOWS], skipped = 0;
+    unsigned seed = 7;
+    char name[16];
+    for (int i = 0; i < HIT_WINDOWS; i++) shown[i] = 1;
+    hit_settle(ctx, shown);
+
+    for (int step = 0; step < 3000; step++) {
+        int x = hit_rand(&seed) % 210, y = hit_rand(&seed) % 66;
+        int k = hit_rand(&seed) % HIT_WINDOWS;
+        switch (hit_rand(&seed) % 10) {
+            case 0: mu_input_mousedown(ctx, x, y, MU_MOUSE_LEFT); break;     /* 点中的窗口移到最上层 */
+            case 1: mu_input_mouseup(ctx, x, y, MU_MOUSE_LEFT); break;
+            case 2: shown[k] = !shown[k]; break;
+            case 3:
+                sprintf(name, "hit %d", k);
+                mu_get_container(ctx, name)->rect.x += (int)(hit_rand(&seed) % 7) - 3;
+                break;
+            default:
+                /* 多是一两格的小步移动, 偶尔跳到别处 */
+                if (step % 7) {
+                    x = mu_clamp(ctx->mouse_pos.x + (int)(hit_rand(&seed) % 5) - 2, 0, 209);
+                    y = mu_clamp(ctx->mouse_pos.y + (int)(hit_rand(&seed) % 3) - 1, 0, 65);
+                }
+                if (!mu_input_mousemove(ctx, x, y)) {
+                    mu_Id hash = ctx->frame_hash;
+                    ASSERT_TRUE(!hit_scene(ctx, shown));
+                    ASSERT_EQ(ctx->frame_hash, hash);
+                    skipped++;
+                }
+                break;
+        }
+        hit_settle(ctx, shown);
+        ASSERT_TRUE(ctx->next_hover_root == hit_reference(ctx));
+        int roots = 0;
+        for (int i = 0; i < HIT_WINDOWS; i++) roots += shown[i];
+        ASSERT_EQ(ctx->root_list.idx, roots);
+        for (int i = 1; i < roots; i++)     /* 根容器按 zindex 从后到前 */
+            ASSERT_TRUE(ctx->root_list.items[i - 1]->zindex < ctx->root_list.items[i]->zindex);
+    }
+    ASSERT_TRUE(skipped > 100);
+
+    /* 全部显示后, 最上层窗口里的控件照常得到悬停 */
+    mu_input_mouseup(ctx, 0, 0, MU_MOUSE_LEFT);
+    for (int i = 0; i < HIT_WINDOWS; i++) shown[i] = 1;
+    hit_settle(ctx, shown);
+    mu_Container *top = ctx->root_list.items[ctx->root_list.idx - 1];
+    ASSERT_TRUE(mu_input_mousemove(ctx, top->rect.x + 2, top->rect.y));
+    hit_settle(ctx, shown);
+    ASSERT_TRUE(ctx->hover_root == top);
+    ASSERT_TRUE(ctx->hover != 0);
+
+    test_ctx_free(ctx);
+}
+
+/* 鼠标逐格随机移动, 只在 mu_input_mousemove 要求时跑帧: 每次移动的平均开销 */
+BENCH(bench, hover_move) {
+    static mu_Context *ctx;
+    static int shown[HIT_WINDOWS];
+    static unsigned seed = 1;
+    if (!ctx) {
+        ctx = test_ctx_new(NULL);
+        for (int i = 0; i < HIT_WINDOWS; i++) shown[i] = 1;
+        hit_settle(ctx, shown);
+    }
+    int d = hit_rand(&seed) % 4;
+    int x = mu_clamp(ctx->mouse_pos.x + (d == 0) - (d == 1), 0, 199);
+    int y = mu_clamp(ctx->mouse_pos.y + (d == 2) - (d == 3), 0, 59);
+    if (mu_input_mousemove(ctx, x, y)) hit_settle(ctx, shown);
+}
+
+/* 大屏: 重叠的窗口铺满, 有的每帧变化有的静止, 有的伸出屏幕 */
+static void band_scene(mu_Context *ctx, int frame) {
+    char buf[32];
+    mu_begin(ctx);
+    for (int i = 0; i < 24; i++) {
+        sprintf(buf, "band %d", i);
+        mu_Rect r = mu_rect((i % 6) * 64 - 4 + (i == 7 ? frame : 0), (i / 6) * 48 + (i & 1) * 5, 90, 60);
+        if (mu_begin_window_ex(ctx, buf, r, i % 5 == 4 ? MU_OPT_NOFRAME : 0)) {
+            if (i == 7) mu_get_current_container(ctx)->rect = r;
+            mu_layout_row(ctx, 3, (int[]){20, 30, -1}, 0);
+            for (int k = 0; k < 60; k++) {
+                sprintf(buf, "%d 世界 %d", k, i % 3 == 0 ? frame : 0);
+                mu_label(ctx, buf);
+            }
+            mu_end_window(ctx);
+        }
+    }
+    mu_end(ctx);
+}
+
+TEST(test, raster_bands) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    term_headless_resize(400, 200);
+    ui_renderer_t *ur = ur_new_term();
+    renderer_t *r = ur_get_renderer(ur);
+    int n = r->w * r->h;
+    utf8_t *cells = malloc(n * sizeof(utf8_t));
+    style_t *styles = malloc(n * sizeof(style_t));
+
+    /* 分带并行回放与串行逐格一致, 有无根容器缓存都一样 */
+    for (int cache = 0; cache < 2; cache++) {
+        ur_set_cache(ur, cache);
+        for (int f = 0; f < 4; f++) {
+            band_scene(ctx, f);
+            ur_set_threads(ur, 1);
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, ctx);
+            memcpy(cells, r->cells, n * sizeof(utf8_t));
+            memcpy(styles, r->styles, n * sizeof(style_t));
+            ur_set_threads(ur, 3);
+            ur_clear(ur, mu_color(0, 0, 0, 0));
+            ur_draw_commands(ur, ctx);
+            for (int i = 0; i < n; i++) {
+                ASSERT_EQ(utf8_cmp(cells[i], r->cells[i]), 0);
+                ASSERT_EQ(style_cmp(styles[i], r->styles[i]), 0);
+            }
+        }
+    }
+
+    free(cells);
+    free(styles);
+    ur_free(ur);
+    term_shutdown();
+    test_ctx_free(ctx);
+}
+
+/* 大屏整帧重放(不走缓存), 对照 bench.raster_serial */
+static void raster_bench(int threads) {
+    static mu_Context *ctx;
+    static ui_renderer_t *ur;
+    if (!ctx) {
+        ctx = test_ctx_new(NULL);
+        term_headless_resize(400, 200);
+        ur = ur_new_term();
+        band_scene(ctx, 0);
+    }
+    ur_set_threads(ur, threads);
+    ur_set_cache(ur, 0);
+    ur_clear(ur, mu_color(0, 0, 0, 0));
+    ur_draw_commands(ur, ctx);
+}
+
+BENCH(bench, raster_serial) { raster_bench(1); }
+BENCH(bench, raster_bands) { raster_bench(4); }
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+
+/* 每格的字和前景/背景色都随 seed 变化 */
+static void budget_fill(renderer_t *r, int seed) {
+    for (int y = 0; y < r->h; y++)
+    for (int x = 0; x < r->w; x++) {
+        int i = y * r->w + x, k = x * 7 + y * 3 + seed;
+        r->cells[i] = (utf8_t){{(uint8_t)('a' + k % 26)}, 1, 1};
+        r->styles[i] = (style_t){ .fg = (k * 2654435761u) & 0xFFFFFF, .bg = (k * 40503u + seed) & 0xFFFFFF };
+    }
+}
+
+static int budget_drain(int fd, vt_t *vt) {
+    char buf[4096];
+    int total = 0, n;
+    while ((n = (int)read(fd, buf, sizeof(buf))) > 0) { vt_feed(vt, buf, n); total += n; }
+    return total;
+}
+
+/* 区域内 vt 屏幕与渲染缓冲一致; colors 为 0 时比较原色, 否则比较量化后的颜色 */
+static int budget_same(vt_t *vt, renderer_t *r, mu_Rect a, int colors) {
+    for (int y = a.y; y < a.y + a.h; y++)
+    for (int x = a.x; x < a.x + a.w; x++) {
+        int i = y * r->w + x;
+        style_t s = vt_style_at(vt, x, y), want = r->styles[i];
+        if (utf8_cmp(vt->screen->cells[i], r->cells[i])) return 0;
+        if (colors) {
+            want.fg = style_palette_rgb(style_quantize(want.fg, colors));
+            want.bg = style_palette_rgb(style_quantize(want.bg, colors));
+        }
+        if (s.fg != want.fg || s.bg != want.bg) return 0;
+    }
+    return 1;
+}
+
+TEST(test, render_budget) {
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    fcntl(p[0], F_SETFL, fcntl(p[0], F_GETFL) | O_NONBLOCK);
+    ui_renderer_t *ur = ur_new_fd(40, 12, p[1]);
+    renderer_t *r = ur_get_renderer(ur);
+    vt_t *vt = vt_new(40, 12);
+    mu_Rect all = mu_rect(0, 0, 40, 12);
+
+    /* 不限速: 全彩, 逐格一致 */
+    budget_fill(r, 1);
+    ur_present(ur);
+    int full = budget_drain(p[0], vt);
+    ASSERT_EQ(ur_quality(ur), UR_Q_FULL);
+    ASSERT_EQ(ur_deferred_ms(ur), -1);
+    ASSERT_TRUE(budget_same(vt, r, all, 0));
+
+    /* 预算放不下全彩的整屏: 降色深, 字仍全部更新 */
+    ur_set_budget(ur, full * 3 / 4);
+    budget_fill(r, 2);
+    ur_present(ur);
+    int n = budget_drain(p[0], vt);
+    int q = ur_quality(ur);
+    ASSERT_TRUE(q == UR_Q_256 || q == UR_Q_16);
+    ASSERT_TRUE(n <= full * 3 / 4);
+    ASSERT_TRUE(budget_same(vt, r, all, q == UR_Q_256 ? 256 : 16));
+
+    /* 预算很小: 整屏变化时只更新焦点区域, 其余推迟 */
+    ur_set_budget(ur, 0);
+    budget_fill(r, 3);
+    ur_present(ur);
+    budget_drain(p[0], vt);
+    ur_set_budget(ur, 1000);
+    r->cells[0] = (utf8_t){"#", 1, 1};
+    ur_present(ur);
+    ASSERT_EQ(ur_quality(ur), UR_Q_FULL);
+    budget_drain(p[0], vt);
+    mu_Rect focus = mu_rect(2, 1, 10, 2);
+    ur_set_focus(ur, focus);
+    budget_fill(r, 4);
+    ur_present(ur);
+    ASSERT_EQ(ur_quality(ur), UR_Q_FOCUS);
+    ASSERT_TRUE(budget_drain(p[0], vt) <= 1000);
+    ASSERT_TRUE(budget_same(vt, r, focus, 16));
+    ASSERT_TRUE(!budget_same(vt, r, mu_rect(0, 5, 40, 1), 16));
+    int wait = ur_deferred_ms(ur);
+    ASSERT_TRUE(wait > 0 && wait <= 1000);
+
+    /* 令牌不够时再 present 什么也不发, 到时候后补上全部内容 */
+    ur_present(ur);
+    ASSERT_EQ(ur_quality(ur), UR_Q_DEFERRED);
+    ASSERT_EQ(budget_drain(p[0], vt), 0);
+    thread_sleep_ms(ur_deferred_ms(ur) + 5);
+    ASSERT_EQ(ur_deferred_ms(ur), 0);
+    ur_present(ur);
+    ASSERT_EQ(ur_quality(ur), UR_Q_16);
+    budget_drain(p[0], vt);
+    ASSERT_TRUE(budget_same(vt, r, all, 16));
+
+    /* 解除预算后补回全彩 */
+    ur_set_budget(ur, 0);
+    ur_present(ur);
+    budget_drain(p[0], vt);
+    ASSERT_TRUE(budget_same(vt, r, all, 0));
+
+    ur_free(ur);
+    vt_free(vt);
+    close(p[0]);
+    close(p[1]);
+}
+
+/* 对端不读: present 不会卡住, 写不下的留到 ur_flush; 积压太多时丢掉, 下次清屏重画 */
+TEST(test, render_fd_backlog) {
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    fcntl(p[0], F_SETFL, fcntl(p[0], F_GETFL) | O_NONBLOCK);
+    fcntl(p[1], F_SETFL, fcntl(p[1], F_GETFL) | O_NONBLOCK);
+    ui_renderer_t *ur = ur_new_fd(200, 60, p[1]);
+    renderer_t *r = ur_get_renderer(ur);
+    vt_t *vt = vt_new(200, 60);
+
+    long long t0 = timer_ns();
+    budget_fill(r, 1);
+    ur_present(ur);
+    int left = ur_flush(ur);
+    ASSERT_TRUE(left > 0);
+    ASSERT_TRUE(timer_ns() - t0 < 1000000000LL);
+    /* 对端开始读, 积压按序写完, 屏幕与第一帧一致 */
+    int frame = 0;
+    while (ur_flush(ur)) frame += budget_drain(p[0], vt);
+    frame += budget_drain(p[0], vt);
+    ASSERT_TRUE(budget_same(vt, r, mu_rect(0, 0, 200, 60), 0));
+
+    /* 一直不读, 积压超过上限后被丢弃 */
+    for (int i = 2, sent = 0; sent <= UR_FD_MAX + frame; i++, sent += frame) {
+        budget_fill(r, i);
+        ur_present(ur);
+    }
+    ASSERT_TRUE(ur_flush(ur) <= UR_FD_MAX);
+    while (ur_flush(ur)) budget_drain(p[0], vt);
+    budget_drain(p[0], vt);
+    budget_fill(r, 100);
+    ur_present(ur);
+    while (ur_flush(ur)) budget_drain(p[0], vt);
+    budget_drain(p[0], vt);
+    ASSERT_TRUE(budget_same(vt, r, mu_rect(0, 0, 200, 60), 0));
+
+    ur_free(ur);
+    vt_free(vt);
+    close(p[0]);
+    close(p[1]);
+}
+#endif
+
+BENCH(bench, mu_get_id) {
+    static mu_Context *ctx;
+    static int i;
+    static const char *names[] = { "Button 1", "Log Window", "Test 1b", "Checkbox 3" };
+    if (!ctx) { ctx = malloc(sizeof(mu_Context)); mu_init(ctx); }
+    const char *s = names[i++ & 3];
+    BENCH_KEEP(mu_get_id(ctx, s, strlen(s)));
+}
+
+#endif /* TERM_HEADLESS */
@@ -0,0 +1,57 @@
+#include "../src/minitest.h"
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "../src/log.h"
+#include "../src/thread.h"
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_LINES   200
+
+static void log_worker(void *arg) {
+    for (int i = 0; i < LOG_TEST_LINES; i++) LOG_INFO("worker %d line %d", (int)(size_t)arg, i);
+}
+
+TEST(test, log) {
+    const char *path = "test_log.tmp";
+    int side = 0;
+    log_open(path);
+
+    /* 低于 LOG_LEVEL 的级别编译期去掉, 参数不求值 */
+    LOG_DEBUG("side %d", side++);
+    LOG_TRACE("side %d", side++);
+    ASSERT_EQ(side, 0);
+
+    thread_t t[LOG_TEST_THREADS];
+    for (int i = 0; i < LOG_TEST_THREADS; i++) ASSERT_EQ(thread_create(&t[i], log_worker, (void *)(size_t)i), 0);
+    for (int i = 0; i < LOG_TEST_THREADS; i++) thread_join(t[i]);
+    LOG_WARN("done");
+    log_flush();
+
+    FILE *fp = fopen(path, "r");
+    ASSERT_TRUE(fp != NULL);
+    char line[LOG_MSG_MAX + 2];
+    int lines = 0, done = 0, per[LOG_TEST_THREADS] = {0};
+    while (fgets(line, sizeof(line), fp)) {
+        int w, n;
+        const char *p = strstr(line, "worker ");
+        if (p && sscanf(p, "worker %d line %d", &w, &n) == 2) {
+            ASSERT_EQ(n, per[w]);           /* 同一线程内保持顺序 */
+            per[w]++;
+        }
+        if (strstr(line, "WARN ") == line && strstr(line, ": done")) done = 1;
+        lines++;
+    }
+    fclose(fp);
+    remove(path);
+
+    ASSERT_EQ(log_dropped(), 0);
+    ASSERT_EQ(lines, LOG_TEST_THREADS * LOG_TEST_LINES + 1);
+    ASSERT_TRUE(done);
+    log_open("debug.log");
+}
+
+/* 每半个缓冲刷一次, 计入写文件的均摊开销, 也避免缓冲满后只测到丢弃路径 */
+BENCH(bench, log_write) {
+    static int i;
+    LOG_INFO("frame %d took %d us", i, 1234);
+    if ((++i & (LOG_SLOTS / 2 - 1)) == 0) log_flush();
+}
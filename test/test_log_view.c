@@ -0,0 +1,127 @@
+#include "../src/minitest.h"
+#include "../src/log_view.h"
+#include "test_util.h"
+#include "../src/thread.h"
+#include <stdio.h>
+
+#define LV_TEST_THREADS 4
+#define LV_TEST_LINES   5000
+
+static log_view_t *g_lv;
+
+static void lv_worker(void *arg) {
+    for (int i = 0; i < LV_TEST_LINES; i++) {
+        lv_printf(g_lv, "t%d %d", (int)(size_t)arg, i);
+        if (i % 64 == 0) thread_sleep_ms(0);
+    }
+}
+
+/* 画一帧, 返回最后一条文本命令 */
+static const char *lv_frame(mu_Context *ctx, log_view_t *lv, int w, int *texts) {
+    static char last[LV_MSG_MAX + 1];
+    char name[16];
+    sprintf(name, "log%d", w);      /* 窗口尺寸只在创建时生效, 每种宽度用一个窗口 */
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, name, mu_rect(0, 0, w, 12), MU_OPT_NOCLOSE)) {
+        lv_draw(ctx, lv);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    last[0] = '\0';
+    *texts = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type != MU_COMMAND_TEXT || !strcmp(cmd->text.str, name)) continue;
+        (*texts)++;
+        strcpy(last, cmd->text.str);
+    }
+    return last;
+}
+
+TEST(test, log_view) {
+    mu_Context *ctx = test_ctx_new_ex(NULL, test_byte_width);
+    int texts;
+
+    /* 多个线程同时写, UI 线程边写边画 */
+    g_lv = lv_new(100000);
+    thread_t t[LV_TEST_THREADS];
+    for (int i = 0; i < LV_TEST_THREADS; i++) ASSERT_EQ(thread_create(&t[i], lv_worker, (void *)(size_t)i), 0);
+    for (int i = 0; i < 50; i++) lv_frame(ctx, g_lv, 30, &texts);
+    for (int i = 0; i < LV_TEST_THREADS; i++) thread_join(t[i]);
+    lv_frame(ctx, g_lv, 30, &texts);
+    ASSERT_EQ(lv_lines(g_lv) + (int)lv_dropped(g_lv), LV_TEST_THREADS * LV_TEST_LINES);
+    int next[LV_TEST_THREADS] = {0};
+    for (int i = 0; i < lv_lines(g_lv); i++) {
+        int w, n;
+        ASSERT_EQ(sscanf(lv_line(g_lv, i), "t%d %d", &w, &n), 2);
+        ASSERT_TRUE(n >= next[w]);      /* 同一线程的行保持顺序 */
+        next[w] = n + 1;
+    }
+    /* 只画可见行, 并跟随到底部 */
+    const char *last = lv_frame(ctx, g_lv, 30, &texts);
+    ASSERT_TRUE(texts <= 11 + 2);
+    ASSERT_STREQ(last, lv_line(g_lv, lv_lines(g_lv) - 1));
+    lv_free(g_lv);
+
+    /* 折行: 在空格处断开, 超长单词按字符断开 */
+    log_view_t *lv = lv_new(100);
+    lv_append(lv, "alpha beta gamma delta");
+    lv_append(lv, "0123456789abcdefghijklmnopqrstuvwxyz");
+    lv_frame(ctx, lv, 10, &texts);
+    ASSERT_EQ(lv_rows(lv), 3 + 4);
+    mu_Command *cmd = NULL;
+    const char *want[] = { "alpha beta", "gamma", "delta", "0123456789", "abcdefghij", "klmnopqrst", "uvwxyz" };
+    int k = 0;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type != MU_COMMAND_TEXT || !strcmp(cmd->text.str, "log10")) continue;
+        ASSERT_TRUE(k < 7);
+        ASSERT_STREQ(cmd->text.str, want[k++]);
+    }
+    ASSERT_EQ(k, 7);
+
+    /* 宽度变化时重新折行; 超出历史上限时挤出旧行 */
+    lv_frame(ctx, lv, 40, &texts);
+    ASSERT_EQ(lv_rows(lv), 2);
+    for (int i = 0; i < 150; i++) lv_printf(lv, "line %d", i);
+    lv_frame(ctx, lv, 40, &texts);
+    ASSERT_EQ(lv_lines(lv), 100);
+    ASSERT_STREQ(lv_line(lv, 0), "line 50");
+    ASSERT_EQ(lv_rows(lv), 100);
+
+    /* 不画也能取出新行; 期间挤出的行在下次绘制时照样补偿滚动 */
+    lv_append(lv, "hidden");
+    ASSERT_TRUE(lv_pending(lv));
+    lv_update(ctx, lv);
+    ASSERT_TRUE(!lv_pending(lv));
+    ASSERT_STREQ(lv_line(lv, lv_lines(lv) - 1), "hidden");
+    ASSERT_STREQ(lv_line(lv, 0), "line 51");
+
+    /* 超长行: lv_append 与 lv_printf 截断到同样长度, 都不留半个 UTF-8 字符 */
+    char wide[2 * LV_MSG_MAX + 1];
+    for (int i = 0; i < LV_MSG_MAX; i++) memcpy(wide + 2 * i, "\xc3\xa9", 2);
+    wide[2 * LV_MSG_MAX] = '\0';
+    lv_append(lv, wide);
+    lv_printf(lv, "%s", wide);
+    lv_printf(lv, "x%s", wide);
+    lv_update(ctx, lv);
+    int n = lv_lines(lv);
+    ASSERT_EQ((int)strlen(lv_line(lv, n - 3)), LV_MSG_MAX - 2);
+    ASSERT_STREQ(lv_line(lv, n - 3), lv_line(lv, n - 2));
+    ASSERT_EQ((int)strlen(lv_line(lv, n - 1)), LV_MSG_MAX - 1);
+    lv_free(lv);
+
+    test_ctx_free(ctx);
+}
+
+BENCH(bench, lv_append) {
+    static log_view_t *lv;
+    static mu_Context *ctx;
+    static int n;
+    if (!lv) {
+        lv = lv_new(10000);
+        ctx = test_ctx_new_ex(NULL, test_byte_width);
+    }
+    lv_printf(lv, "worker %d: processed request in %d us", n & 7, n);
+    /* 模拟 UI 线程每 1000 行画一帧 */
+    if (++n % 1000 == 0) { int texts; lv_frame(ctx, lv, 60, &texts); }
+}
@@ -1,151 +1,190 @@
-#include "../src/minitest.h"
-#include "../src/microui.h"
-#include "../src/ui_renderer.h"
-#include "../src/term.h"
-#include "../src/log.h"
-
-static  char logbuf[64000];
-static   int logbuf_updated = 0;
-static  int win_open = 1;
-static void write_log(const char *text) {
-  if (logbuf[0]) { strcat(logbuf, "\n"); }
-  strcat(logbuf, text);
-  logbuf_updated = 1;
-}
-
-static int text_width(mu_Font font, const char *text, int len) {
-    return r_get_text_width(text, (len == -1) ? strlen(text) : len);
-}
-
-static int text_height(mu_Font font) {return r_get_text_height();}
-
-static void process_frame(mu_Context *ctx) {
-    mu_begin(ctx);
-    if (mu_begin_window(ctx, "Log Window", mu_rect(0, 1, 40, 6))) {
-
-        /* window info */
-        if (mu_header(ctx, "Window Info")) {
-            mu_Container *win = mu_get_current_container(ctx);
-            char buf[64];
-            mu_layout_row(ctx, 2, (int[]){20, -1}, 0);
-            mu_label(ctx, " Position: ");
-            sprintf(buf, "%d, %d", win->rect.x, win->rect.y);
-            mu_label(ctx, buf);
-            mu_label(ctx, " Size:");
-            sprintf(buf, "%d, %d", win->rect.w, win->rect.h);
-            mu_label(ctx, buf);
-
-            mu_layout_row(ctx, 1, (int[]){-1}, 0);
-            mu_label(ctx, "====================");
-            mu_text(ctx, logbuf);
-            mu_label(ctx, "====================");
-        }
-
-        if (mu_header_ex(ctx, "Tree and Text", MU_OPT_EXPANDED)) {
-            if (mu_begin_treenode(ctx, "Test 1")) {
-                if (mu_begin_treenode(ctx, "Test 1a")) {
-                    mu_label(ctx, "Hello");
-                    mu_label(ctx, "world");
-                    mu_end_treenode(ctx);
-                }
-                if (mu_begin_treenode(ctx, "Test 1b")) {
-                    if (mu_button(ctx, "Button 1")) {write_log("Pressed button 1");}
-                    if (mu_button(ctx, "Button 2")) {write_log("Pressed button 2");}
-                    mu_end_treenode(ctx);
-                }
-                mu_end_treenode(ctx);
-            }
-            if (mu_begin_treenode(ctx, "Test 2")) {
-                mu_layout_row(ctx, 2, (int[]){20, -1}, 0);
-                if (mu_button(ctx, "Button 3")) {write_log("Pressed button 3");}
-                if (mu_button(ctx, "Button 4")) {write_log("Pressed button 4");}
-                if (mu_button(ctx, "Button 5")) {write_log("Pressed button 5");}
-                if (mu_button(ctx, "Button 6")) {write_log("Pressed button 6");}
-                mu_end_treenode(ctx);
-            }
-            if (mu_begin_treenode(ctx, "Test 3")) {
-                static int checks[3] = {1, 0, 1};
-                mu_checkbox(ctx, "Checkbox 1", &checks[0]);
-                mu_checkbox(ctx, "Checkbox 2", &checks[1]);
-                mu_checkbox(ctx, "Checkbox 3", &checks[2]);
-                mu_end_treenode(ctx);
-            }
-        }
-
-        mu_end_window(ctx);
-    }
-
-    mu_Container *cnt = mu_get_container(ctx, "Log Window");
-    win_open = cnt->open;
-
-    mu_end(ctx);
-}
-
-TEST(test, microui) {
-    SetConsoleOutputCP(65001);
-
-    /* init microui */
-    mu_Context *ctx = malloc(sizeof(mu_Context));
-    mu_init(ctx);
-    ctx->text_width = text_width;
-    ctx->text_height = text_height;
-
-    r_init();
-    term_hide_cursor();
-
-    while (1) {
-        TermEvent e = term_poll_event();
-        if (e.type == TERM_EV_NONE) {
-            Sleep(10);
-            continue;
-        }
-
-        switch (e.type) {
-        case TERM_EV_KEY:
-            if (e.u.key.pressed && e.u.key.key_code == VK_ESCAPE) { goto QUIT; }
-
-            if (e.u.key.pressed)    mu_input_keydown(ctx, e.u.key.utf8[0]);
-            else                    mu_input_keyup(ctx, e.u.key.utf8[0]);
-            break;
-
-        case TERM_EV_MOUSE:
-            switch (e.u.mouse.type) {
-                case 1: mu_input_mousemove(ctx, e.u.mouse.x, e.u.mouse.y); break;
-                case 2: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT); break;
-                case 3: mu_input_mouseup(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT | MU_MOUSE_RIGHT | MU_MOUSE_MIDDLE); break;
-                case 4: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_RIGHT); break;
-                case 6: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_MIDDLE); break;
-                case 8: mu_input_scroll(ctx, 0, -e.u.mouse.wheel); break;
-            }
-            break;
-
-        case TERM_EV_RESIZE:
-            r_init();
-            break;
-
-        default:
-            break;
-        }
-
-        process_frame(ctx);
-
-        if(!win_open) goto QUIT;
-
-        r_clear(mu_color(255, 255, 0, 255));
-        mu_Command *cmd = NULL;
-        while (mu_next_command(ctx, &cmd)) {
-            switch (cmd->type) {
-                case MU_COMMAND_TEXT: r_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color); break; 
-                case MU_COMMAND_RECT: r_draw_rect(cmd->rect.rect, cmd->rect.color); break;
-                case MU_COMMAND_ICON: r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
-                case MU_COMMAND_CLIP: r_set_clip_rect(cmd->clip.rect); break;
-            }
-        }
-        r_present();
-    }
-
-QUIT:
-    term_shutdown();
-    term_clear_screen();
-    term_show_cursor();
+#include "../src/minitest.h"
+#include "../src/microui.h"
+#include "../src/ui_renderer.h"
+#include "../src/term.h"
+#include "../src/log.h"
+#include "../src/log_view.h"
+#include "../src/thread.h"
+#include "../src/replay.h"
+#include "test_util.h"
+
+static log_view_t *g_log;
+static  int win_open = 1;
+static void write_log(const char *text) {
+  lv_append(g_log, text);
+}
+
+/* 虚拟键码到 microui 按键位, 不认识的返回 0 */
+static int key_map(int vk) {
+    switch (vk) {
+    case VK_SHIFT:   return MU_KEY_SHIFT;
+    case VK_CONTROL: return MU_KEY_CTRL;
+    case VK_MENU:    return MU_KEY_ALT;
+    case VK_BACK:    return MU_KEY_BACKSPACE;
+    case VK_RETURN:  return MU_KEY_RETURN;
+    case VK_DELETE:  return MU_KEY_DELETE;
+    case VK_LEFT:    return MU_KEY_LEFT;
+    case VK_RIGHT:   return MU_KEY_RIGHT;
+    case VK_UP:      return MU_KEY_UP;
+    case VK_DOWN:    return MU_KEY_DOWN;
+    case VK_HOME:    return MU_KEY_HOME;
+    case VK_END:     return MU_KEY_END;
+    case VK_PRIOR:   return MU_KEY_PAGEUP;
+    case VK_NEXT:    return MU_KEY_PAGEDOWN;
+    }
+    return 0;
+}
+
+static void process_frame(mu_Context *ctx) {
+    mu_begin(ctx);
+    /* 日志所在的标题默认折叠, 新行先在这里取出, 否则 lv_pending 一直为真, 主循环不再休眠 */
+    lv_update(ctx, g_log);
+    if (mu_begin_window(ctx, "Log Window", mu_rect(0, 1, 40, 6))) {
+
+        /* window info */
+        if (mu_header(ctx, "Window Info")) {
+            mu_Container *win = mu_get_current_container(ctx);
+            char buf[64];
+            mu_layout_row(ctx, 2, (int[]){20, -1}, 0);
+            mu_label(ctx, " Position: ");
+            sprintf(buf, "%d, %d", win->rect.x, win->rect.y);
+            mu_label(ctx, buf);
+            mu_label(ctx, " Size:");
+            sprintf(buf, "%d, %d", win->rect.w, win->rect.h);
+            mu_label(ctx, buf);
+
+            mu_layout_row(ctx, 1, (int[]){-1}, 6);
+            mu_begin_panel(ctx, "Log Output");
+            lv_draw(ctx, g_log);
+            mu_end_panel(ctx);
+            mu_layout_row(ctx, 1, (int[]){-1}, 0);
+        }
+
+        if (mu_header_ex(ctx, "Tree and Text", MU_OPT_EXPANDED)) {
+            if (mu_begin_treenode(ctx, "Test 1")) {
+                if (mu_begin_treenode(ctx, "Test 1a")) {
+                    mu_label(ctx, "Hello");
+                    mu_label(ctx, "world");
+                    mu_end_treenode(ctx);
+                }
+                if (mu_begin_treenode(ctx, "Test 1b")) {
+                    if (mu_button(ctx, "Button 1")) {write_log("Pressed button 1");}
+                    if (mu_button(ctx, "Button 2")) {write_log("Pressed button 2");}
+                    mu_end_treenode(ctx);
+                }
+                mu_end_treenode(ctx);
+            }
+            if (mu_begin_treenode(ctx, "Test 2")) {
+                mu_layout_row(ctx, 2, (int[]){20, -1}, 0);
+                if (mu_button(ctx, "Button 3")) {write_log("Pressed button 3");}
+                if (mu_button(ctx, "Button 4")) {write_log("Pressed button 4");}
+                if (mu_button(ctx, "Button 5")) {write_log("Pressed button 5");}
+                if (mu_button(ctx, "Button 6")) {write_log("Pressed button 6");}
+                mu_end_treenode(ctx);
+            }
+            if (mu_begin_treenode(ctx, "Test 3")) {
+                static int checks[3] = {1, 0, 1};
+                mu_checkbox(ctx, "Checkbox 1", &checks[0]);
+                mu_checkbox(ctx, "Checkbox 2", &checks[1]);
+                mu_checkbox(ctx, "Checkbox 3", &checks[2]);
+                mu_end_treenode(ctx);
+            }
+        }
+
+        mu_end_window(ctx);
+    }
+
+    mu_Container *cnt = mu_get_container(ctx, "Log Window");
+    win_open = cnt->open;
+
+    mu_end(ctx);
+}
+
+TEST(test, microui) {
+    SetConsoleOutputCP(65001);
+
+    /* init microui */
+    mu_Context *ctx = test_ctx_new(NULL);
+    g_log = lv_new(1000);
+    ctx->text_glyphs = r_text_glyphs;
+    ctx->glyph_size = sizeof(utf8_t);
+
+    ui_renderer_t *ur = ur_new_term();
+    ur_set_threads(ur, thread_cpu_count());     /* 只在很大的终端上才真的分带并行 */
+    ctx->viewport = mu_rect(0, 0, ur_get_renderer(ur)->w, ur_get_renderer(ur)->h);
+    term_hide_cursor();
+    int redraw = 1;
+    /* MU_RECORD=文件: 录下输入和每帧的命令流, 供 bench_main 的 BENCH_REPLAY 或回放比较使用 */
+    recorder_t *rec = getenv("MU_RECORD") ? rec_open(getenv("MU_RECORD")) : NULL;
+    /* MU_INPUT_THREAD: 输入在后台线程读取, 慢帧时粘贴的大段输入也不会堆在控制台缓冲里 */
+    term_input_t *in = getenv("MU_INPUT_THREAD") ? term_input_start(NULL, NULL) : NULL;
+
+    while (1) {
+        long long t_in;
+        TermEvent e = term_input_poll(in, &t_in);
+        if (rec) rec_event_at(rec, &e, t_in);
+        /* 没有事件, 上一帧也没有待定的状态变化: 空闲, 不跑帧 */
+        if (e.type == TERM_EV_NONE && !mu_needs_frame(ctx) && !lv_pending(g_log) && !redraw) {
+            Sleep(10);
+            continue;
+        }
+
+        switch (e.type) {
+        case TERM_EV_KEY:
+            if (e.u.key.pressed && e.u.key.key_code == VK_ESCAPE) { goto QUIT; }
+
+            if (key_map(e.u.key.key_code)) {
+                if (e.u.key.pressed)    mu_input_keydown(ctx, key_map(e.u.key.key_code));
+                else                    mu_input_keyup(ctx, key_map(e.u.key.key_code));
+            } else if (e.u.key.pressed && (unsigned char)e.u.key.utf8[0] >= 0x20) {
+                mu_input_text(ctx, e.u.key.utf8);
+            }
+            break;
+
+        case TERM_EV_MOUSE:
+            switch (e.u.mouse.type) {
+                case 1: mu_input_mousemove(ctx, e.u.mouse.x, e.u.mouse.y); break;
+                case 2: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT); break;
+                case 3: mu_input_mouseup(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_LEFT | MU_MOUSE_RIGHT | MU_MOUSE_MIDDLE); break;
+                case 4: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_RIGHT); break;
+                case 6: mu_input_mousedown(ctx, e.u.mouse.x, e.u.mouse.y, MU_MOUSE_MIDDLE); break;
+                case 8: mu_input_scroll(ctx, 0, -e.u.mouse.wheel); break;
+            }
+            break;
+
+        case TERM_EV_RESIZE:
+            ur_fit_term(ur);
+            ctx->viewport = mu_rect(0, 0, ur_get_renderer(ur)->w, ur_get_renderer(ur)->h);
+            redraw = 1;
+            break;
+
+        default:
+            break;
+        }
+
+        /* 不影响界面的输入(松键、在空白处移动鼠标等)不跑帧 */
+        if (!mu_needs_frame(ctx) && !lv_pending(g_log) && !redraw) continue;
+        process_frame(ctx);
+        if (rec) rec_frame(rec, ctx);
+
+        if(!win_open) goto QUIT;
+
+        /* 命令流没变则屏幕也不变, 跳过光栅化和输出 */
+        if (!mu_frame_changed(ctx) && !redraw) continue;
+        redraw = 0;
+
+        ur_clear(ur, mu_color(255, 255, 0, 255));
+        ur_draw_commands(ur, ctx);
+        ur_present(ur);
+    }
+
+QUIT:
+    term_input_free(in);
+    rec_close(rec);
+    ur_free(ur);
+    term_shutdown();
+    term_clear_screen();
+    term_show_cursor();
+    test_ctx_free(ctx);
+    lv_free(g_log);
 }
\ No newline at end of file
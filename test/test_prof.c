@@ -0,0 +1,60 @@
+#include "../src/minitest.h"
+#include "../src/prof.h"
+#include "../src/timer.h"
+
+#ifdef __linux__
+
+static volatile unsigned g_spin;
+
+/* static 且不内联: 验证 .symtab 符号化能认出非导出函数 */
+static __attribute__((noinline)) void prof_busy_leaf(long long ns) {
+    long long t0 = timer_ns();
+    while (timer_ns() - t0 < ns)
+        for (int i = 0; i < 100000; i++) g_spin = g_spin * 1103515245u + 12345u;
+}
+
+static __attribute__((noinline)) void prof_busy_caller(long long ns) {
+    prof_busy_leaf(ns);
+    g_spin++;
+}
+
+TEST(test, prof) {
+    /* CPU 时间定时器受内核 tick 限制, 实际采样率可能只有 100~250Hz */
+    ASSERT_EQ(prof_start(1000, 0), 0);
+    prof_busy_caller(300000000LL);
+    prof_stop();
+    int samples = prof_samples();
+    ASSERT_TRUE(samples > 20);
+
+    FILE *fp = tmpfile();
+    ASSERT_TRUE(fp != NULL);
+    prof_dump(fp);
+    rewind(fp);
+
+    char line[4096];
+    int total = 0, leaf = 0, nested = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        char *sp = strrchr(line, ' ');
+        ASSERT_TRUE(sp != NULL);
+        int c = atoi(sp + 1);
+        total += c;
+        if (strstr(line, "prof_busy_leaf")) leaf += c;
+        if (strstr(line, "prof_busy_caller;prof_busy_leaf")) nested += c;
+    }
+    fclose(fp);
+    prof_reset();
+
+    ASSERT_EQ(total, samples);
+    /* 忙循环占多少样本取决于调度和插桩(TSan 下大部分样本落在运行时里), 只要求采到过 */
+    ASSERT_TRUE(leaf > 0);
+    ASSERT_TRUE(nested * 2 > leaf);     /* 用帧指针编译时能看到调用者 */
+
+    /* 极端采样率: 1Hz 的周期是整 1 秒, 过高的请求被限到 PROF_MAX_HZ, 都能正常启动 */
+    ASSERT_EQ(prof_start(1, 16), 0);
+    prof_stop();
+    ASSERT_EQ(prof_start(2000000000, 16), 0);
+    prof_stop();
+    prof_reset();
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include "../src/minitest.h"
+#include "../src/replay.h"
+#include "../src/ui_renderer.h"
+#include "../src/timer.h"
+#include "test_util.h"
+
+#define REPLAY_PATH "test_replay.rec"
+
+/* 被录制的界面: 一个计数按钮和一个输入框; variant 非 0 时多一行, 模拟改动后的版本 */
+typedef struct { int clicks; char text[64]; } RpState;
+
+static void rp_frame(mu_Context *ctx, RpState *st, int variant) {
+    char buf[32];
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "rec", mu_rect(0, 0, 40, 12), MU_OPT_NOCLOSE)) {
+        mu_layout_row(ctx, 2, (int[]){ 12, -1 }, 0);
+        if (mu_button(ctx, "click")) st->clicks++;
+        sprintf(buf, "%d", st->clicks);
+        mu_label(ctx, buf);
+        mu_layout_row(ctx, 1, (int[]){ -1 }, 0);
+        mu_textbox(ctx, st->text, sizeof(st->text));
+        if (variant && st->clicks > 1) mu_label(ctx, "changed");
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+static void rp_input(mu_Context *ctx, const TermEvent *e) {
+    if (e->type == TERM_EV_KEY) {
+        if (e->u.key.pressed && e->u.key.utf8[0]) mu_input_text(ctx, e->u.key.utf8);
+    } else if (e->type == TERM_EV_MOUSE) {
+        const TermMouseEvent *m = &e->u.mouse;
+        if (m->type == TERM_MOUSE_MOVE) mu_input_mousemove(ctx, m->x, m->y);
+        if (m->type == TERM_MOUSE_LEFT_DOWN) mu_input_mousedown(ctx, m->x, m->y, MU_MOUSE_LEFT);
+        if (m->type == TERM_MOUSE_LEFT_UP) mu_input_mouseup(ctx, m->x, m->y, MU_MOUSE_LEFT);
+    }
+}
+
+static mu_Context *rp_context(void) {
+    mu_Context *ctx = test_ctx_new(NULL);
+    ctx->text_glyphs = r_text_glyphs;
+    ctx->glyph_size = sizeof(utf8_t);
+    ctx->viewport = mu_rect(0, 0, 40, 12);
+    return ctx;
+}
+
+static TermEvent rp_mouse(TermMouseEventType type, int x, int y) {
+    TermEvent e = { .type = TERM_EV_MOUSE };
+    e.u.mouse.type = type;
+    e.u.mouse.x = x;
+    e.u.mouse.y = y;
+    return e;
+}
+
+/* 在按钮上点三次, 再点进输入框打字; 事件间隔 2ms, 共约 40ms */
+static int rp_script(TermEvent *ev) {
+    int n = 0;
+    for (int i = 0; i < 3; i++) {
+        ev[n++] = rp_mouse(TERM_MOUSE_MOVE, 3, 1);
+        ev[n++] = rp_mouse(TERM_MOUSE_LEFT_DOWN, 3, 1);
+        ev[n++] = rp_mouse(TERM_MOUSE_LEFT_UP, 3, 1);
+    }
+    ev[n++] = rp_mouse(TERM_MOUSE_MOVE, 5, 2);
+    ev[n++] = rp_mouse(TERM_MOUSE_LEFT_DOWN, 5, 2);
+    ev[n++] = rp_mouse(TERM_MOUSE_LEFT_UP, 5, 2);
+    for (const char *s = "hi\xe4\xb8\xad"; *s; ) {
+        TermEvent e = { .type = TERM_EV_KEY };
+        int len = (*s & 0x80) ? 3 : 1;
+        e.u.key.pressed = 1;
+        memcpy(e.u.key.utf8, s, len);
+        ev[n++] = e;
+        e.u.key.pressed = 0;
+        ev[n++] = e;
+        s += len;
+    }
+    return n;
+}
+
+/* 回放整个录制, 返回第一帧不一致的序号, 全部一致返回 -1 */
+static int rp_replay(int mode, int variant, RpState *st, int *events) {
+    replay_t *rp = replay_open(REPLAY_PATH, mode);
+    mu_Context *ctx = rp_context();
+    int frame = 0, diverged = -1;
+    memset(st, 0, sizeof(*st));
+    if (!rp) return -2;
+    rp_frame(ctx, st, variant);
+    if (replay_check_frame(rp, ctx) != 1) diverged = 0;
+    for (;;) {
+        TermEvent e = replay_poll(rp);
+        if (e.type == TERM_EV_NONE) {
+            if (!replay_wait(rp)) break;
+            continue;
+        }
+        rp_input(ctx, &e);
+        rp_frame(ctx, st, variant);
+        frame++;
+        if (replay_check_frame(rp, ctx) != 1 && diverged < 0) diverged = frame;
+    }
+    if (replay_check_frame(rp, ctx) != -1 && diverged < 0) diverged = frame + 1;  /* 录制里不应还有多余的帧 */
+    *events = replay_events(rp);
+    replay_close(rp);
+    test_ctx_free(ctx);
+    return diverged;
+}
+
+TEST(test, replay) {
+    TermEvent ev[32];
+    int n = rp_script(ev);
+    RpState rec = {0}, st;
+    int events;
+
+    /* 录制: 每个事件一帧, 事件带脚本给的时间戳 */
+    recorder_t *r = rec_open(REPLAY_PATH);
+    ASSERT_TRUE(r != NULL);
+    long long t0 = timer_ns();
+    mu_Context *ctx = rp_context();
+    rp_frame(ctx, &rec, 0);
+    rec_frame(r, ctx);
+    for (int i = 0; i < n; i++) {
+        rec_event_at(r, &ev[i], t0 + (i + 1) * 2000000LL);
+        rp_input(ctx, &ev[i]);
+        rp_frame(ctx, &rec, 0);
+        rec_frame(r, ctx);
+    }
+    test_ctx_free(ctx);
+    ASSERT_EQ(rec_close(r), 0);
+    ASSERT_EQ(rec.clicks, 3);
+    ASSERT_STREQ(rec.text, "hi\xe4\xb8\xad");
+
+    /* 尽快回放: 逐帧命令流与录制一致, 最终状态相同, 且不等待真实时间 */
+    long long t = timer_ns();
+    ASSERT_EQ(rp_replay(REPLAY_FAST, 0, &st, &events), -1);
+    ASSERT_TRUE(timer_ns() - t < 20000000LL);
+    ASSERT_EQ(events, n);
+    ASSERT_EQ(st.clicks, rec.clicks);
+    ASSERT_STREQ(st.text, rec.text);
+
+    /* 改过的界面: 从第二次按下按钮的那一帧开始分叉 */
+    ASSERT_EQ(rp_replay(REPLAY_FAST, 1, &st, &events), 5);
+
+    /* 实时回放至少要花掉录制的时长 */
+    t = timer_ns();
+    ASSERT_EQ(rp_replay(REPLAY_REALTIME, 0, &st, &events), -1);
+    ASSERT_TRUE(timer_ns() - t >= n * 2000000LL);
+    ASSERT_EQ(st.clicks, 3);
+
+    /* 不是录制文件 */
+    FILE *fp = fopen(REPLAY_PATH, "wb");
+    fputs("garbage", fp);
+    fclose(fp);
+    ASSERT_TRUE(replay_open(REPLAY_PATH, REPLAY_FAST) == NULL);
+    remove(REPLAY_PATH);
+}
@@ -0,0 +1,243 @@
+#include "../src/minitest.h"
+#include "../src/vt_input.h"
+#include "../src/session.h"
+#include "../src/vt.h"
+
+/* ---------- 输入解码 ---------- */
+typedef struct { TermEvent ev[64]; int n; } VtiLog;
+
+static void vti_log(void *user, const TermEvent *e) {
+    VtiLog *log = (VtiLog *)user;
+    if (log->n < 64) log->ev[log->n++] = *e;
+}
+
+/* 整段喂一次, 再逐字节喂一次(ESC 与下一个字节一起, 否则就是 Esc 键), 结果必须一样 */
+static int vti_both(const char *s, VtiLog *log) {
+    VtiLog split = {0};
+    vti_t v = {0};
+    log->n = 0;
+    vti_feed(&v, s, (int)strlen(s), vti_log, log);
+    memset(&v, 0, sizeof(v));
+    for (int i = 0; s[i]; i++) {
+        int n = s[i] == 0x1b && s[i + 1] ? 2 : 1;
+        vti_feed(&v, s + i, n, vti_log, &split);
+        i += n - 1;
+    }
+    if (split.n != log->n) return 0;
+    for (int i = 0; i < log->n; i++) if (memcmp(&split.ev[i], &log->ev[i], sizeof(TermEvent))) return 0;
+    return 1;
+}
+
+TEST(test, vt_input) {
+    VtiLog log;
+    ASSERT_TRUE(vti_both("a\xe4\xb8\xad\r", &log));
+    ASSERT_EQ(log.n, 6);
+    ASSERT_STREQ(log.ev[0].u.key.utf8, "a");
+    ASSERT_EQ(log.ev[0].u.key.pressed, 1);
+    ASSERT_EQ(log.ev[1].u.key.pressed, 0);
+    ASSERT_STREQ(log.ev[2].u.key.utf8, "\xe4\xb8\xad");
+    ASSERT_EQ(log.ev[4].u.key.key_code, TERM_KEY_RETURN);
+
+    ASSERT_TRUE(vti_both("\x1b[A\x1bOD\x1b[3~\x1b[1;5C\x1b[6~", &log));
+    ASSERT_EQ(log.n, 10);
+    ASSERT_EQ(log.ev[0].u.key.key_code, TERM_KEY_UP);
+    ASSERT_EQ(log.ev[2].u.key.key_code, TERM_KEY_LEFT);
+    ASSERT_EQ(log.ev[4].u.key.key_code, TERM_KEY_DELETE);
+    ASSERT_EQ(log.ev[6].u.key.key_code, TERM_KEY_RIGHT);
+    ASSERT_TRUE(log.ev[6].u.key.left_ctrl_pressed);
+    ASSERT_EQ(log.ev[8].u.key.key_code, TERM_KEY_NEXT);
+
+    /* SGR 鼠标: 按下, 拖动, 松开, 滚轮; 坐标从 0 起 */
+    ASSERT_TRUE(vti_both("\x1b[<0;5;3M\x1b[<32;6;3M\x1b[<0;6;3m\x1b[<65;1;1M", &log));
+    ASSERT_EQ(log.n, 4);
+    ASSERT_EQ(log.ev[0].u.mouse.type, TERM_MOUSE_LEFT_DOWN);
+    ASSERT_EQ(log.ev[0].u.mouse.x, 4);
+    ASSERT_EQ(log.ev[0].u.mouse.y, 2);
+    ASSERT_EQ(log.ev[1].u.mouse.type, TERM_MOUSE_MOVE);
+    ASSERT_EQ(log.ev[1].u.mouse.btn, 1);
+    ASSERT_EQ(log.ev[2].u.mouse.type, TERM_MOUSE_LEFT_UP);
+    ASSERT_EQ(log.ev[3].u.mouse.type, TERM_MOUSE_WHEEL);
+    ASSERT_EQ(log.ev[3].u.mouse.wheel, -1);
+
+    /* 尺寸报告, Alt 前缀, 不认识的序列被吞掉, 末尾单独的 ESC 是 Esc 键 */
+    ASSERT_TRUE(vti_both("\x1b[8;30;100t\x1bx\x1b[?1;2c\x03", &log));
+    ASSERT_EQ(log.n, 5);
+    ASSERT_EQ(log.ev[0].type, TERM_EV_RESIZE);
+    ASSERT_EQ(log.ev[0].u.size.cols, 100);
+    ASSERT_EQ(log.ev[0].u.size.rows, 30);
+    ASSERT_STREQ(log.ev[1].u.key.utf8, "x");
+    ASSERT_TRUE(log.ev[1].u.key.left_alt_pressed);
+    ASSERT_EQ(log.ev[3].u.key.key_code, 'C');
+    ASSERT_TRUE(log.ev[3].u.key.left_ctrl_pressed);
+    vti_t v = {0};
+    log.n = 0;
+    vti_feed(&v, "\x1b", 1, vti_log, &log);
+    ASSERT_EQ(log.n, 2);
+    ASSERT_EQ(log.ev[0].u.key.key_code, TERM_KEY_ESCAPE);
+}
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/* ---------- 多会话 ---------- */
+#define SS_SESSIONS 40
+
+typedef struct {
+    int     fd;         /* 客户端一侧 */
+    vt_t   *vt;
+    int     clicks;
+    int     frames;     /* 跑过的帧数 */
+    int     quit;
+} SsClient;
+
+static int ss_frame(session_t *s, mu_Context *ctx) {
+    SsClient *c = (SsClient *)session_user(s);
+    char buf[32];
+    c->frames++;
+    if (mu_begin_window_ex(ctx, "S", mu_rect(0, 0, 30, 8), MU_OPT_NOCLOSE | MU_OPT_NOTITLE)) {
+        mu_layout_row(ctx, 1, (int[]){ -1 }, 0);
+        if (mu_button(ctx, "click")) c->clicks++;
+        sprintf(buf, "clicks %d", c->clicks);
+        mu_label(ctx, buf);
+        mu_end_window(ctx);
+    }
+    return !c->quit;
+}
+
+/* 把客户端收到的输出全部喂给它的模拟终端, 返回字节数 */
+static int ss_read(SsClient *c) {
+    char buf[8192];
+    int total = 0, n;
+    while ((n = (int)read(c->fd, buf, sizeof(buf))) > 0) {
+        vt_feed(c->vt, buf, n);
+        total += n;
+    }
+    return total;
+}
+
+static int ss_find(SsClient *c, const char *text, int *x, int *y) {
+    char row[512];
+    for (int j = 0; j < c->vt->screen->h; j++) {
+        vt_row_text(c->vt, j, row, sizeof(row));
+        const char *p = strstr(row, text);
+        if (p) { *x = (int)(p - row); *y = j; return 1; }
+    }
+    return 0;
+}
+
+static void ss_send(SsClient *c, const char *s) {
+    ASSERT_EQ((int)write(c->fd, s, strlen(s)), (int)strlen(s));
+}
+
+TEST(test, session) {
+    static SsClient cl[SS_SESSIONS];
+    server_t *sv = server_new(3, ss_frame);
+    ASSERT_TRUE(sv != NULL);
+    for (int i = 0; i < SS_SESSIONS; i++) {
+        int sp[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sp), 0);
+        cl[i] = (SsClient){ .fd = sp[0], .vt = vt_new(40, 12) };
+        fcntl(sp[0], F_SETFL, fcntl(sp[0], F_GETFL) | O_NONBLOCK);
+        session_t *s = server_open(sv, sp[1], 40, 12);
+        ASSERT_TRUE(s != NULL);
+        session_set_user(s, &cl[i]);
+    }
+    ASSERT_EQ(server_count(sv), SS_SESSIONS);
+
+    /* 新会话都待定, 不等输入就各自画出第一帧 */
+    ASSERT_EQ(server_step(sv, 1000), SS_SESSIONS);
+    int x, y;
+    for (int i = 0; i < SS_SESSIONS; i++) {
+        ASSERT_TRUE(ss_read(&cl[i]) > 0);
+        ASSERT_TRUE(ss_find(&cl[i], "clicks 0", &x, &y));
+    }
+    /* 头几帧的待定状态消化完之后, 没有输入就不推进任何会话 */
+    for (int k = 0; k < 4 && server_step(sv, 0) > 0; k++) {}
+    ASSERT_EQ(server_step(sv, 0), 0);
+    for (int i = 0; i < SS_SESSIONS; i++) ss_read(&cl[i]);
+
+    /* 只点第 7 个会话的按钮, 其他会话收不到任何输出 */
+    ASSERT_TRUE(ss_find(&cl[7], "click", &x, &y));
+    char seq[128];
+    snprintf(seq, sizeof(seq), "\x1b[<35;%d;%dM\x1b[<0;%d;%dM\x1b[<0;%d;%dm", x + 2, y + 1, x + 2, y + 1, x + 2, y + 1);
+    ss_send(&cl[7], seq);
+    for (int k = 0; k < 4 && server_step(sv, 100) > 0; k++) {}
+    ASSERT_EQ(cl[7].clicks, 1);
+    ASSERT_EQ(ss_read(&cl[7]) > 0, 1);
+    ASSERT_TRUE(ss_find(&cl[7], "clicks 1", &x, &y));
+    for (int i = 0; i < SS_SESSIONS; i++) {
+        if (i == 7) continue;
+        ASSERT_EQ(cl[i].clicks, 0);
+        ASSERT_EQ(ss_read(&cl[i]), 0);
+    }
+
+    /* 一次读到的一串移动合成一帧; 同一位置连点两下则分成两帧, 两次都算 */
+    int frames = cl[7].frames;
+    seq[0] = '\0';
+    for (int i = 0; i < 8; i++) snprintf(seq + strlen(seq), sizeof(seq) - strlen(seq), "\x1b[<35;%d;%dM", 10 + i, 7);
+    ss_send(&cl[7], seq);
+    server_step(sv, 100);
+    ASSERT_EQ(cl[7].frames, frames + 1);
+    for (int k = 0; k < 4 && server_step(sv, 0) > 0; k++) {}
+    ASSERT_TRUE(ss_find(&cl[7], "click", &x, &y));
+    snprintf(seq, sizeof(seq), "\x1b[<0;%d;%dM\x1b[<0;%d;%dm\x1b[<0;%d;%dM\x1b[<0;%d;%dm",
+             x + 2, y + 1, x + 2, y + 1, x + 2, y + 1, x + 2, y + 1);
+    ss_send(&cl[7], seq);
+    for (int k = 0; k < 4 && server_step(sv, 100) > 0; k++) {}
+    ASSERT_EQ(cl[7].clicks, 3);
+    ss_read(&cl[7]);
+
+    /* 客户端报告新尺寸: 整屏按新尺寸重画 */
+    vt_free(cl[3].vt);
+    cl[3].vt = vt_new(60, 20);
+    ss_send(&cl[3], "\x1b[8;20;60t");
+    server_step(sv, 100);
+    ASSERT_TRUE(ss_read(&cl[3]) > 0);
+    ASSERT_TRUE(ss_find(&cl[3], "clicks 0", &x, &y));
+    int cols, rows;
+    session_size(server_session(sv, 3), &cols, &rows);
+    ASSERT_EQ(cols, 60);
+    ASSERT_EQ(rows, 20);
+
+    /* 客户端断开, 或界面要求退出: 会话被关掉 */
+    close(cl[0].fd);
+    cl[5].quit = 1;
+    ss_send(&cl[5], "\x1b[<0;35;10M\x1b[<0;35;10m");
+    server_step(sv, 100);
+    ASSERT_EQ(server_count(sv), SS_SESSIONS - 2);
+
+    server_free(sv);
+    for (int i = 0; i < SS_SESSIONS; i++) {
+        if (i) close(cl[i].fd);
+        vt_free(cl[i].vt);
+    }
+}
+
+/* 500 个会话, 每轮其中一个收到鼠标移动 */
+BENCH(bench, server_step) {
+    static server_t *sv;
+    static SsClient cl[500];
+    static int turn;
+    if (!sv) {
+        sv = server_new(1, ss_frame);
+        for (int i = 0; i < 500; i++) {
+            int sp[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sp)) return;
+            cl[i] = (SsClient){ .fd = sp[0], .vt = vt_new(80, 24) };
+            fcntl(sp[0], F_SETFL, fcntl(sp[0], F_GETFL) | O_NONBLOCK);
+            session_set_user(server_open(sv, sp[1], 80, 24), &cl[i]);
+        }
+        server_step(sv, 0);
+        for (int i = 0; i < 500; i++) ss_read(&cl[i]);
+    }
+    SsClient *c = &cl[turn++ % 500];
+    char seq[32];
+    sprintf(seq, "\x1b[<35;%d;%dM", 2 + turn % 20, 2 + turn % 6);
+    ss_send(c, seq);
+    server_step(sv, 0);
+    ss_read(c);
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "../src/minitest.h"
+#include "../src/stats.h"
+#include "../src/ui_renderer.h"
+#include "test_util.h"
+
+TEST(test, stats) {
+    mu_Context *ctx = test_ctx_new(NULL);
+#ifdef TERM_HEADLESS
+    term_headless_resize(60, 20);
+    ui_renderer_t *ur = ur_new_term();
+#endif
+
+    stats_enable(1);
+    for (int frame = 0; frame < 4; frame++) {
+        mu_begin(ctx);
+        if (mu_begin_window(ctx, "win", mu_rect(0, 0, 30, 6))) {
+            mu_label(ctx, "hello");
+            mu_end_window(ctx);
+        }
+        stats_window(ctx);
+        mu_end(ctx);
+#ifdef TERM_HEADLESS
+        ur_clear(ur, mu_color(0, 0, 0, 0));
+        ur_draw_commands(ur, ctx);
+        ur_present(ur);
+#endif
+    }
+    mu_begin(ctx);      /* 提交最后一帧 */
+
+    const FrameStats *fs = stats_last();
+    ASSERT_TRUE(fs != NULL);
+    ASSERT_TRUE(fs->commands[MU_COMMAND_TEXT] > 0);
+    ASSERT_TRUE(fs->commands[MU_COMMAND_RECT] > 0);
+    ASSERT_TRUE(fs->command_bytes > 0 && fs->command_bytes < MU_COMMANDLIST_SIZE);
+#ifdef TERM_HEADLESS
+    ASSERT_TRUE(fs->cells_written >= 60 * 20);
+    ASSERT_EQ(fs->writes, 1);
+#endif
+
+    StatSummary s = stats_summary(STATS_FIELD(command_bytes));
+    ASSERT_TRUE(s.min <= s.avg && s.avg <= s.p99);
+
+    /* 关闭后计数不再变化 */
+    stats_enable(0);
+    FrameStats h[STATS_HISTORY];
+    int n = stats_history(h, STATS_HISTORY);
+    mu_end(ctx);
+    mu_begin(ctx);
+    ASSERT_EQ(stats_history(h, STATS_HISTORY), n);
+    mu_end(ctx);
+
+#ifdef TERM_HEADLESS
+    ur_free(ur);
+    term_shutdown();
+#endif
+    test_ctx_free(ctx);
+}
@@ -0,0 +1,88 @@
+#include "../src/minitest.h"
+#include "../src/table_view.h"
+#include "test_util.h"
+#include <stdio.h>
+
+static int g_cells;
+
+static const char *tv_test_cell(void *user, int row, int col, char *buf, int cap) {
+    (void)user;
+    g_cells++;
+    snprintf(buf, cap, "r%dc%d", row, col);
+    return buf;
+}
+
+static void tv_frame(mu_Context *ctx, table_view_t *tv, int rows) {
+    g_cells = 0;
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "table", mu_rect(0, 0, 60, 20), MU_OPT_NOCLOSE)) {
+        tv_draw(ctx, "grid", tv, rows, tv_test_cell, NULL);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+}
+
+/* 坐标 (x, y) 处开始的文本命令, 没有返回 NULL */
+static const char *tv_text_at(mu_Context *ctx, int x, int y) {
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) {
+        if (cmd->type == MU_COMMAND_TEXT && cmd->text.pos.x == x && cmd->text.pos.y == y) return cmd->text.str;
+    }
+    return NULL;
+}
+
+TEST(test, table_view) {
+    mu_Context *ctx = test_ctx_new_ex(NULL, test_byte_width);
+    table_view_t *tv = tv_new(50, 12);
+    char title[50][8];
+    for (int c = 0; c < 50; c++) {
+        sprintf(title[c], "col %d", c);
+        tv_set_column(tv, c, title[c], 12);
+    }
+
+    /* 100 万行 x 50 列: 只为可见格取数据; 表头在第 1 行, 表体从第 2 行开始 */
+    tv_frame(ctx, tv, 1000000);
+    tv_frame(ctx, tv, 1000000);
+    ASSERT_TRUE(g_cells <= 18 * 5);
+    ASSERT_STREQ(tv_text_at(ctx, 0, 1), "col 0");
+    ASSERT_STREQ(tv_text_at(ctx, 0, 2), "r0c0");
+    ASSERT_STREQ(tv_text_at(ctx, 12, 3), "r1c1");
+
+    /* 跳转后表头跟着横向滚动, 纵向不动 */
+    tv_scroll_to(tv, 500000, 25);
+    tv_frame(ctx, tv, 1000000);
+    tv_frame(ctx, tv, 1000000);
+    ASSERT_TRUE(g_cells <= 18 * 5);
+    ASSERT_STREQ(tv_text_at(ctx, 0, 1), "col 25");
+    ASSERT_STREQ(tv_text_at(ctx, 0, 2), "r500000c25");
+
+    /* 拖动第 25 列右边的分隔格加宽 5 格 */
+    mu_input_mousemove(ctx, 11, 1);
+    tv_frame(ctx, tv, 1000000);
+    mu_input_mousedown(ctx, 11, 1, MU_MOUSE_LEFT);
+    tv_frame(ctx, tv, 1000000);
+    mu_input_mousemove(ctx, 16, 1);
+    tv_frame(ctx, tv, 1000000);
+    mu_input_mouseup(ctx, 16, 1, MU_MOUSE_LEFT);
+    tv_frame(ctx, tv, 1000000);
+    ASSERT_EQ(tv_width(tv, 25), 17);
+    ASSERT_EQ(tv_width(tv, 24), 12);
+    ASSERT_STREQ(tv_text_at(ctx, 17, 1), "col 26");
+    ASSERT_STREQ(tv_text_at(ctx, 17, 2), "r500000c26");
+
+    tv_free(tv);
+    test_ctx_free(ctx);
+}
+
+BENCH(bench, tv_scroll) {
+    static table_view_t *tv;
+    static mu_Context *ctx;
+    static int n;
+    if (!tv) {
+        tv = tv_new(50, 12);
+        ctx = test_ctx_new_ex(NULL, test_byte_width);
+    }
+    n++;
+    tv_scroll_to(tv, n * 7919 % 1000000, n % 50);
+    tv_frame(ctx, tv, 1000000);
+}
@@ -0,0 +1,175 @@
+#include "../src/minitest.h"
+#include "../src/text_edit.h"
+#include "test_util.h"
+#include <stdio.h>
+
+static unsigned te_rand(void) {
+    static unsigned s = 12345;
+    s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+    return s;
+}
+
+/* 整个文档与参照字符串一致, 且每行起点、每个位置的行号都对得上 */
+static int te_same(text_edit_t *te, const char *want, int len) {
+    static char buf[1 << 16];
+    if (te_length(te) != len || te_read(te, 0, buf, len) != len || memcmp(buf, want, len)) return 0;
+    int line = 0;
+    for (int i = 0; i <= len; i++) {
+        if (te_line_of(te, i) != line) return 0;
+        if ((i == 0 || want[i - 1] == '\n') && te_line_start(te, line) != i) return 0;
+        if (i < len && want[i] == '\n') line++;
+    }
+    return te_lines(te) == line + 1;
+}
+
+static int g_texts;
+
+static void te_frame(mu_Context *ctx, text_edit_t *te) {
+    mu_begin(ctx);
+    if (mu_begin_window_ex(ctx, "edit", mu_rect(0, 0, 40, 12), MU_OPT_NOCLOSE)) {
+        te_draw(ctx, te);
+        mu_end_window(ctx);
+    }
+    mu_end(ctx);
+    g_texts = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd)) g_texts += cmd->type == MU_COMMAND_TEXT && strcmp(cmd->text.str, "edit");
+}
+
+static void te_key(mu_Context *ctx, text_edit_t *te, int key) {
+    mu_input_keydown(ctx, key);
+    te_frame(ctx, te);
+    mu_input_keyup(ctx, key);
+}
+
+TEST(test, text_edit) {
+    /* 随机插入删除, 与朴素字符串对照 */
+    static char ref[1 << 16];
+    int len = 0;
+    text_edit_t *te = te_new();
+    ASSERT_TRUE(te_same(te, ref, 0));
+    for (int i = 0; i < 2000; i++) {
+        int pos = len ? te_rand() % (len + 1) : 0;
+        if (te_rand() % 3 || len < 10) {
+            const char *s[] = { "a", "bc\n", "\n", "def", "x\ny\nz" };
+            const char *t = s[te_rand() % 5];
+            int n = (int)strlen(t);
+            if (len + n >= (int)sizeof(ref)) continue;
+            ASSERT_EQ(te_insert(te, pos, t, n), 0);
+            memmove(ref + pos + n, ref + pos, len - pos);
+            memcpy(ref + pos, t, n);
+            len += n;
+        } else {
+            int n = (int)(te_rand() % 8);
+            n = mu_min(n, len - pos);
+            ASSERT_EQ(te_delete(te, pos, n), 0);
+            memmove(ref + pos, ref + pos + n, len - pos - n);
+            len -= n;
+        }
+        if (i % 97 == 0) ASSERT_TRUE(te_same(te, ref, len));
+    }
+    ASSERT_TRUE(te_same(te, ref, len));
+    ASSERT_EQ(te_insert(te, len + 1, "a", 1), -1);
+    te_free(te);
+
+    /* 打开文件, 在中间编辑, 存回去 */
+    const char *path = "test_text_edit.tmp";
+    char buf[64];
+    FILE *fp = fopen(path, "wb");
+    ASSERT_TRUE(fp != NULL);
+    for (int i = 0; i < 100000; i++) fprintf(fp, "line %d\r\n", i);
+    fclose(fp);
+    te = te_open(path);
+    ASSERT_TRUE(te != NULL);
+    ASSERT_TRUE(te_open("no/such/file") == NULL);
+    ASSERT_EQ(te_lines(te), 100001);
+    ASSERT_EQ(te_line(te, 54321, buf, sizeof(buf)), 10);
+    ASSERT_STREQ(buf, "line 54321");
+    int p = te_line_start(te, 50000) + 5;
+    ASSERT_EQ(te_insert(te, p, "new\n", 4), 0);
+    ASSERT_EQ(te_delete(te, te_line_start(te, 10), te_line_start(te, 20) - te_line_start(te, 10)), 0);
+    te_line(te, 49990, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "line new");
+    te_line(te, 49991, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "50000");
+    te_line(te, 10, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "line 20");
+    ASSERT_EQ(te_save(te, path), 0);
+    text_edit_t *te2 = te_open(path);
+    ASSERT_TRUE(te2 != NULL);
+    ASSERT_EQ(te_length(te2), te_length(te));
+    te_line(te2, 49990, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "line new");
+    te_free(te2);
+    remove(path);
+
+    /* 控件: 只画可见行, 点击定位光标, 按键编辑和移动 */
+    mu_Context *ctx = test_ctx_new_ex(NULL, test_byte_width);
+    te_frame(ctx, te);
+    ASSERT_TRUE(g_texts <= 11 + 2);
+    mu_input_mousemove(ctx, 3, 2);
+    te_frame(ctx, te);
+    mu_input_mousedown(ctx, 3, 2, MU_MOUSE_LEFT);
+    te_frame(ctx, te);
+    mu_input_mouseup(ctx, 3, 2, MU_MOUSE_LEFT);
+    te_frame(ctx, te);
+    ASSERT_EQ(te_cursor(te), te_line_start(te, 1) + 3);
+
+    mu_input_text(ctx, "XY");
+    te_frame(ctx, te);
+    te_key(ctx, te, MU_KEY_BACKSPACE);
+    te_line(te, 1, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "linXe 1");
+    te_key(ctx, te, MU_KEY_END);
+    te_key(ctx, te, MU_KEY_DOWN);       /* 第 2 行同样长, 停在行尾 */
+    ASSERT_EQ(te_cursor(te), te_line_start(te, 2) + 6);
+    te_key(ctx, te, MU_KEY_DELETE);     /* 删掉 '\r' */
+    te_key(ctx, te, MU_KEY_HOME);
+    te_key(ctx, te, MU_KEY_RETURN);
+    ASSERT_EQ(te_line_of(te, te_cursor(te)), 3);
+    te_line(te, 3, buf, sizeof(buf));
+    ASSERT_STREQ(buf, "line 2");
+
+    /* 翻页到很远处时光标跟随, 画出来的仍只有可见行 */
+    for (int i = 0; i < 100; i++) te_key(ctx, te, MU_KEY_PAGEDOWN);
+    te_frame(ctx, te);
+    int line = te_line_of(te, te_cursor(te));
+    ASSERT_TRUE(line > 500);
+    ASSERT_TRUE(g_texts <= 11 + 2);
+    mu_Container *cnt = mu_get_container(ctx, "edit");
+    ASSERT_TRUE(cnt->scroll.y <= line && line < cnt->scroll.y + cnt->body.h);
+
+    /* 比 TE_LINE_MAX 长的行: END 仍到行尾, 不会停在多字节字符中间 */
+    static char wide[2 * TE_LINE_MAX + 2];
+    for (int i = 0; i < TE_LINE_MAX; i++) memcpy(wide + 2 * i, "\xc3\xa9", 2);
+    strcpy(wide + 2 * TE_LINE_MAX, "\n");
+    ASSERT_EQ(te_insert(te, 0, wide, -1), 0);
+    te_set_cursor(te, 1);
+    te_key(ctx, te, MU_KEY_END);
+    ASSERT_EQ(te_cursor(te), 2 * TE_LINE_MAX);
+
+    te_free(te);
+    test_ctx_free(ctx);
+}
+
+/* 50MB 文档里随机位置插入删除 */
+BENCH(bench, te_edit) {
+    static text_edit_t *te;
+    if (!te) {
+        static char line[64];
+        te = te_new();
+        char *big = malloc(50 << 20);
+        int n = 0;
+        while (n + 64 < (50 << 20)) {
+            int k = sprintf(line, "key_%d = value %d\n", n, n * 7);
+            memcpy(big + n, line, k);
+            n += k;
+        }
+        te_insert(te, 0, big, n);
+        free(big);
+    }
+    int pos = te_rand() % te_length(te);
+    if (te_rand() & 1) te_insert(te, pos, "x", 1);
+    else te_delete(te, pos, 1);
+    te_line_start(te, te_line_of(te, pos));
+}
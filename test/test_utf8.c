@@ -1,27 +1,37 @@
-#include "../src/minitest.h"
-#include "../src/utf8.h"
-
-#include <windows.h>
-
-TEST(test, utf8) {
-    SetConsoleOutputCP(65001);
-
-    const char *s   = "Hello 世界 🌍▲▼█🚀◼↩↵→☑☐⯆⯈ｘ";
-    utf8_t          buf[256];
-    int n = str_to_utf8(s, buf, 256);
-    if (n < 0) {
-        puts("invalid UTF-8");
-        return ;
-    }
-    for (int i = 0; i < n; ++i) {
-        char tmp[5] = {0};            
-        for (int j = 0; j < buf[i].len; ++j)
-            tmp[j] = buf[i].bytes[j];
-
-        printf("char %d: len=%u width=%u  ", i, buf[i].len, buf[i].width);
-        for (int j = 0; j < buf[i].len; ++j)
-            printf("%02x ", (unsigned char)buf[i].bytes[j]);
-        printf(" %s\n", tmp);      
-    }
-    printf("%s\n", s);
-}
+#include "../src/minitest.h"
+#include "../src/utf8.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+TEST(test, utf8) {
+#ifdef _WIN32
+    SetConsoleOutputCP(65001);
+#endif
+
+    const char *s   = "Hello 世界 🌍▲▼█🚀◼↩↵→☑☐⯆⯈ｘ";
+    utf8_t          buf[256];
+    int n = str_to_utf8(s, buf, 256);
+    if (n < 0) {
+        puts("invalid UTF-8");
+        return ;
+    }
+    for (int i = 0; i < n; ++i) {
+        char tmp[5] = {0};            
+        for (int j = 0; j < buf[i].len; ++j)
+            tmp[j] = buf[i].bytes[j];
+
+        printf("char %d: len=%u width=%u  ", i, buf[i].len, buf[i].width);
+        for (int j = 0; j < buf[i].len; ++j)
+            printf("%02x ", (unsigned char)buf[i].bytes[j]);
+        printf(" %s\n", tmp);      
+    }
+    printf("%s\n", s);
+}
+
+BENCH(bench, str_to_utf8) {
+    static const char *s = "status: ok 世界 🌍 ▲▼█ 0123456789 abcdefghijklmnopqrstuvwxyz";
+    utf8_t buf[128];
+    BENCH_KEEP(str_to_utf8(s, buf, 128));
+}
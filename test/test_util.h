@@ -0,0 +1,35 @@
+#ifndef __TEST_UTIL_H__
+#define __TEST_UTIL_H__
+
+#include "../src/microui.h"
+#include "../src/ui_renderer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* 各测试共用的夹具. 文本测量有两种: 按终端格宽(ui_renderer 的 r_text_width, 中文占两格),
+ * 或按字节数(控件测试用, 宽度与字节偏移一一对应); 都是每行一格高 */
+static inline int test_byte_width(mu_Font font, const char *text, int len) {
+    (void)font;
+    return len < 0 ? (int)strlen(text) : len;
+}
+
+/* 分配并初始化一个装好测量回调的上下文; config 为 NULL 时取默认配置. 用 test_ctx_free 释放 */
+static inline mu_Context *test_ctx_new_ex(const mu_Config *config, int (*text_width)(mu_Font, const char *, int)) {
+    mu_Context *ctx = (mu_Context *)malloc(sizeof(mu_Context));
+    if (!ctx) return NULL;
+    mu_init_ex(ctx, config);
+    ctx->text_width = text_width;
+    ctx->text_height = r_text_height;
+    return ctx;
+}
+
+static inline mu_Context *test_ctx_new(const mu_Config *config) {
+    return test_ctx_new_ex(config, r_text_width);
+}
+
+static inline void test_ctx_free(mu_Context *ctx) {
+    mu_release(ctx);
+    free(ctx);
+}
+
+#endif /* __TEST_UTIL_H__ */
@@ -0,0 +1,62 @@
+#include "../src/minitest.h"
+#include "../src/vt.h"
+
+static const char *vt_row(vt_t *vt, int y) {
+    static char buf[256];
+    vt_row_text(vt, y, buf, sizeof(buf));
+    return buf;
+}
+
+static void vt_puts(vt_t *vt, const char *s) { vt_feed(vt, s, strlen(s)); }
+
+TEST(test, vt) {
+    vt_t *vt = vt_new(10, 4);
+
+    /* CUP + SGR */
+    vt_puts(vt, "\x1b[2;3Hab\x1b[1;38;2;1;2;3mc\x1b[0m");
+    ASSERT_STREQ(vt_row(vt, 1), "  abc     ");
+    ASSERT_EQ(vt_style_at(vt, 4, 1).fg, 0x010203);
+    ASSERT_EQ(vt_style_at(vt, 4, 1).bold, 1);
+    ASSERT_EQ(vt_style_at(vt, 3, 1).fg, -1);
+
+    /* REP / ECH / EL */
+    vt_puts(vt, "\x1b[1;1Hx\x1b[3b");
+    ASSERT_STREQ(vt_row(vt, 0), "xxxx      ");
+    vt_puts(vt, "\x1b[1;2H\x1b[2X");
+    ASSERT_STREQ(vt_row(vt, 0), "x  x      ");
+    vt_puts(vt, "\x1b[2;4H\x1b[K");
+    ASSERT_STREQ(vt_row(vt, 1), "  a       ");
+
+    /* ICH / DCH */
+    vt_puts(vt, "\x1b[3;1Habcdef\x1b[3;3H\x1b[2@");
+    ASSERT_STREQ(vt_row(vt, 2), "ab  cdef  ");
+    vt_puts(vt, "\x1b[3;2H\x1b[3P");
+    ASSERT_STREQ(vt_row(vt, 2), "acdef     ");
+
+    /* 背景色擦除(BCE) */
+    vt_puts(vt, "\x1b[48;2;0;0;255m\x1b[4;1H\x1b[2K\x1b[0m");
+    ASSERT_EQ(vt_style_at(vt, 9, 3).bg, 0x0000FF);
+
+    /* 滚动区域: 只滚动第 2..3 行 */
+    vt_puts(vt, "\x1b[2J\x1b[1;1H1\x1b[2;1H2\x1b[3;1H3\x1b[4;1H4");
+    vt_puts(vt, "\x1b[2;3r\x1b[3;1H\n");
+    ASSERT_STREQ(vt_row(vt, 0), "1         ");
+    ASSERT_STREQ(vt_row(vt, 1), "3         ");
+    ASSERT_STREQ(vt_row(vt, 2), "          ");
+    ASSERT_STREQ(vt_row(vt, 3), "4         ");
+    vt_puts(vt, "\x1b[r");
+
+    /* 宽字符与自动换行 */
+    vt_puts(vt, "\x1b[2J\x1b[1;9H中文");
+    ASSERT_STREQ(vt_row(vt, 0), "        中");
+    ASSERT_STREQ(vt_row(vt, 1), "文        ");
+
+    /* DEC 2026 同步输出 */
+    vt_puts(vt, "\x1b[?2026h");
+    ASSERT_EQ(vt->sync, 1);
+    vt_puts(vt, "\x1b[?2026l");
+    ASSERT_EQ(vt->sync, 0);
+    ASSERT_EQ(vt->sync_frames, 1);
+
+    vt_free(vt);
+}
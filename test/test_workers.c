@@ -0,0 +1,35 @@
+#include "../src/minitest.h"
+#include "../src/workers.h"
+#include "../src/thread.h"
+
+#define WK_TEST_COUNT 1000
+
+typedef struct { volatile atom_t hits[WK_TEST_COUNT]; volatile atom_t sum; } WkTest;
+
+static void wk_visit(void *user, int i) {
+    WkTest *t = (WkTest *)user;
+    atom_add(&t->hits[i], 1);
+    atom_add(&t->sum, (atom_t)i);
+}
+
+TEST(test, workers) {
+    static WkTest t;
+    /* 每个下标恰好执行一次, 反复多轮, 数量有多有少 */
+    for (int threads = 1; threads <= 4; threads += 3) {
+        workers_t *w = workers_new(threads);
+        ASSERT_TRUE(w != NULL);
+        ASSERT_EQ(workers_count(w), threads);
+        for (int round = 0; round < 200; round++) {
+            int count = round % 7 == 0 ? 1 : round * 13 % WK_TEST_COUNT;
+            memset((void *)&t, 0, sizeof(t));
+            workers_run(w, count, wk_visit, &t);
+            for (int i = 0; i < WK_TEST_COUNT; i++) ASSERT_EQ(atom_load(&t.hits[i]), (atom_t)(i < count));
+            ASSERT_EQ(atom_load(&t.sum), (atom_t)count * (count - 1) / 2);
+        }
+        workers_free(w);
+    }
+    /* 没有线程池时就地串行执行 */
+    memset((void *)&t, 0, sizeof(t));
+    workers_run(NULL, 10, wk_visit, &t);
+    ASSERT_EQ(atom_load(&t.sum), 45);
+}
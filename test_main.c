@@ -1,9 +1,9 @@
 #include "src/minitest.h"
 #include "src/backtrace.h"
 
-int main() {
+int main(int argc, char **argv) {
     BT_INSTALL();
 
-    RUN_ALL_TESTS();
+    RUN_TESTS(argc, argv);
     return 0;
-}
\ No newline at end of file
+}